@@ -1,7 +1,7 @@
 in vec2 Position;
+in vec2 BallCenter;
+in float BallRadiusSquared;
 
-uniform vec2 ballCenter;
-uniform float ballRadiusSquared;
 uniform vec4 color;
 
 out vec4 outColor;
@@ -10,14 +10,14 @@ void main()
 {
     const float aaLevel = 0.0001;
 
-    vec2 distVec = Position - ballCenter;
+    vec2 distVec = Position - BallCenter;
     float distSquared = dot(distVec, distVec);
 
-    if (distSquared > ballRadiusSquared)
+    if (distSquared > BallRadiusSquared)
         discard;
 
-    float alpha = 1.0 - smoothstep(ballRadiusSquared - aaLevel,
-        ballRadiusSquared, distSquared);
+    float alpha = 1.0 - smoothstep(BallRadiusSquared - aaLevel,
+        BallRadiusSquared, distSquared);
 
     outColor = vec4(color.rgb, alpha * color.a);
 }
@@ -1,9 +1,17 @@
-layout (location = 0) in vec4 inPosition;
+layout (location = 0) in vec2 inCorner;
+layout (location = 1) in vec2 inCenter;
+layout (location = 2) in float inRadius;
 
 out vec2 Position;
+out vec2 BallCenter;
+out float BallRadiusSquared;
 
 void main()
 {
-    gl_Position = normalizeVertexPosition(inPosition);
+    gl_Position = normalizeVertexPosition(vec4(inCenter + inCorner * inRadius, 0.0, 1.0));
     Position = vec2(gl_Position);
+    BallCenter = normalizeVertexPosition(inCenter);
+
+    float radius = inRadius / float(COORDINATE_SPACE) * 2.0;
+    BallRadiusSquared = radius * radius;
 }
@@ -0,0 +1,315 @@
+/// @file ball_soa.h
+/// @brief Balls stored as a structure of arrays, so that the ones which can't hit anything can be moved four at
+/// a time with SSE.
+
+#pragma once
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "entities.h"
+#include "vec.h"
+#include "vector.h"
+
+/// @brief Maximum number of balls which can be moved in a single call to ballSoAMoveClear.
+#define MAX_BALLS_PER_MOVE_MASK 32
+
+/// @brief Growable list of balls with every field kept in a separate array.
+typedef struct BallSoA
+{
+    Vector positionX; // float
+    Vector positionY; // float
+    Vector directionX; // float
+    Vector directionY; // float
+    Vector speed; // float
+    Vector radius; // float
+    // positions before the last simulation tick, kept here so that they stay with their balls when some of
+    // them are erased
+    Vector previousPositionX; // float
+    Vector previousPositionY; // float
+} BallSoA;
+
+static inline BallSoA ballSoACreate()
+{
+    return (BallSoA) {
+        .positionX = vectorCreate(),
+        .positionY = vectorCreate(),
+        .directionX = vectorCreate(),
+        .directionY = vectorCreate(),
+        .speed = vectorCreate(),
+        .radius = vectorCreate(),
+        .previousPositionX = vectorCreate(),
+        .previousPositionY = vectorCreate(),
+    };
+}
+
+static inline size_t ballSoASize(const BallSoA* balls)
+{
+    return vectorSize(&balls->positionX, sizeof(float));
+}
+
+static inline float ballSoAGetFloat(const Vector* field, size_t index)
+{
+    return *(const float*)vectorGet(field, index, sizeof(float));
+}
+
+static inline void ballSoASetFloat(Vector* field, size_t index, float value)
+{
+    *(float*)vectorGet(field, index, sizeof(float)) = value;
+}
+
+static inline Ball ballSoAGet(const BallSoA* balls, size_t index)
+{
+    return (Ball) {
+        .position = {
+            .x = ballSoAGetFloat(&balls->positionX, index),
+            .y = ballSoAGetFloat(&balls->positionY, index),
+        },
+        .radius = ballSoAGetFloat(&balls->radius, index),
+        .direction = {
+            .x = ballSoAGetFloat(&balls->directionX, index),
+            .y = ballSoAGetFloat(&balls->directionY, index),
+        },
+        .speed = ballSoAGetFloat(&balls->speed, index),
+    };
+}
+
+/// @brief Overwrites a ball, apart from its previous position.
+/// @param balls Pointer to the balls.
+/// @param index Index of the ball.
+/// @param ball Pointer to the new state of the ball.
+static inline void ballSoASet(BallSoA* balls, size_t index, const Ball* ball)
+{
+    ballSoASetFloat(&balls->positionX, index, ball->position.x);
+    ballSoASetFloat(&balls->positionY, index, ball->position.y);
+    ballSoASetFloat(&balls->directionX, index, ball->direction.x);
+    ballSoASetFloat(&balls->directionY, index, ball->direction.y);
+    ballSoASetFloat(&balls->speed, index, ball->speed);
+    ballSoASetFloat(&balls->radius, index, ball->radius);
+}
+
+/// @brief Returns the position of a ball before the last simulation tick.
+/// @param balls Pointer to the balls.
+/// @param index Index of the ball.
+/// @return Previous position of the ball.
+static inline Vec2 ballSoAGetPreviousPosition(const BallSoA* balls, size_t index)
+{
+    return (Vec2) {
+        .x = ballSoAGetFloat(&balls->previousPositionX, index),
+        .y = ballSoAGetFloat(&balls->previousPositionY, index),
+    };
+}
+
+/// @brief Adds a ball whose previous position is the same as its current one.
+/// @param balls Pointer to the balls.
+/// @param ball Pointer to the added ball.
+static inline void ballSoAPushBack(BallSoA* balls, const Ball* ball)
+{
+    vectorPushBack(&balls->positionX, &ball->position.x, sizeof(float));
+    vectorPushBack(&balls->positionY, &ball->position.y, sizeof(float));
+    vectorPushBack(&balls->directionX, &ball->direction.x, sizeof(float));
+    vectorPushBack(&balls->directionY, &ball->direction.y, sizeof(float));
+    vectorPushBack(&balls->speed, &ball->speed, sizeof(float));
+    vectorPushBack(&balls->radius, &ball->radius, sizeof(float));
+    vectorPushBack(&balls->previousPositionX, &ball->position.x, sizeof(float));
+    vectorPushBack(&balls->previousPositionY, &ball->position.y, sizeof(float));
+}
+
+static inline void ballSoASwapEraseFloat(Vector* field, size_t index)
+{
+    size_t last = vectorSize(field, sizeof(float)) - 1;
+    ballSoASetFloat(field, index, ballSoAGetFloat(field, last));
+    vectorResize(field, last, sizeof(float));
+}
+
+/// @brief Erases a ball in constant time by moving the last ball into its place.
+/// @param balls Pointer to the balls.
+/// @param index Index of the erased ball.
+static inline void ballSoASwapErase(BallSoA* balls, size_t index)
+{
+    ballSoASwapEraseFloat(&balls->positionX, index);
+    ballSoASwapEraseFloat(&balls->positionY, index);
+    ballSoASwapEraseFloat(&balls->directionX, index);
+    ballSoASwapEraseFloat(&balls->directionY, index);
+    ballSoASwapEraseFloat(&balls->speed, index);
+    ballSoASwapEraseFloat(&balls->radius, index);
+    ballSoASwapEraseFloat(&balls->previousPositionX, index);
+    ballSoASwapEraseFloat(&balls->previousPositionY, index);
+}
+
+/// @brief Makes the current positions of all the balls their previous positions.
+/// @param balls Pointer to the balls.
+static inline void ballSoAStorePreviousPositions(BallSoA* balls)
+{
+    size_t size = balls->positionX.size;
+    memcpy(balls->previousPositionX.data, balls->positionX.data, size);
+    memcpy(balls->previousPositionY.data, balls->positionY.data, size);
+}
+
+/// @brief Moves a ball over a period of time if nothing could have happened to it on the way, see
+/// moveBallGroupIfClear.
+/// @return True if the ball was moved, false otherwise.
+static inline bool moveBallIfClear(float* positionX, float* positionY, float directionX, float directionY,
+    float speed, float radius, float time, const RectBounds* area, const RectBounds* obstacles,
+    size_t obstacleCount)
+{
+    float distance = speed * time;
+    float endX = *positionX + directionX * distance;
+    float endY = *positionY + directionY * distance;
+    RectBounds path = {
+        .topLeft = { .x = min(*positionX, endX) - radius, .y = max(*positionY, endY) + radius },
+        .bottomRight = { .x = max(*positionX, endX) + radius, .y = min(*positionY, endY) - radius },
+    };
+
+    if (path.topLeft.x < area->topLeft.x || path.bottomRight.x > area->bottomRight.x
+        || path.bottomRight.y < area->bottomRight.y || path.topLeft.y > area->topLeft.y)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < obstacleCount; i++)
+    {
+        const RectBounds* obstacle = &obstacles[i];
+
+        if (path.topLeft.x < obstacle->bottomRight.x && path.bottomRight.x > obstacle->topLeft.x
+            && path.bottomRight.y < obstacle->topLeft.y && path.topLeft.y > obstacle->bottomRight.y)
+        {
+            return false;
+        }
+    }
+
+    *positionX = endX;
+    *positionY = endY;
+
+    return true;
+}
+
+/// @brief Moves four balls stored in separate field arrays over a period of time, but only the ones whose whole
+/// path stays inside an area and whose bounds never overlap any of the obstacles on the way, so that nothing
+/// could have happened to them. The other balls are left where they are.
+/// @param positionX Array of four x coordinates, updated for the moved balls.
+/// @param positionY Array of four y coordinates, updated for the moved balls.
+/// @param directionX Array of four x coordinates of the directions.
+/// @param directionY Array of four y coordinates of the directions.
+/// @param speed Array of four speeds.
+/// @param radius Array of four radii.
+/// @param time The period of time.
+/// @param area Pointer to the bounds which the balls have to stay in.
+/// @param obstacles Array of bounds which the balls can't get into.
+/// @param obstacleCount Number of obstacles.
+/// @return Bitmask with the bit i set if the ball i was moved.
+static inline uint32_t moveBallGroupIfClear(float* positionX, float* positionY, const float* directionX,
+    const float* directionY, const float* speed, const float* radius, float time, const RectBounds* area,
+    const RectBounds* obstacles, size_t obstacleCount)
+{
+#ifdef __SSE__
+    __m128 startX = _mm_loadu_ps(positionX);
+    __m128 startY = _mm_loadu_ps(positionY);
+    __m128 distance = _mm_mul_ps(_mm_loadu_ps(speed), _mm_set1_ps(time));
+    __m128 endX = _mm_add_ps(startX, _mm_mul_ps(_mm_loadu_ps(directionX), distance));
+    __m128 endY = _mm_add_ps(startY, _mm_mul_ps(_mm_loadu_ps(directionY), distance));
+    __m128 radii = _mm_loadu_ps(radius);
+
+    // bounds of the whole path
+    __m128 minX = _mm_sub_ps(_mm_min_ps(startX, endX), radii);
+    __m128 minY = _mm_sub_ps(_mm_min_ps(startY, endY), radii);
+    __m128 maxX = _mm_add_ps(_mm_max_ps(startX, endX), radii);
+    __m128 maxY = _mm_add_ps(_mm_max_ps(startY, endY), radii);
+
+    __m128 clear = _mm_and_ps(
+        _mm_and_ps(_mm_cmpge_ps(minX, _mm_set1_ps(area->topLeft.x)),
+            _mm_cmple_ps(maxX, _mm_set1_ps(area->bottomRight.x))),
+        _mm_and_ps(_mm_cmpge_ps(minY, _mm_set1_ps(area->bottomRight.y)),
+            _mm_cmple_ps(maxY, _mm_set1_ps(area->topLeft.y))));
+
+    for (size_t i = 0; i < obstacleCount; i++)
+    {
+        const RectBounds* obstacle = &obstacles[i];
+        __m128 overlap = _mm_and_ps(
+            _mm_and_ps(_mm_cmplt_ps(minX, _mm_set1_ps(obstacle->bottomRight.x)),
+                _mm_cmpgt_ps(maxX, _mm_set1_ps(obstacle->topLeft.x))),
+            _mm_and_ps(_mm_cmplt_ps(minY, _mm_set1_ps(obstacle->topLeft.y)),
+                _mm_cmpgt_ps(maxY, _mm_set1_ps(obstacle->bottomRight.y))));
+        clear = _mm_andnot_ps(overlap, clear);
+    }
+
+    _mm_storeu_ps(positionX, _mm_or_ps(_mm_and_ps(clear, endX), _mm_andnot_ps(clear, startX)));
+    _mm_storeu_ps(positionY, _mm_or_ps(_mm_and_ps(clear, endY), _mm_andnot_ps(clear, startY)));
+
+    return (uint32_t)_mm_movemask_ps(clear);
+#else
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        if (moveBallIfClear(&positionX[i], &positionY[i], directionX[i], directionY[i], speed[i], radius[i], time,
+                area, obstacles, obstacleCount))
+        {
+            mask |= 1u << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+/// @brief Moves a range of balls over a period of time if nothing could have happened to them on the way, see
+/// moveBallGroupIfClear.
+/// @param balls Pointer to the balls.
+/// @param first Index of the first ball to move.
+/// @param count Number of balls to move, at most MAX_BALLS_PER_MOVE_MASK.
+/// @param time The period of time.
+/// @param area Pointer to the bounds which the balls have to stay in.
+/// @param obstacles Array of bounds which the balls can't get into.
+/// @param obstacleCount Number of obstacles.
+/// @return Bitmask with the bit i set if the ball first + i was moved.
+static inline uint32_t ballSoAMoveClear(BallSoA* balls, size_t first, size_t count, float time,
+    const RectBounds* area, const RectBounds* obstacles, size_t obstacleCount)
+{
+    assert(count <= MAX_BALLS_PER_MOVE_MASK);
+
+    float* positionX = vectorGet(&balls->positionX, first, sizeof(float));
+    float* positionY = vectorGet(&balls->positionY, first, sizeof(float));
+    const float* directionX = vectorGet(&balls->directionX, first, sizeof(float));
+    const float* directionY = vectorGet(&balls->directionY, first, sizeof(float));
+    const float* speed = vectorGet(&balls->speed, first, sizeof(float));
+    const float* radius = vectorGet(&balls->radius, first, sizeof(float));
+    uint32_t mask = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        mask |= moveBallGroupIfClear(&positionX[i], &positionY[i], &directionX[i], &directionY[i], &speed[i],
+            &radius[i], time, area, obstacles, obstacleCount) << i;
+    }
+
+    // whatever didn't fill a whole group
+    for (; i < count; i++)
+    {
+        if (moveBallIfClear(&positionX[i], &positionY[i], directionX[i], directionY[i], speed[i], radius[i], time,
+                area, obstacles, obstacleCount))
+        {
+            mask |= 1u << i;
+        }
+    }
+
+    return mask;
+}
+
+static inline void ballSoAFree(BallSoA* balls)
+{
+    vectorFree(&balls->positionX);
+    vectorFree(&balls->positionY);
+    vectorFree(&balls->directionX);
+    vectorFree(&balls->directionY);
+    vectorFree(&balls->speed);
+    vectorFree(&balls->radius);
+    vectorFree(&balls->previousPositionX);
+    vectorFree(&balls->previousPositionY);
+}
@@ -0,0 +1,403 @@
+#include "block_bvh.h"
+
+#include <float.h>
+#include <stddef.h>
+
+#include "helpers.h"
+#include "memory.h"
+
+#define AXIS_X 0
+#define AXIS_Y 1
+
+typedef struct BlockBvhBin
+{
+    RectBounds bounds;
+    uint32_t blockCount;
+} BlockBvhBin;
+
+typedef struct BlockBvhSplit
+{
+    int axis;
+    size_t bin; // blocks in the bins before this one go to the first child
+    float cost;
+} BlockBvhSplit;
+
+typedef struct BlockBvhBuilder
+{
+    BlockBvh* bvh;
+    RectBounds* blockBounds;
+    Vec2* blockCentroids;
+} BlockBvhBuilder;
+
+static inline RectBounds getEmptyBounds(void)
+{
+    return (RectBounds) {
+        .topLeft = { .x = FLT_MAX, .y = -FLT_MAX },
+        .bottomRight = { .x = -FLT_MAX, .y = FLT_MAX },
+    };
+}
+
+static inline RectBounds mergeBounds(RectBounds a, RectBounds b)
+{
+    return (RectBounds) {
+        .topLeft = { .x = min(a.topLeft.x, b.topLeft.x), .y = max(a.topLeft.y, b.topLeft.y) },
+        .bottomRight = { .x = max(a.bottomRight.x, b.bottomRight.x), .y = min(a.bottomRight.y, b.bottomRight.y) },
+    };
+}
+
+// the 2D counterpart of the surface area, the chance that a random line crosses the bounds grows with it
+static inline float getBoundsPerimeter(const RectBounds* bounds)
+{
+    return 2.0f * ((bounds->bottomRight.x - bounds->topLeft.x) + (bounds->topLeft.y - bounds->bottomRight.y));
+}
+
+static inline float getAxisCoordinate(Vec2 point, int axis)
+{
+    return axis == AXIS_X ? point.x : point.y;
+}
+
+static size_t getCentroidBin(Vec2 centroid, int axis, float binsStart, float binsExtent)
+{
+    float offset = (getAxisCoordinate(centroid, axis) - binsStart) / binsExtent;
+    return min((size_t)(max(offset, 0.0f) * BLOCK_BVH_SAH_BIN_COUNT), (size_t)BLOCK_BVH_SAH_BIN_COUNT - 1);
+}
+
+// sorts the centroids of the blocks into bins and returns the cheapest split between two of them, the cost is
+// relative to testing every block of the node
+static BlockBvhSplit findSahSplit(const BlockBvhBuilder* builder, uint32_t first, uint32_t count,
+    const RectBounds* nodeBounds, const RectBounds* centroidBounds)
+{
+    BlockBvhSplit best = { .axis = AXIS_X, .bin = 0, .cost = FLT_MAX };
+    float nodePerimeter = max(getBoundsPerimeter(nodeBounds), FLT_EPSILON);
+
+    for (int axis = AXIS_X; axis <= AXIS_Y; axis++)
+    {
+        float binsStart = axis == AXIS_X ? centroidBounds->topLeft.x : centroidBounds->bottomRight.y;
+        float binsExtent = axis == AXIS_X ? centroidBounds->bottomRight.x - centroidBounds->topLeft.x
+            : centroidBounds->topLeft.y - centroidBounds->bottomRight.y;
+
+        if (binsExtent <= 0.0f)
+            continue;
+
+        BlockBvhBin bins[BLOCK_BVH_SAH_BIN_COUNT];
+
+        for (size_t i = 0; i < BLOCK_BVH_SAH_BIN_COUNT; i++)
+            bins[i] = (BlockBvhBin){ .bounds = getEmptyBounds(), .blockCount = 0 };
+
+        for (uint32_t i = first; i < first + count; i++)
+        {
+            uint32_t blockIndex = builder->bvh->leafBlocks[i];
+            BlockBvhBin* bin = &bins[getCentroidBin(builder->blockCentroids[blockIndex], axis, binsStart,
+                binsExtent)];
+
+            bin->bounds = mergeBounds(bin->bounds, builder->blockBounds[blockIndex]);
+            bin->blockCount++;
+        }
+
+        // costs of the first children are gathered from the left, then the second children are added from the
+        // right
+        float firstChildCosts[BLOCK_BVH_SAH_BIN_COUNT];
+        RectBounds bounds = getEmptyBounds();
+        uint32_t blockCount = 0;
+
+        for (size_t i = 1; i < BLOCK_BVH_SAH_BIN_COUNT; i++)
+        {
+            bounds = mergeBounds(bounds, bins[i - 1].bounds);
+            blockCount += bins[i - 1].blockCount;
+            firstChildCosts[i] = blockCount > 0 ? (float)blockCount * getBoundsPerimeter(&bounds) : -1.0f;
+        }
+
+        bounds = getEmptyBounds();
+        blockCount = 0;
+
+        for (size_t i = BLOCK_BVH_SAH_BIN_COUNT - 1; i > 0; i--)
+        {
+            bounds = mergeBounds(bounds, bins[i].bounds);
+            blockCount += bins[i].blockCount;
+
+            if (blockCount == 0 || firstChildCosts[i] < 0.0f)
+                continue;
+
+            float cost = BLOCK_BVH_TRAVERSAL_COST
+                + (firstChildCosts[i] + (float)blockCount * getBoundsPerimeter(&bounds)) / nodePerimeter;
+
+            if (cost < best.cost)
+                best = (BlockBvhSplit){ .axis = axis, .bin = i, .cost = cost };
+        }
+    }
+
+    return best;
+}
+
+// moves the blocks which go to the first child to the front of the range and returns their count
+static uint32_t partitionBlocks(const BlockBvhBuilder* builder, uint32_t first, uint32_t count,
+    const RectBounds* centroidBounds, const BlockBvhSplit* split)
+{
+    // the centroids can't be told apart, so the blocks are split in half
+    if (split->cost == FLT_MAX)
+        return count / 2;
+
+    float binsStart = split->axis == AXIS_X ? centroidBounds->topLeft.x : centroidBounds->bottomRight.y;
+    float binsExtent = split->axis == AXIS_X ? centroidBounds->bottomRight.x - centroidBounds->topLeft.x
+        : centroidBounds->topLeft.y - centroidBounds->bottomRight.y;
+
+    uint32_t* blocks = &builder->bvh->leafBlocks[first];
+    uint32_t firstChildCount = 0;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        Vec2 centroid = builder->blockCentroids[blocks[i]];
+
+        if (getCentroidBin(centroid, split->axis, binsStart, binsExtent) < split->bin)
+        {
+            uint32_t swapped = blocks[firstChildCount];
+            blocks[firstChildCount++] = blocks[i];
+            blocks[i] = swapped;
+        }
+    }
+
+    return firstChildCount;
+}
+
+static uint32_t buildBlockBvhNode(BlockBvhBuilder* builder, uint32_t first, uint32_t count, uint32_t parent,
+    size_t depth)
+{
+    BlockBvh* bvh = builder->bvh;
+    uint32_t nodeIndex = (uint32_t)bvh->nodeCount++;
+
+    RectBounds bounds = getEmptyBounds();
+    RectBounds centroidBounds = getEmptyBounds();
+
+    for (uint32_t i = first; i < first + count; i++)
+    {
+        uint32_t blockIndex = bvh->leafBlocks[i];
+        Vec2 centroid = builder->blockCentroids[blockIndex];
+
+        bounds = mergeBounds(bounds, builder->blockBounds[blockIndex]);
+        centroidBounds = mergeBounds(centroidBounds, (RectBounds){ .topLeft = centroid, .bottomRight = centroid });
+    }
+
+    bvh->nodes[nodeIndex] = (BlockBvhNode) {
+        .bounds = bounds,
+        .parent = parent,
+        .secondChild = NO_BLOCK_BVH_NODE,
+        .firstBlock = first,
+        .blockCount = count,
+    };
+
+    bool leaf = count <= 1 || depth == BLOCK_BVH_MAX_DEPTH;
+    BlockBvhSplit split = { .axis = AXIS_X, .bin = 0, .cost = FLT_MAX };
+
+    if (!leaf)
+    {
+        split = findSahSplit(builder, first, count, &bounds, &centroidBounds);
+
+        // testing every block of a small node is cheaper than visiting its children
+        leaf = count <= MAX_BLOCK_BVH_LEAF_BLOCKS && split.cost >= (float)count;
+    }
+
+    if (leaf)
+    {
+        for (uint32_t i = first; i < first + count; i++)
+            bvh->blockLeaves[bvh->leafBlocks[i]] = nodeIndex;
+
+        return nodeIndex;
+    }
+
+    uint32_t firstChildCount = partitionBlocks(builder, first, count, &centroidBounds, &split);
+
+    buildBlockBvhNode(builder, first, firstChildCount, nodeIndex, depth + 1);
+    uint32_t secondChild = buildBlockBvhNode(builder, first + firstChildCount, count - firstChildCount,
+        nodeIndex, depth + 1);
+
+    bvh->nodes[nodeIndex].secondChild = secondChild;
+
+    return nodeIndex;
+}
+
+BlockBvh blockBvhCreate(const Block* blocks, size_t blockCount)
+{
+    // a binary tree with a block in every leaf has the most nodes
+    size_t maxNodeCount = max(2 * blockCount, 2) - 1;
+
+    BlockBvh bvh = {
+        .elemCount = blockCount,
+        .nodes = checkedMalloc(sizeof(BlockBvhNode) * maxNodeCount),
+        .nodeCount = 0,
+        .leafBlocks = checkedMalloc(sizeof(uint32_t) * max(blockCount, 1)),
+        .blockLeaves = checkedMalloc(sizeof(uint32_t) * max(blockCount, 1)),
+        .blocks = blocks,
+    };
+
+    BlockBvhBuilder builder = {
+        .bvh = &bvh,
+        .blockBounds = checkedMalloc(sizeof(RectBounds) * max(blockCount, 1)),
+        .blockCentroids = checkedMalloc(sizeof(Vec2) * max(blockCount, 1)),
+    };
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        RectBounds bounds = getBlockRectBounds(&blocks[i]);
+
+        bvh.leafBlocks[i] = (uint32_t)i;
+        builder.blockBounds[i] = bounds;
+        builder.blockCentroids[i] = (Vec2) {
+            .x = (bounds.topLeft.x + bounds.bottomRight.x) / 2.0f,
+            .y = (bounds.topLeft.y + bounds.bottomRight.y) / 2.0f,
+        };
+    }
+
+    buildBlockBvhNode(&builder, 0, (uint32_t)blockCount, NO_BLOCK_BVH_NODE, 0);
+
+    free(builder.blockBounds);
+    free(builder.blockCentroids);
+
+    return bvh;
+}
+
+static RectBounds getLeafBlocksBounds(const BlockBvh* bvh, const BlockBvhNode* leaf)
+{
+    RectBounds bounds = getEmptyBounds();
+
+    for (uint32_t i = leaf->firstBlock; i < leaf->firstBlock + leaf->blockCount; i++)
+        bounds = mergeBounds(bounds, getBlockRectBounds(&bvh->blocks[bvh->leafBlocks[i]]));
+
+    return bounds;
+}
+
+static RectBounds getChildrenBounds(const BlockBvh* bvh, uint32_t nodeIndex)
+{
+    const BlockBvhNode* firstChild = &bvh->nodes[nodeIndex + 1];
+    const BlockBvhNode* secondChild = &bvh->nodes[bvh->nodes[nodeIndex].secondChild];
+    RectBounds bounds = getEmptyBounds();
+
+    if (firstChild->blockCount > 0)
+        bounds = mergeBounds(bounds, firstChild->bounds);
+
+    if (secondChild->blockCount > 0)
+        bounds = mergeBounds(bounds, secondChild->bounds);
+
+    return bounds;
+}
+
+bool blockBvhRemoveBlock(BlockBvh* bvh, const Block* block)
+{
+    size_t blockIndex = (size_t)(block - bvh->blocks);
+    uint32_t leafIndex = bvh->blockLeaves[blockIndex];
+
+    if (leafIndex == NO_BLOCK_BVH_NODE)
+        return false;
+
+    BlockBvhNode* leaf = &bvh->nodes[leafIndex];
+    uint32_t* leafBlocks = &bvh->leafBlocks[leaf->firstBlock];
+    uint32_t slot = 0;
+
+    while (leafBlocks[slot] != blockIndex)
+        slot++;
+
+    // the following blocks are shifted to keep the order in which they're visited
+    for (uint32_t i = slot; i + 1 < leaf->blockCount; i++)
+        leafBlocks[i] = leafBlocks[i + 1];
+
+    leaf->blockCount--;
+    leaf->bounds = getLeafBlocksBounds(bvh, leaf);
+
+    for (uint32_t i = leaf->parent; i != NO_BLOCK_BVH_NODE; i = bvh->nodes[i].parent)
+    {
+        bvh->nodes[i].blockCount--;
+        bvh->nodes[i].bounds = getChildrenBounds(bvh, i);
+    }
+
+    bvh->blockLeaves[blockIndex] = NO_BLOCK_BVH_NODE;
+    bvh->elemCount--;
+
+    return true;
+}
+
+bool blockBvhVisitByBounds(const BlockBvh* bvh, RectBounds bounds, BlockVisitor visitor, void* context)
+{
+    // every popped inner node pushes its two children in place of itself
+    uint32_t stack[BLOCK_BVH_MAX_DEPTH + 1];
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const BlockBvhNode* node = &bvh->nodes[nodeIndex];
+
+        if (node->blockCount == 0 || !rectBoundsOverlap(&node->bounds, &bounds))
+            continue;
+
+        if (node->secondChild != NO_BLOCK_BVH_NODE)
+        {
+            stack[stackSize++] = node->secondChild;
+            stack[stackSize++] = nodeIndex + 1;
+            continue;
+        }
+
+        for (uint32_t i = node->firstBlock; i < node->firstBlock + node->blockCount; i++)
+        {
+            const Block* block = &bvh->blocks[bvh->leafBlocks[i]];
+            RectBounds blockBounds = getBlockRectBounds(block);
+
+            if (rectBoundsOverlap(&blockBounds, &bounds) && !visitor(block, context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void blockBvhRetrieveAllByBounds(const BlockBvh* bvh, RectBounds bounds, Vector* result)
+{
+    blockBvhVisitByBounds(bvh, bounds, pushBackBlockVisitor, result);
+}
+
+bool blockBvhVisitBySweptCircle(const BlockBvh* bvh, Vec2 start, Vec2 end, float radius, BlockVisitor visitor,
+    void* context)
+{
+    uint32_t stack[BLOCK_BVH_MAX_DEPTH + 1];
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const BlockBvhNode* node = &bvh->nodes[nodeIndex];
+
+        if (node->blockCount == 0 || !sweptCircleOverlapsBounds(start, end, radius, &node->bounds))
+            continue;
+
+        if (node->secondChild != NO_BLOCK_BVH_NODE)
+        {
+            stack[stackSize++] = node->secondChild;
+            stack[stackSize++] = nodeIndex + 1;
+            continue;
+        }
+
+        for (uint32_t i = node->firstBlock; i < node->firstBlock + node->blockCount; i++)
+        {
+            const Block* block = &bvh->blocks[bvh->leafBlocks[i]];
+            RectBounds blockBounds = getBlockRectBounds(block);
+
+            if (sweptCircleOverlapsBounds(start, end, radius, &blockBounds) && !visitor(block, context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+void blockBvhFree(BlockBvh* bvh)
+{
+    free(bvh->nodes);
+    bvh->nodes = NULL;
+    bvh->nodeCount = 0;
+    bvh->elemCount = 0;
+
+    free(bvh->leafBlocks);
+    bvh->leafBlocks = NULL;
+    free(bvh->blockLeaves);
+    bvh->blockLeaves = NULL;
+}
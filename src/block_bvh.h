@@ -0,0 +1,88 @@
+/// @file block_bvh.h
+/// @brief A bounding volume hierarchy used to find blocks on boards whose blocks aren't laid out in a grid.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_visitor.h"
+#include "entities.h"
+#include "vector.h"
+
+/// @brief Maximum number of blocks which the build puts into a single BVH leaf, unless they can't be split.
+#define MAX_BLOCK_BVH_LEAF_BLOCKS 4
+/// @brief Number of bins the centroids are sorted into when looking for the cheapest split of a node.
+#define BLOCK_BVH_SAH_BIN_COUNT 12
+/// @brief Cost of visiting a node relative to the cost of testing a block, used to decide when to stop splitting.
+#define BLOCK_BVH_TRAVERSAL_COST 1.0f
+/// @brief Depth at which nodes become leaves no matter how many blocks they have. It also bounds the stack used
+/// by the queries.
+#define BLOCK_BVH_MAX_DEPTH 32
+
+/// @brief Node of a BVH. The first child of an inner node directly follows it in the node array.
+typedef struct BlockBvhNode
+{
+    RectBounds bounds; // refitted when blocks are removed, meaningless once the node is empty
+    uint32_t parent;
+    uint32_t secondChild; // index of the second child or NO_BLOCK_BVH_NODE in leaves
+    uint32_t firstBlock; // start of the leaf's range in the leaf block array
+    uint32_t blockCount; // blocks left in the whole subtree, in leaves also the length of the range
+} BlockBvhNode;
+
+/// @brief Node index used for missing nodes.
+#define NO_BLOCK_BVH_NODE UINT32_MAX
+
+/// @brief Bounding volume hierarchy built top-down with the surface area heuristic. Every block is stored in
+/// exactly one leaf, so queries never return duplicates. Like QuadTree, it doesn't manage the blocks on its own,
+/// it only stores their indices in the block array passed to blockBvhCreate.
+typedef struct BlockBvh
+{
+    size_t elemCount;
+
+    // PRIVATE
+    BlockBvhNode* nodes;
+    size_t nodeCount;
+    uint32_t* leafBlocks; // block indices grouped by leaf
+    uint32_t* blockLeaves; // leaf of every block in the block array, NO_BLOCK_BVH_NODE once it's removed
+    const Block* blocks;
+} BlockBvh;
+
+/// @brief Builds a BVH over all of the blocks.
+/// @param blocks Array of blocks which will be inserted into the BVH.
+/// @param blockCount Number of blocks in the array.
+/// @return Created BVH.
+BlockBvh blockBvhCreate(const Block* blocks, size_t blockCount);
+/// @brief Removes a block from the BVH and shrinks the bounds of the nodes above it.
+/// @param bvh Pointer to the BVH.
+/// @param block Pointer to the block.
+/// @return True if the block was stored in the BVH, false otherwise.
+bool blockBvhRemoveBlock(BlockBvh* bvh, const Block* block);
+/// @brief Calls a visitor for all the blocks which at least partially cover a certain area, without allocating
+/// any memory. Every block is visited at most once.
+/// @param bvh Pointer to the BVH.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param visitor Function called for every found block. It must not modify the BVH.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool blockBvhVisitByBounds(const BlockBvh* bvh, RectBounds bounds, BlockVisitor visitor, void* context);
+/// @brief Retrieves all the blocks which at least partially cover a certain area. Every block is retrieved
+/// at most once.
+/// @param bvh Pointer to the BVH.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void blockBvhRetrieveAllByBounds(const BlockBvh* bvh, RectBounds bounds, Vector* result);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, without
+/// allocating any memory. Every block is visited at most once.
+/// @param bvh Pointer to the BVH.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the BVH.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool blockBvhVisitBySweptCircle(const BlockBvh* bvh, Vec2 start, Vec2 end, float radius, BlockVisitor visitor,
+    void* context);
+/// @brief Frees a BVH object.
+/// @param bvh Pointer to the BVH.
+void blockBvhFree(BlockBvh* bvh);
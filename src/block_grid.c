@@ -0,0 +1,204 @@
+#include "block_grid.h"
+
+#include "helpers.h"
+#include "memory.h"
+
+typedef struct CellRange
+{
+    size_t firstCol;
+    size_t lastCol;
+    size_t firstRow;
+    size_t lastRow;
+} CellRange;
+
+static inline size_t getCellIndex(const BlockGrid* grid, size_t col, size_t row)
+{
+    return row * grid->colCount + col;
+}
+
+static size_t getCellCoordinate(float offset, float cellSize, size_t cellCount)
+{
+    if (offset <= 0.0f)
+        return 0;
+
+    return min((size_t)(offset / cellSize), cellCount - 1);
+}
+
+// cells on the edges of the grid extend to infinity, so that every area maps to at least one cell
+static CellRange getCellRange(const BlockGrid* grid, const RectBounds* bounds)
+{
+    float left = grid->bounds.topLeft.x;
+    float bottom = grid->bounds.bottomRight.y;
+
+    return (CellRange) {
+        .firstCol = getCellCoordinate(bounds->topLeft.x - left, grid->cellWidth, grid->colCount),
+        .lastCol = getCellCoordinate(bounds->bottomRight.x - left, grid->cellWidth, grid->colCount),
+        .firstRow = getCellCoordinate(bounds->bottomRight.y - bottom, grid->cellHeight, grid->rowCount),
+        .lastRow = getCellCoordinate(bounds->topLeft.y - bottom, grid->cellHeight, grid->rowCount),
+    };
+}
+
+BlockGrid blockGridCreate(RectBounds bounds, size_t colCount, size_t rowCount, const Block* blocks,
+    size_t blockCount)
+{
+    colCount = max(colCount, 1);
+    rowCount = max(rowCount, 1);
+    size_t cellCount = colCount * rowCount;
+
+    BlockGrid grid = {
+        .bounds = bounds,
+        .colCount = colCount,
+        .rowCount = rowCount,
+        .cellWidth = (bounds.bottomRight.x - bounds.topLeft.x) / (float)colCount,
+        .cellHeight = (bounds.topLeft.y - bounds.bottomRight.y) / (float)rowCount,
+        .elemCount = blockCount,
+        .cellOffsets = checkedCalloc(cellCount + 1, sizeof(uint32_t)),
+        .blocksRemoved = checkedCalloc(blockCount, sizeof(bool)),
+        .blocks = blocks,
+        .blockQueryStamps = queryStampsCreate(blockCount),
+    };
+
+    // count the blocks in every cell, then turn the counts into offsets and fill the cells
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        RectBounds blockBounds = getBlockRectBounds(&blocks[i]);
+        CellRange range = getCellRange(&grid, &blockBounds);
+
+        for (size_t row = range.firstRow; row <= range.lastRow; row++)
+            for (size_t col = range.firstCol; col <= range.lastCol; col++)
+                grid.cellOffsets[getCellIndex(&grid, col, row) + 1]++;
+    }
+
+    for (size_t i = 0; i < cellCount; i++)
+        grid.cellOffsets[i + 1] += grid.cellOffsets[i];
+
+    grid.cellBlocks = checkedMalloc(sizeof(uint32_t) * grid.cellOffsets[cellCount]);
+    uint32_t* cellFillCounts = checkedCalloc(cellCount, sizeof(uint32_t));
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        RectBounds blockBounds = getBlockRectBounds(&blocks[i]);
+        CellRange range = getCellRange(&grid, &blockBounds);
+
+        for (size_t row = range.firstRow; row <= range.lastRow; row++)
+        {
+            for (size_t col = range.firstCol; col <= range.lastCol; col++)
+            {
+                size_t cell = getCellIndex(&grid, col, row);
+                grid.cellBlocks[grid.cellOffsets[cell] + cellFillCounts[cell]++] = (uint32_t)i;
+            }
+        }
+    }
+
+    free(cellFillCounts);
+
+    return grid;
+}
+
+bool blockGridRemoveBlock(BlockGrid* grid, const Block* block)
+{
+    size_t blockIndex = (size_t)(block - grid->blocks);
+
+    if (grid->blocksRemoved[blockIndex])
+        return false;
+
+    grid->blocksRemoved[blockIndex] = true;
+    grid->elemCount--;
+
+    return true;
+}
+
+bool blockGridVisitByBounds(BlockGrid* grid, RectBounds bounds, BlockVisitor visitor, void* context)
+{
+    queryStampsAdvance(&grid->blockQueryStamps);
+    CellRange range = getCellRange(grid, &bounds);
+
+    for (size_t row = range.firstRow; row <= range.lastRow; row++)
+    {
+        for (size_t col = range.firstCol; col <= range.lastCol; col++)
+        {
+            size_t cell = getCellIndex(grid, col, row);
+
+            for (uint32_t i = grid->cellOffsets[cell]; i < grid->cellOffsets[cell + 1]; i++)
+            {
+                uint32_t blockIndex = grid->cellBlocks[i];
+
+                if (grid->blocksRemoved[blockIndex]
+                    || !queryStampsMark(&grid->blockQueryStamps, blockIndex))
+                {
+                    continue;
+                }
+
+                if (!visitor(&grid->blocks[blockIndex], context))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+void blockGridRetrieveAllByBounds(BlockGrid* grid, RectBounds bounds, Vector* result)
+{
+    blockGridVisitByBounds(grid, bounds, pushBackBlockVisitor, result);
+}
+
+// without the stamps blocks which overlap many cells are visited once for every cell
+static bool visitBlockGridBySweptCircle(const BlockGrid* grid, QueryStamps* stamps, Vec2 start, Vec2 end,
+    float radius, BlockVisitor visitor, void* context)
+{
+    RectBounds sweptBounds = {
+        .topLeft = { .x = min(start.x, end.x) - radius, .y = max(start.y, end.y) + radius },
+        .bottomRight = { .x = max(start.x, end.x) + radius, .y = min(start.y, end.y) - radius },
+    };
+
+    CellRange range = getCellRange(grid, &sweptBounds);
+
+    for (size_t row = range.firstRow; row <= range.lastRow; row++)
+    {
+        for (size_t col = range.firstCol; col <= range.lastCol; col++)
+        {
+            size_t cell = getCellIndex(grid, col, row);
+
+            for (uint32_t i = grid->cellOffsets[cell]; i < grid->cellOffsets[cell + 1]; i++)
+            {
+                uint32_t blockIndex = grid->cellBlocks[i];
+                RectBounds blockBounds = getBlockRectBounds(&grid->blocks[blockIndex]);
+
+                if (grid->blocksRemoved[blockIndex]
+                    || !sweptCircleOverlapsBounds(start, end, radius, &blockBounds)
+                    || (stamps && !queryStampsMark(stamps, blockIndex)))
+                {
+                    continue;
+                }
+
+                if (!visitor(&grid->blocks[blockIndex], context))
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+bool blockGridVisitBySweptCircle(BlockGrid* grid, Vec2 start, Vec2 end, float radius, BlockVisitor visitor,
+    void* context)
+{
+    queryStampsAdvance(&grid->blockQueryStamps);
+    return visitBlockGridBySweptCircle(grid, &grid->blockQueryStamps, start, end, radius, visitor, context);
+}
+
+bool blockGridVisitBySweptCircleReadOnly(const BlockGrid* grid, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context)
+{
+    return visitBlockGridBySweptCircle(grid, NULL, start, end, radius, visitor, context);
+}
+
+void blockGridFree(BlockGrid* grid)
+{
+    free(grid->cellOffsets);
+    free(grid->cellBlocks);
+    free(grid->blocksRemoved);
+    queryStampsFree(&grid->blockQueryStamps);
+    grid->elemCount = 0;
+}
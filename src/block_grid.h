@@ -0,0 +1,88 @@
+/// @file block_grid.h
+/// @brief A uniform grid used to find blocks on boards whose blocks are laid out in a grid, like the ones
+/// loaded from level files.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_visitor.h"
+#include "entities.h"
+#include "query_stamps.h"
+#include "vector.h"
+
+/// @brief Uniform grid which maps areas straight to ranges of cells. Like QuadTree, it doesn't manage the
+/// blocks on its own, it only stores their indices in the block array passed to blockGridCreate.
+typedef struct BlockGrid
+{
+    RectBounds bounds;
+    size_t colCount;
+    size_t rowCount;
+    float cellWidth;
+    float cellHeight;
+    size_t elemCount;
+
+    // PRIVATE
+    // blocks of the cell i (counting rows from the bottom) are cellBlocks[cellOffsets[i]..cellOffsets[i + 1])
+    uint32_t* cellOffsets;
+    uint32_t* cellBlocks;
+    bool* blocksRemoved;
+    const Block* blocks;
+    QueryStamps blockQueryStamps; // used to skip blocks which overlap many cells
+} BlockGrid;
+
+/// @brief Creates a block grid and inserts all of the blocks into it.
+/// @param bounds The area which the grid will cover.
+/// @param colCount Number of columns in the grid.
+/// @param rowCount Number of rows in the grid.
+/// @param blocks Array of blocks which will be inserted into the grid.
+/// @param blockCount Number of blocks in the array.
+/// @return Created block grid.
+BlockGrid blockGridCreate(RectBounds bounds, size_t colCount, size_t rowCount, const Block* blocks,
+    size_t blockCount);
+/// @brief Removes a block from the grid in constant time.
+/// @param grid Pointer to the block grid.
+/// @param block Pointer to the block.
+/// @return True if the block was stored in the grid, false otherwise.
+bool blockGridRemoveBlock(BlockGrid* grid, const Block* block);
+/// @brief Calls a visitor for all the blocks stored in the cells which a certain area covers, without
+/// allocating any memory. Every block is visited at most once.
+/// @param grid Pointer to the block grid.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param visitor Function called for every found block. It must not modify the grid.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool blockGridVisitByBounds(BlockGrid* grid, RectBounds bounds, BlockVisitor visitor, void* context);
+/// @brief Retrieves all the blocks stored in the cells which a certain area covers. Every block is retrieved
+/// at most once.
+/// @param grid Pointer to the block grid.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void blockGridRetrieveAllByBounds(BlockGrid* grid, RectBounds bounds, Vector* result);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, without
+/// allocating any memory. Every block is visited at most once.
+/// @param grid Pointer to the block grid.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the grid.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool blockGridVisitBySweptCircle(BlockGrid* grid, Vec2 start, Vec2 end, float radius, BlockVisitor visitor,
+    void* context);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, like
+/// blockGridVisitBySweptCircle, but without changing the grid, so that many threads can query it at once. Blocks
+/// which overlap many cells are visited once for every cell.
+/// @param grid Pointer to the block grid.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the grid.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool blockGridVisitBySweptCircleReadOnly(const BlockGrid* grid, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context);
+/// @brief Frees a block grid object.
+/// @param grid Pointer to the block grid.
+void blockGridFree(BlockGrid* grid);
@@ -0,0 +1,26 @@
+/// @file block_visitor.h
+/// @brief Callback type used by the spatial structures to hand out the blocks they find one by one.
+
+#pragma once
+
+#include <stdbool.h>
+
+#include "entities.h"
+#include "vector.h"
+
+/// @brief Function called for every block found by a query. The structure being queried must not be modified
+/// from inside of it.
+/// @param block Pointer to the found block.
+/// @param context Pointer passed to the query by the caller.
+/// @return True to continue the query, false to stop it.
+typedef bool (*BlockVisitor)(const Block* block, void* context);
+
+/// @brief Block visitor which appends the found blocks to a vector of block pointers.
+/// @param block Pointer to the found block.
+/// @param context Pointer to the vector.
+/// @return Always true.
+static inline bool pushBackBlockVisitor(const Block* block, void* context)
+{
+    vectorPushBack((Vector*)context, &block, sizeof(const Block*));
+    return true;
+}
@@ -8,12 +8,13 @@
 #include <stdbool.h>
 #include <assert.h>
 
-#include "game_time.h"
 #include "helpers.h"
 #include "memory.h"
 #include "rendering.h"
 #include "game_state.h"
 #include "entities.h"
+#include "log.h"
+#include "thread.h"
 
 #include "defines.h"
 
@@ -157,16 +158,13 @@ static const char* getLevelStr(unsigned int level)
     }
 }
 
-static Block* createBlocks(unsigned int level, size_t* blockCount)
+static Block* createBlocks(const char* levelStr, const LevelData* levelData, size_t* blockCount)
 {
-    const char* levelStr = getLevelStr(level);
-    LevelData levelData = getLevelData(levelStr);
-
     *blockCount = 0;
-    Block* blocks = checkedMalloc(sizeof(Block) * levelData.blockCount);
+    Block* blocks = checkedCalloc(levelData->blockCount, sizeof(Block));
 
-    float gridCellHeight = (float)COORDINATE_SPACE / (float)levelData.gridRowCount;
-    float gridCellWidth = (float)COORDINATE_SPACE / (float)levelData.gridColCount;
+    float gridCellHeight = (float)COORDINATE_SPACE / (float)levelData->gridRowCount;
+    float gridCellWidth = (float)COORDINATE_SPACE / (float)levelData->gridColCount;
     float blockWidth = gridCellWidth - BLOCK_HORIZONTAL_PADDING * 2.0f;
     float blockHeight = gridCellHeight - BLOCK_VERTICAL_PADDING * 2.0f;
 
@@ -180,7 +178,7 @@ static Block* createBlocks(unsigned int level, size_t* blockCount)
             blocks[(*blockCount)++] = (Block) {
                 .position = {
                     .x = (float)col * gridCellWidth + BLOCK_HORIZONTAL_PADDING,
-                    .y = (float)(levelData.gridRowCount - row) * gridCellHeight - BLOCK_VERTICAL_PADDING,
+                    .y = (float)(levelData->gridRowCount - row) * gridCellHeight - BLOCK_VERTICAL_PADDING,
                 },
                 .width = blockWidth,
                 .height = blockHeight,
@@ -201,34 +199,181 @@ static Block* createBlocks(unsigned int level, size_t* blockCount)
     return blocks;
 }
 
-static QuadTree createBlocksQuadTree(const Block* blocks, size_t blockCount)
+// FORCED_SPATIAL_INDEX is set with the SPATIAL_INDEX CMake option, otherwise the index is picked per level
+static SpatialIndexType getLevelSpatialIndexType(const LevelData* levelData)
+{
+#ifdef FORCED_SPATIAL_INDEX
+    (void)levelData;
+    return FORCED_SPATIAL_INDEX;
+#else
+    // blocks loaded from level files never straddle the cells of the level grid, so a grid with the same
+    // layout finds them without descending a tree
+    if (levelData->gridColCount > 0 && levelData->gridRowCount > 0)
+        return SPATIAL_INDEX_GRID;
+
+    // blocks placed freely would straddle the quadrants of a quad tree and be stored in many of its leaves, but
+    // every level file has a grid, so for now the BVH only runs when it's forced with the SPATIAL_INDEX option
+    return SPATIAL_INDEX_BVH;
+#endif
+}
+
+static SpatialIndex createBlocksIndex(const LevelData* levelData, const Block* blocks, size_t blockCount)
+{
+    SpatialIndexDesc desc = {
+        .type = getLevelSpatialIndexType(levelData),
+        .bounds = {
+            .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+            .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f, }
+        },
+        .gridColCount = levelData->gridColCount,
+        .gridRowCount = levelData->gridRowCount,
+    };
+
+    return spatialIndexCreate(&desc, blocks, blockCount);
+}
+
+// returns true if the blocks which the ball can touch at this point were covered by the last lookup, no matter
+// which way the ball went since then
+static bool pointInsideCachedArea(const Board* board, Vec2 point)
+{
+    Vec2 difference = subVecs(point, board->cacheCenter);
+    return dot(difference, difference) <= powf(BALL_BROADPHASE_CACHE_MARGIN, 2.0f);
+}
+
+// gathers the blocks which the ball can touch while it stays within the cache margin of its current position
+static void cacheBlocksAroundBall(Board* board, const Ball* ball)
+{
+    board->cacheCenter = ball->position;
+
+    vectorClear(&board->cachedBlocks);
+    spatialIndexRetrieveAllBySweptCircle(&board->blocksIndex, board->cacheCenter, board->cacheCenter,
+        ball->radius + BALL_BROADPHASE_CACHE_MARGIN, &board->cachedBlocks);
+
+    size_t cachedCount = vectorSize(&board->cachedBlocks, sizeof(const Block*));
+    boundsSoAClear(&board->cachedBlockBounds);
+
+    for (size_t i = 0; i < cachedCount; i++)
+    {
+        const Block* block = *(const Block**)vectorGet(&board->cachedBlocks, i, sizeof(const Block*));
+        boundsSoAPushBack(&board->cachedBlockBounds, getBlockRectBounds(block));
+    }
+}
+
+#ifdef LOG_QUAD_TREE_STATS
+static void logQuadTreeStats(const SpatialIndex* index)
+{
+    if (index->type != SPATIAL_INDEX_QUAD_TREE)
+        return;
+
+    QuadTreeStats stats = quadTreeGetStats(&index->quadTree);
+    logNotification("[Quad Tree]: %zu blocks, %zu nodes, %zu leaves (%zu overflow), depth %zu.\n",
+        index->quadTree.elemCount, stats.nodeCount, stats.leafCount, stats.overflowLeafCount, stats.depth);
+}
+#endif
+
+#ifdef QUAD_TREE_STATS_CSV
+// appends a line to the file, starting it with the header if the file is new
+static void writeQuadTreeStatsCsv(const SpatialIndex* index, unsigned int level)
+{
+    if (index->type != SPATIAL_INDEX_QUAD_TREE)
+        return;
+
+    FILE* file = fopen(QUAD_TREE_STATS_CSV, "a");
+
+    if (!file)
+    {
+        logWarning("[Quad Tree]: Could not open %s to write the stats.\n", QUAD_TREE_STATS_CSV);
+        return;
+    }
+
+    if (ftell(file) == 0)
+        quadTreeWriteStatsCsvHeader(file);
+
+    char label[32];
+    snprintf(label, sizeof(label), "level%u", level);
+    quadTreeWriteStatsCsv(&index->quadTree, label, file);
+    fclose(file);
+}
+#endif
+
+// returns bounds which cover all of the blocks, or empty bounds which nothing overlaps if there are none
+static RectBounds getBlocksBounds(const Block* blocks, size_t blockCount)
 {
-    QuadTree tree = quadTreeCreate((RectBounds) {
-        .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
-        .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f, }
-    });
+    RectBounds bounds = {
+        .topLeft = { .x = FLT_MAX, .y = -FLT_MAX },
+        .bottomRight = { .x = -FLT_MAX, .y = FLT_MAX },
+    };
 
     for (size_t i = 0; i < blockCount; i++)
-        quadTreeInsert(&tree, &blocks[i]);
+    {
+        RectBounds blockBounds = getBlockRectBounds(&blocks[i]);
+        bounds.topLeft.x = min(bounds.topLeft.x, blockBounds.topLeft.x);
+        bounds.topLeft.y = max(bounds.topLeft.y, blockBounds.topLeft.y);
+        bounds.bottomRight.x = max(bounds.bottomRight.x, blockBounds.bottomRight.x);
+        bounds.bottomRight.y = min(bounds.bottomRight.y, blockBounds.bottomRight.y);
+    }
 
-    return tree;
+    return bounds;
 }
 
+typedef struct PaddleMotion PaddleMotion;
+
+// a share of the balls which are moved contact to contact, the board is only read while they're moved, the blocks
+// they hit are destroyed once all of the workers are done, the workers are kept by the board between the steps
+typedef struct NarrowphaseWorker
+{
+    Board* board;
+    const PaddleMotion* paddleMotion;
+    float deltaTime;
+    const uint32_t* balls;
+    size_t ballCount;
+    Vector hitBlocks; // const Block*, in the order they were hit
+    BroadphaseCacheStats cacheStats;
+    GameState* state; // set when the balls are moved on the calling thread, which destroys the blocks right away
+    Renderer* renderer;
+} NarrowphaseWorker;
+
 void initBoard(Board* board, unsigned int level)
 {
     board->paddle = createPaddle((Vec2){ .x = PADDLE_START_POS_X, .y = PADDLE_START_POS_Y }, PADDLE_WIDTH,
         PADDLE_HEIGHT);
-    board->blocksStorage = createBlocks(level, &board->initialBlockCount);
-    board->blocksQuadTree = createBlocksQuadTree(board->blocksStorage, board->initialBlockCount);
-    board->ball = createBall((Vec2){ .x = BALL_START_POS_X, .y = BALL_START_POS_Y }, BALL_RADIUS,
+    board->paddleVelocity = 0.0f;
+    const char* levelStr = getLevelStr(level);
+    LevelData levelData = getLevelData(levelStr);
+
+    board->blocksStorage = createBlocks(levelStr, &levelData, &board->initialBlockCount);
+    board->blocksIndex = createBlocksIndex(&levelData, board->blocksStorage, board->initialBlockCount);
+    board->level = level;
+#ifdef LOG_QUAD_TREE_STATS
+    if (board->blocksIndex.type == SPATIAL_INDEX_QUAD_TREE)
+        quadTreePrintStats(&board->blocksIndex.quadTree, stdout);
+#endif
+    board->blocksBounds = getBlocksBounds(board->blocksStorage, board->initialBlockCount);
+
+    Ball ball = createBall((Vec2){ .x = BALL_START_POS_X, .y = BALL_START_POS_Y }, BALL_RADIUS,
         (Vec2){ .x = BALL_LAUNCH_DIRECTION_X, .y = BALL_LAUNCH_DIRECTION_Y }, 0.0f);
-    board->tmpRetrievedBlocksStorage = vectorCreate();
+    board->balls = ballSoACreate();
+    ballSoAPushBack(&board->balls, &ball);
+
+    board->cacheStats = (BroadphaseCacheStats){ 0 };
+    board->cachedBlocks = vectorCreate();
+    board->cachedBlockBounds = boundsSoACreate();
+    cacheBlocksAroundBall(board, &ball);
+
+    board->pendingBalls = vectorCreate();
+    board->narrowphaseWorkers = vectorCreate();
 }
 
-void moveBall(Ball* ball)
+void addBalls(Board* board, size_t count)
 {
-    ball->position.x += ball->direction.x * ball->speed * subStepDeltaTime;
-    ball->position.y += ball->direction.y * ball->speed * subStepDeltaTime;
+    Ball ball = ballSoAGet(&board->balls, 0);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // none of the directions is horizontal, so that no ball can bounce between the side walls forever
+        ball.direction = vecFromAngle((float)MATH_PI * ((float)i + 0.5f) / (float)count);
+        ballSoAPushBack(&board->balls, &ball);
+    }
 }
 
 static void flipBallDirectionOnAxis(Axis axis, Ball* ball)
@@ -244,93 +389,653 @@ static void flipBallDirectionOnAxis(Axis axis, Ball* ball)
     }
 }
 
-static void collideBallWithWalls(Ball* ball)
+static float getPaddleBounceAngle(const Block* paddle, Vec2 collisionPoint)
+{
+    // divide the angle based on where the collision happened
+    // for example divide by half if the ball collided with the paddle on a point
+    // 3/4 of the way through from the starting to the ending edge of the paddle
+    // (because it's 1/2 of the way through from the middle of the paddle to the end)
+    float multiplier = (paddle->position.x + paddle->width - collisionPoint.x) / paddle->width;
+    float minAngle = (float)MIN_BALL_BOUNCE_ANGLE_OFF_PADDLE;
+    float maxAngle = (float)MATH_PI - (float)MIN_BALL_BOUNCE_ANGLE_OFF_PADDLE;
+    float angle = (float)MATH_PI * multiplier;
+    return clamp(minAngle, maxAngle, angle);
+}
+
+static void eraseCachedBlock(Board* board, const Block* block)
+{
+    size_t cachedCount = vectorSize(&board->cachedBlocks, sizeof(const Block*));
+
+    for (size_t i = 0; i < cachedCount; i++)
+    {
+        if (*(const Block**)vectorGet(&board->cachedBlocks, i, sizeof(const Block*)) == block)
+        {
+            vectorErase(&board->cachedBlocks, i, sizeof(const Block*));
+            boundsSoAErase(&board->cachedBlockBounds, i);
+            return;
+        }
+    }
+}
+
+// casts the ball only at the cached blocks, the caller makes sure that the whole path lies in the cached area
+static bool castBallAtCachedBlocks(const Board* board, const Ball* ball, float maxDistance, BlockCastHit* hit)
+{
+    size_t cachedCount = vectorSize(&board->cachedBlocks, sizeof(const Block*));
+    bool found = false;
+    hit->distance = maxDistance;
+
+    // the circle around the whole path picks the blocks worth casting at, a batch at a time
+    Vec2 middle = addVecs(ball->position, scalar(ball->direction, maxDistance / 2.0f));
+    float pathRadius = ball->radius + maxDistance / 2.0f;
+
+    for (size_t first = 0; first < cachedCount; first += MAX_BOUNDS_PER_HIT_MASK)
+    {
+        size_t count = min(cachedCount - first, (size_t)MAX_BOUNDS_PER_HIT_MASK);
+        uint32_t mask = getBoundsSoACircleHitMask(&board->cachedBlockBounds, first, count, middle, pathRadius);
+
+        for (size_t i = first; mask; i++, mask >>= 1)
+        {
+            if (!(mask & 1u))
+                continue;
+
+            const Block* block = *(const Block**)vectorGet(&board->cachedBlocks, i, sizeof(const Block*));
+            RectBounds bounds = getBlockRectBounds(block);
+            float distance;
+            Vec2 normal;
+
+            if (castCircleAtBounds(ball->position, ball->direction, ball->radius, &bounds, hit->distance,
+                    &distance, &normal)
+                && distance < hit->distance)
+            {
+                *hit = (BlockCastHit){ .block = block, .distance = distance, .normal = normal };
+                found = true;
+            }
+        }
+    }
+
+    return found;
+}
+
+#if defined(_DEBUG) || defined(CHECK_BROADPHASE_CACHE)
+// compares the block hit among the cached ones with the one found by casting through the spatial index
+static bool cachedCastMatchesIndex(const Board* board, const Ball* ball, float maxDistance, bool found,
+    const BlockCastHit* hit)
 {
-    if (ball->position.y + ball->radius > COORDINATE_SPACE)
-        flipBallDirectionOnAxis(AXIS_VERTICAL, ball);
-    else if (ball->position.x - ball->radius < 0.0f)
-        flipBallDirectionOnAxis(AXIS_HORIZONTAL, ball);
-    else if (ball->position.x + ball->radius > COORDINATE_SPACE)
-        flipBallDirectionOnAxis(AXIS_HORIZONTAL, ball);
+    BlockCastHit indexHit;
+    bool indexFound = spatialIndexCircleCast(&board->blocksIndex, ball->position, ball->direction, ball->radius,
+        maxDistance, &indexHit);
 
-    // TODO: position correction
+    return found == indexFound && (!found || fabsf(hit->distance - indexHit.distance) <= BALL_CONTACT_SKIN);
 }
+#endif
 
-// returns true if there was a collision
-static bool collideBallWithBlock(Ball* ball, const Block* block)
+#ifdef LOG_BROADPHASE_STATS
+static void logBroadphaseStats(const BroadphaseCacheStats* stats)
 {
-    Vec2 collisionPoint = getClosestPointOnBlock(ball, block);
-    Vec2 difference = subVecs(ball->position, collisionPoint);
-    float distSquared = dot(difference, difference);
+    size_t checkCount = stats->hitCount + stats->missCount;
+    double hitRate = checkCount > 0 ? (double)stats->hitCount / (double)checkCount * 100.0 : 0.0;
+    logNotification("[Broadphase]: %zu collision checks, %zu cache hits (%.2f%%), %zu spatial index queries.\n",
+        checkCount, stats->hitCount, hitRate, stats->missCount);
+}
+#endif
 
-    if (distSquared < powf(ball->radius, 2.0f))
+// the cache is only moved between steps, around the first ball, so that the whole path of the ball in the step
+// lies in it unless the ball can move further than the cache margin, and it doesn't change while the balls are
+// cast at it
+static void moveBlocksCache(Board* board, float deltaTime)
+{
+    Ball ball = ballSoAGet(&board->balls, 0);
+    float reach = vecLength(subVecs(ball.position, board->cacheCenter)) + ball.speed * deltaTime;
+
+    if (reach > BALL_BROADPHASE_CACHE_MARGIN)
+        cacheBlocksAroundBall(board, &ball);
+}
+
+// finds the first block which the ball touches within maxDistance, it only reads the board, so many balls can
+// be cast at once
+static bool castBallAtBlocks(const Board* board, const Ball* ball, float maxDistance, BlockCastHit* hit,
+    BroadphaseCacheStats* cacheStats)
+{
+    Vec2 end = addVecs(ball->position, scalar(ball->direction, maxDistance));
+
+    // the cached area is round, so the whole path lies in it if both of its ends do, bounces don't matter and
+    // destroyed blocks are erased from the cache, so it stays exact
+    if (!pointInsideCachedArea(board, ball->position) || !pointInsideCachedArea(board, end))
     {
-        Vec2 normal = normalize(difference);
-        reflectBall(ball, normal);
-        return true;
+        cacheStats->missCount++;
+        return spatialIndexCircleCast(&board->blocksIndex, ball->position, ball->direction, ball->radius,
+            maxDistance, hit);
     }
 
-    return false;
+    cacheStats->hitCount++;
+    bool found = castBallAtCachedBlocks(board, ball, maxDistance, hit);
+    // the tests count the casts which disagree, debug builds stop at the first one
+#ifdef CHECK_BROADPHASE_CACHE
+    cacheStats->mismatchCount += !cachedCastMatchesIndex(board, ball, maxDistance, found, hit);
+#elif defined(_DEBUG)
+    assert(cachedCastMatchesIndex(board, ball, maxDistance, found, hit)
+        && "Cache and spatial index disagree on the first block the ball hits");
+#endif
+    return found;
 }
 
-static float getPaddleBounceAngle(const Block* paddle, Vec2 collisionPoint)
+// blocks hit by a few balls in the same step are only destroyed once
+static void destroyBlock(GameState* state, Board* board, Renderer* renderer, const Block* block)
 {
-    // divide the angle based on where the collision happened
-    // for example divide by half if the ball collided with the paddle on a point
-    // 3/4 of the way through from the starting to the ending edge of the paddle
-    // (because it's 1/2 of the way through from the middle of the paddle to the end)
-    float multiplier = (paddle->position.x + paddle->width - collisionPoint.x) / paddle->width;
-    float minAngle = (float)MIN_BALL_BOUNCE_ANGLE_OFF_PADDLE;
-    float maxAngle = (float)MATH_PI - (float)MIN_BALL_BOUNCE_ANGLE_OFF_PADDLE;
-    float angle = (float)MATH_PI * multiplier;
-    return clamp(minAngle, maxAngle, angle);
+    size_t blockIndex = (size_t)(block - board->blocksStorage);
+
+    if (!spatialIndexRemoveBlock(&board->blocksIndex, block))
+        return;
+
+    eraseCachedBlock(board, block);
+#ifdef LOG_QUAD_TREE_STATS
+    logQuadTreeStats(&board->blocksIndex);
+#endif
+    moveBlockOutOfView(&renderer->gameRenderer, blockIndex);
+
+    state->boardCleared = spatialIndexElemCount(&board->blocksIndex) == 0;
+
+    state->points += POINTS_PER_BLOCK_DESTROYED;
+    updateHudPointsText(&renderer->hudRenderer, state->points);
+}
+
+typedef enum BallBounceType
+{
+    BALL_BOUNCE_NONE,
+    BALL_BOUNCE_WALL,
+    BALL_BOUNCE_PADDLE,
+    BALL_BOUNCE_BLOCK,
+} BallBounceType;
+
+// returns true if the ball touches one of the walls within maxDistance, along with the axis it bounces on
+static bool castBallAtWalls(const Ball* ball, float maxDistance, float* distance, Axis* axis)
+{
+    bool found = false;
+    *distance = maxDistance;
+
+    if (ball->direction.y > 0.0f)
+    {
+        float wallDistance = max(((float)COORDINATE_SPACE - ball->radius - ball->position.y) / ball->direction.y,
+            0.0f);
+
+        if (wallDistance <= *distance)
+        {
+            *distance = wallDistance;
+            *axis = AXIS_VERTICAL;
+            found = true;
+        }
+    }
+
+    if (ball->direction.x != 0.0f)
+    {
+        float wallX = ball->direction.x < 0.0f ? ball->radius : (float)COORDINATE_SPACE - ball->radius;
+        float wallDistance = max((wallX - ball->position.x) / ball->direction.x, 0.0f);
+
+        if (wallDistance <= *distance)
+        {
+            *distance = wallDistance;
+            *axis = AXIS_HORIZONTAL;
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+// the paddle stops at the walls, so it only moves while it's heading away from them
+static float getPaddleVelocity(const Board* board)
+{
+    const Block* paddle = &board->paddle;
+
+    if ((board->paddleVelocity < 0.0f && paddle->position.x <= 0.0f)
+        || (board->paddleVelocity > 0.0f && paddle->position.x + paddle->width >= COORDINATE_SPACE))
+    {
+        return 0.0f;
+    }
+
+    return board->paddleVelocity;
+}
+
+// the balls are moved one after another over a whole step, each of them against the whole motion of the paddle,
+// which moves with a constant velocity until it stops at a wall
+struct PaddleMotion
+{
+    float startX;
+    float velocity;
+    float stopTime;
+    float stopX;
+};
+
+static PaddleMotion getPaddleMotion(const Board* board)
+{
+    float velocity = getPaddleVelocity(board);
+    PaddleMotion motion = {
+        .startX = board->paddle.position.x,
+        .velocity = velocity,
+        .stopTime = 0.0f,
+        .stopX = board->paddle.position.x,
+    };
+
+    if (velocity != 0.0f)
+    {
+        motion.stopX = velocity < 0.0f ? 0.0f : (float)COORDINATE_SPACE - board->paddle.width;
+        motion.stopTime = (motion.stopX - motion.startX) / velocity;
+    }
+
+    return motion;
+}
+
+// the paddle is put right at the wall once it stops, so that it doesn't stop a rounding error short of it
+static inline float getPaddlePositionAt(const PaddleMotion* motion, float time)
+{
+    return time < motion->stopTime ? motion->startX + motion->velocity * time : motion->stopX;
+}
+
+static inline float getPaddleVelocityAt(const PaddleMotion* motion, float time)
+{
+    return time < motion->stopTime ? motion->velocity : 0.0f;
+}
+
+// the first thing which happens to the ball within a step
+typedef struct BoardContact
+{
+    BallBounceType type;
+    float time;
+    Axis wallAxis;
+    BlockCastHit blockHit;
+} BoardContact;
+
+// every contact is found a skin short of the touching point, so that the ball never starts a cast touching
+// something it's about to hit again
+static inline float getContactTime(float distance, float speed)
+{
+    return max(distance - BALL_CONTACT_SKIN, 0.0f) / speed;
+}
+
+static BoardContact findFirstContact(const Board* board, const Ball* ball, const Block* paddle,
+    float paddleVelocity, float maxTime, BroadphaseCacheStats* cacheStats)
+{
+    BoardContact contact = {
+        .type = BALL_BOUNCE_NONE,
+        .time = maxTime,
+        .wallAxis = AXIS_VERTICAL,
+    };
+
+    float wallDistance;
+    Axis wallAxis;
+
+    if (castBallAtWalls(ball, ball->speed * contact.time, &wallDistance, &wallAxis))
+    {
+        contact.type = BALL_BOUNCE_WALL;
+        contact.time = getContactTime(wallDistance, ball->speed);
+        contact.wallAxis = wallAxis;
+    }
+
+    // the paddle is cast at as if it stood still and the ball moved with the difference of their velocities
+    Vec2 paddleVelocityVec = { .x = paddleVelocity, .y = 0.0f };
+    Vec2 relativeVelocity = subVecs(scalar(ball->direction, ball->speed), paddleVelocityVec);
+    float relativeSpeed = vecLength(relativeVelocity);
+    RectBounds paddleBounds = getBlockRectBounds(paddle);
+    float paddleDistance;
+    Vec2 paddleNormal;
+
+    if (relativeSpeed > 0.0f
+        && castCircleAtBounds(ball->position, scalar(relativeVelocity, 1.0f / relativeSpeed), ball->radius,
+            &paddleBounds, relativeSpeed * contact.time, &paddleDistance, &paddleNormal)
+        && getContactTime(paddleDistance, relativeSpeed) < contact.time)
+    {
+        contact.type = BALL_BOUNCE_PADDLE;
+        contact.time = getContactTime(paddleDistance, relativeSpeed);
+    }
+
+    BlockCastHit blockHit;
+
+    if (castBallAtBlocks(board, ball, ball->speed * contact.time, &blockHit, cacheStats)
+        && getContactTime(blockHit.distance, ball->speed) < contact.time)
+    {
+        contact.type = BALL_BOUNCE_BLOCK;
+        contact.time = getContactTime(blockHit.distance, ball->speed);
+        contact.blockHit = blockHit;
+    }
+
+    return contact;
+}
+
+// moves the ball from one contact to the next, so nothing can be skipped over no matter how fast it moves, and
+// the cost only grows with the number of contacts
+static void moveBallToContacts(NarrowphaseWorker* worker, Ball* ball)
+{
+    const Board* board = worker->board;
+    const PaddleMotion* paddleMotion = worker->paddleMotion;
+    float deltaTime = worker->deltaTime;
+
+    float time = 0.0f;
+
+    for (size_t contactCount = 0; time < deltaTime; contactCount++)
+    {
+        // the rest of the step is dropped rather than letting the ball move past something it didn't look for
+        if (contactCount == MAX_BALL_CONTACTS_PER_STEP)
+            break;
+
+        Block paddle = board->paddle;
+        paddle.position.x = getPaddlePositionAt(paddleMotion, time);
+        float paddleVelocity = getPaddleVelocityAt(paddleMotion, time);
+
+        // the paddle changes its velocity when it stops, so the ball is cast up to that point first
+        float endTime = paddleVelocity != 0.0f ? min(paddleMotion->stopTime, deltaTime) : deltaTime;
+
+        BoardContact contact = findFirstContact(board, ball, &paddle, paddleVelocity, endTime - time,
+            &worker->cacheStats);
+        ball->position = addVecs(ball->position, scalar(ball->direction, ball->speed * contact.time));
+        time = contact.type == BALL_BOUNCE_NONE ? endTime : time + contact.time;
+
+        switch (contact.type)
+        {
+        case BALL_BOUNCE_WALL:
+            flipBallDirectionOnAxis(contact.wallAxis, ball);
+            break;
+        case BALL_BOUNCE_PADDLE:
+            paddle.position.x = getPaddlePositionAt(paddleMotion, time);
+            ball->direction = vecFromAngle(getPaddleBounceAngle(&paddle, getClosestPointOnBlock(ball, &paddle)));
+            break;
+        case BALL_BOUNCE_BLOCK:
+            reflectBall(ball, contact.blockHit.normal);
+
+            if (worker->state)
+                destroyBlock(worker->state, worker->board, worker->renderer, contact.blockHit.block);
+            else
+                vectorPushBack(&worker->hitBlocks, &contact.blockHit.block, sizeof(const Block*));
+
+            break;
+        case BALL_BOUNCE_NONE:
+            break;
+        }
+    }
+}
+
+static void runNarrowphaseWorker(void* arg)
+{
+    NarrowphaseWorker* worker = arg;
+
+    // every ball belongs to a single worker, so they're written back without locking
+    BallSoA* balls = &worker->board->balls;
+
+    for (size_t i = 0; i < worker->ballCount; i++)
+    {
+        Ball ball = ballSoAGet(balls, worker->balls[i]);
+        moveBallToContacts(worker, &ball);
+        ballSoASet(balls, worker->balls[i], &ball);
+    }
+}
+
+// the threads are only started once a step has many balls to move, and then wait for the next such steps until
+// the level is over
+static void startNarrowphasePool(Board* board)
+{
+    size_t threadCount = NARROWPHASE_THREAD_COUNT > 0 ? NARROWPHASE_THREAD_COUNT : getHardwareThreadCount();
+    board->narrowphasePool = threadPoolCreate(threadCount);
+    vectorReserve(&board->narrowphaseWorkers, threadCount, sizeof(NarrowphaseWorker));
+
+    for (size_t i = 0; i < threadCount; i++)
+    {
+        NarrowphaseWorker worker = { .board = board, .hitBlocks = vectorCreate() };
+        vectorPushBack(&board->narrowphaseWorkers, &worker, sizeof(NarrowphaseWorker));
+    }
+}
+
+// a few balls are moved one after another on the calling thread, many are split into contiguous shares, and the
+// results are merged in the order of the workers, so the blocks are destroyed in the same order no matter how many
+// threads there are
+static void moveBallsToContacts(GameState* state, Board* board, Renderer* renderer,
+    const PaddleMotion* paddleMotion, float deltaTime)
+{
+    size_t ballCount = vectorSize(&board->pendingBalls, sizeof(uint32_t));
+    const uint32_t* balls = board->pendingBalls.data;
+
+    if (ballCount < PARALLEL_NARROWPHASE_MIN_BALLS)
+    {
+        NarrowphaseWorker worker = {
+            .board = board,
+            .paddleMotion = paddleMotion,
+            .deltaTime = deltaTime,
+            .balls = balls,
+            .ballCount = ballCount,
+            .hitBlocks = vectorCreate(),
+            .cacheStats = { 0 },
+            .state = state,
+            .renderer = renderer,
+        };
+
+        runNarrowphaseWorker(&worker);
+        board->cacheStats.hitCount += worker.cacheStats.hitCount;
+        board->cacheStats.missCount += worker.cacheStats.missCount;
+        board->cacheStats.mismatchCount += worker.cacheStats.mismatchCount;
+        return;
+    }
+
+    if (vectorSize(&board->narrowphaseWorkers, sizeof(NarrowphaseWorker)) == 0)
+        startNarrowphasePool(board);
+
+    NarrowphaseWorker* workers = board->narrowphaseWorkers.data;
+    size_t workerCount = min(vectorSize(&board->narrowphaseWorkers, sizeof(NarrowphaseWorker)), ballCount);
+
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        size_t first = ballCount * i / workerCount;
+
+        workers[i].board = board;
+        workers[i].paddleMotion = paddleMotion;
+        workers[i].deltaTime = deltaTime;
+        workers[i].balls = balls + first;
+        workers[i].ballCount = ballCount * (i + 1) / workerCount - first;
+        workers[i].cacheStats = (BroadphaseCacheStats){ 0 };
+        vectorClear(&workers[i].hitBlocks);
+    }
+
+    threadPoolRun(&board->narrowphasePool, runNarrowphaseWorker, workers, sizeof(NarrowphaseWorker), workerCount);
+
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        board->cacheStats.hitCount += workers[i].cacheStats.hitCount;
+        board->cacheStats.missCount += workers[i].cacheStats.missCount;
+        board->cacheStats.mismatchCount += workers[i].cacheStats.mismatchCount;
+
+        const Block** hitBlocks = workers[i].hitBlocks.data;
+
+        for (size_t j = 0; j < vectorSize(&workers[i].hitBlocks, sizeof(const Block*)); j++)
+            destroyBlock(state, board, renderer, hitBlocks[j]);
+    }
+}
+
+static RectBounds inflateRectBounds(RectBounds bounds, float margin)
+{
+    bounds.topLeft.x -= margin;
+    bounds.topLeft.y += margin;
+    bounds.bottomRight.x += margin;
+    bounds.bottomRight.y -= margin;
+    return bounds;
+}
+
+// the balls whose paths over the whole step keep a skin away from the walls, the paddle and the blocks can't
+// touch anything, so they're moved together without being cast, only the others are moved contact to contact
+static void moveBalls(GameState* state, Board* board, Renderer* renderer, const PaddleMotion* paddleMotion,
+    float deltaTime)
+{
+    // the board is open at the bottom
+    RectBounds area = {
+        .topLeft = { .x = BALL_CONTACT_SKIN, .y = (float)COORDINATE_SPACE - BALL_CONTACT_SKIN },
+        .bottomRight = { .x = (float)COORDINATE_SPACE - BALL_CONTACT_SKIN, .y = -FLT_MAX },
+    };
+
+    Block endPaddle = board->paddle;
+    endPaddle.position.x = getPaddlePositionAt(paddleMotion, deltaTime);
+    RectBounds paddleBounds = getBlockRectBounds(&board->paddle);
+    RectBounds endPaddleBounds = getBlockRectBounds(&endPaddle);
+    paddleBounds.topLeft.x = min(paddleBounds.topLeft.x, endPaddleBounds.topLeft.x);
+    paddleBounds.bottomRight.x = max(paddleBounds.bottomRight.x, endPaddleBounds.bottomRight.x);
+
+    // the blocks only ever disappear, so the bounds of the ones the level started with cover the rest of them
+    RectBounds obstacles[] = {
+        inflateRectBounds(paddleBounds, BALL_CONTACT_SKIN),
+        inflateRectBounds(board->blocksBounds, BALL_CONTACT_SKIN),
+    };
+
+    size_t ballCount = ballSoASize(&board->balls);
+    vectorClear(&board->pendingBalls);
+    moveBlocksCache(board, deltaTime);
+
+    for (size_t first = 0; first < ballCount; first += MAX_BALLS_PER_MOVE_MASK)
+    {
+        size_t count = min(ballCount - first, (size_t)MAX_BALLS_PER_MOVE_MASK);
+        uint32_t movedMask = ballSoAMoveClear(&board->balls, first, count, deltaTime, &area, obstacles,
+            sizeof(obstacles) / sizeof(obstacles[0]));
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (movedMask & (1u << i))
+                continue;
+
+            uint32_t ball = (uint32_t)(first + i);
+            vectorPushBack(&board->pendingBalls, &ball, sizeof(uint32_t));
+        }
+    }
+
+    moveBallsToContacts(state, board, renderer, paddleMotion, deltaTime);
 }
 
-static void collideBallWithPaddle(Ball* ball, const Block* paddle)
+// balls which fell out of the board are erased, apart from the last one, which ends the game
+static void eraseBallsOutOfBounds(Board* board)
 {
-    Vec2 collisionPoint = getClosestPointOnBlock(ball, paddle);
-    Vec2 difference = subVecs(ball->position, collisionPoint);
-    float distSquared = dot(difference, difference);
+    for (size_t i = ballSoASize(&board->balls); i-- > 0 && ballSoASize(&board->balls) > 1;)
+    {
+        Ball ball = ballSoAGet(&board->balls, i);
 
-    if (distSquared < powf(ball->radius, 2.0f))
+        if (ballOutOfBounds(&ball))
+            ballSoASwapErase(&board->balls, i);
+    }
+}
+
+void simulateBoard(GameState* state, Board* board, Renderer* renderer, float deltaTime)
+{
+    ballSoAStorePreviousPositions(&board->balls);
+    PaddleMotion paddleMotion = getPaddleMotion(board);
+
+    if (!state->ballLaunched)
     {
-        float angle = getPaddleBounceAngle(paddle, collisionPoint);
-        ball->direction = vecFromAngle(angle);
+        board->paddle.position.x = getPaddlePositionAt(&paddleMotion, deltaTime);
+        ballSoASetFloat(&board->balls.positionX, 0, board->paddle.position.x + board->paddle.width / 2.0f);
+        return;
     }
+
+    moveBalls(state, board, renderer, &paddleMotion, deltaTime);
+    board->paddle.position.x = getPaddlePositionAt(&paddleMotion, deltaTime);
+    eraseBallsOutOfBounds(board);
 }
 
-void collideBall(GameState* state, Board* board, Renderer* renderer)
+size_t predictBallTrajectory(const Board* board, size_t maxBounces, float maxDistance, Vec2* points)
 {
-    vectorClear(&board->tmpRetrievedBlocksStorage);
-    quadTreeRetrieveAllByBounds(&board->blocksQuadTree, getBallRectBounds(&board->ball),
-        &board->tmpRetrievedBlocksStorage);
-    size_t retrievedCount = vectorSize(&board->tmpRetrievedBlocksStorage, sizeof(const Block*));
+    Ball ball = ballSoAGet(&board->balls, 0);
+    PaddleMotion paddleMotion = getPaddleMotion(board);
+    BroadphaseCacheStats cacheStats = { 0 }; // the board only counts its own steps
+    float endTime = maxDistance / ball.speed;
+    float time = 0.0f;
+    size_t pointCount = 0;
+
+    points[pointCount++] = ball.position;
 
-    collideBallWithWalls(&board->ball);
-    collideBallWithPaddle(&board->ball, &board->paddle);
+    if (ball.speed == 0.0f)
+        return pointCount;
 
-    for (size_t i = 0; i < retrievedCount; i++)
+    // the ball is moved from one contact to the next the same way as in moveBallToContacts, so the path only
+    // differs from the one in the game once the paddle changes its velocity or a destroyed block is hit again
+    for (size_t bounceCount = 0;;)
     {
-        const Block* blockPtr = *(const Block**)vectorGet(&board->tmpRetrievedBlocksStorage, i,
-            sizeof(const Block*));
+        Block paddle = board->paddle;
+        paddle.position.x = getPaddlePositionAt(&paddleMotion, time);
+        float paddleVelocity = getPaddleVelocityAt(&paddleMotion, time);
+
+        // the path ends once the ball falls out of the board
+        float castEndTime = endTime;
+
+        if (ball.direction.y < 0.0f)
+        {
+            float fallDistance = max((ball.position.y + ball.radius) / -ball.direction.y, 0.0f);
+            castEndTime = min(castEndTime, time + fallDistance / ball.speed);
+        }
+
+        // the paddle changes its velocity when it stops, so the ball is cast up to that point first
+        bool paddleStops = paddleVelocity != 0.0f && paddleMotion.stopTime < castEndTime;
+
+        if (paddleStops)
+            castEndTime = paddleMotion.stopTime;
+
+        BoardContact contact = findFirstContact(board, &ball, &paddle, paddleVelocity, castEndTime - time,
+            &cacheStats);
+        ball.position = addVecs(ball.position, scalar(ball.direction, ball.speed * contact.time));
+        time = contact.type == BALL_BOUNCE_NONE ? castEndTime : time + contact.time;
 
-        if (collideBallWithBlock(&board->ball, blockPtr))
+        if (contact.type == BALL_BOUNCE_NONE)
         {
-            size_t blockIndex = (size_t)(blockPtr - board->blocksStorage);
-            quadTreeRemoveBlock(&board->blocksQuadTree, blockPtr);
-            moveBlockOutOfView(&renderer->gameRenderer, blockIndex);
+            if (paddleStops)
+                continue;
 
-            state->boardCleared = board->blocksQuadTree.elemCount == 0;
+            points[pointCount++] = ball.position;
+            break;
+        }
+
+        points[pointCount++] = ball.position;
 
-            state->points += POINTS_PER_BLOCK_DESTROYED;
-            updateHudPointsText(&renderer->hudRenderer, state->points);
+        if (bounceCount++ == maxBounces)
+            break;
+
+        switch (contact.type)
+        {
+        case BALL_BOUNCE_WALL:
+            flipBallDirectionOnAxis(contact.wallAxis, &ball);
+            break;
+        case BALL_BOUNCE_PADDLE:
+            paddle.position.x = getPaddlePositionAt(&paddleMotion, time);
+            ball.direction = vecFromAngle(getPaddleBounceAngle(&paddle, getClosestPointOnBlock(&ball, &paddle)));
+            break;
+        case BALL_BOUNCE_BLOCK:
+            reflectBall(&ball, contact.blockHit.normal);
+            break;
+        case BALL_BOUNCE_NONE:
+            break;
         }
     }
+
+    return pointCount;
 }
 
 void freeBoard(Board* board)
 {
-    quadTreeFree(&board->blocksQuadTree);
+    // the query counters cover the whole level only once it's over
+#ifdef LOG_QUAD_TREE_STATS
+    if (board->blocksIndex.type == SPATIAL_INDEX_QUAD_TREE)
+        quadTreePrintStats(&board->blocksIndex.quadTree, stdout);
+#endif
+#ifdef QUAD_TREE_STATS_CSV
+    writeQuadTreeStatsCsv(&board->blocksIndex, board->level);
+#endif
+    spatialIndexFree(&board->blocksIndex);
     free(board->blocksStorage);
-    vectorFree(&board->tmpRetrievedBlocksStorage);
+#ifdef LOG_BROADPHASE_STATS
+    logBroadphaseStats(&board->cacheStats);
+#endif
+    ballSoAFree(&board->balls);
+    vectorFree(&board->cachedBlocks);
+    vectorFree(&board->pendingBalls);
+
+    // the pool was only started if a step had many balls to move
+    if (vectorSize(&board->narrowphaseWorkers, sizeof(NarrowphaseWorker)) > 0)
+        threadPoolFree(&board->narrowphasePool);
+
+    NarrowphaseWorker* workers = board->narrowphaseWorkers.data;
+
+    for (size_t i = 0; i < vectorSize(&board->narrowphaseWorkers, sizeof(NarrowphaseWorker)); i++)
+        vectorFree(&workers[i].hitBlocks);
+
+    vectorFree(&board->narrowphaseWorkers);
+    boundsSoAFree(&board->cachedBlockBounds);
 }
@@ -7,8 +7,11 @@
 #include <stddef.h>
 #include <stdbool.h>
 
+#include "ball_soa.h"
+#include "bounds_soa.h"
 #include "entities.h"
-#include "quad_tree.h"
+#include "spatial_index.h"
+#include "thread.h"
 #include "defines.h"
 
 /// @brief Forward declaration of Renderer struct.
@@ -24,17 +27,35 @@ typedef enum Axis
     AXIS_HORIZONTAL,
 } Axis;
 
+/// @brief Counters of the broadphase cache, which show how often the blocks around the ball are looked up in the
+/// spatial index.
+typedef struct BroadphaseCacheStats
+{
+    size_t hitCount; // collision checks answered by the cached blocks
+    size_t missCount; // collision checks which had to query the spatial index
+    size_t mismatchCount; // cached checks the spatial index disagreed with, only kept with CHECK_BROADPHASE_CACHE
+} BroadphaseCacheStats;
+
 /// @brief Structure representing the game board.
 typedef struct Board
 {
     Block paddle;
-    QuadTree blocksQuadTree;
+    float paddleVelocity; // horizontal, set from the input, the paddle stops at the walls on its own
+    unsigned int level; // level whose blocks the board was initialized with
+    SpatialIndex blocksIndex;
     size_t initialBlockCount;
-    Ball ball;
+    BallSoA balls; // the first one is launched off the paddle, the others are added in chaos mode
+    BroadphaseCacheStats cacheStats;
 
     // PRIVATE
     Block* blocksStorage;
-    Vector tmpRetrievedBlocksStorage;
+    RectBounds blocksBounds; // bounds of all the blocks the level started with
+    Vector cachedBlocks; // blocks which a ball can touch while it's closer than the cache margin to cacheCenter
+    BoundsSoA cachedBlockBounds; // bounds of the cached blocks in the same order
+    Vec2 cacheCenter;
+    Vector pendingBalls; // uint32_t, balls which have to be moved contact to contact in the current step
+    ThreadPool narrowphasePool; // threads among which many balls moved contact to contact are split
+    Vector narrowphaseWorkers; // the share of the balls of every thread of the pool, empty until it's started
 } Board;
 
 /// @brief Normalize a coordinate from the game coordinate space to the OpenGL coordinate space.
@@ -72,15 +93,48 @@ void initBoard(Board* board, unsigned int level);
 /// @return True if the ball is out of bounds, false otherwise.
 static inline bool ballOutOfBounds(const Ball* ball) { return ball->position.y + ball->radius < 0.0f; }
 
-/// @brief Move the ball based on its velocity.
-/// @param ball The ball to move.
-void moveBall(Ball* ball);
+/// @brief Check if all of the balls fell out of the board. Balls which fall out of it are erased, apart from the
+/// last one.
+/// @param board The game board.
+/// @return True if there's no ball left in the board, false otherwise.
+static inline bool allBallsOutOfBounds(const Board* board)
+{
+    Ball firstBall = ballSoAGet(&board->balls, 0);
+    return ballSoASize(&board->balls) == 1 && ballOutOfBounds(&firstBall);
+}
 
-/// @brief Handle the collision of the ball with the game board and other elements.
+/// @brief Add balls at the position of the first ball, moving with its speed in directions spread evenly over
+/// the upper half of the circle.
+/// @param board The game board.
+/// @param count The number of balls to add.
+void addBalls(Board* board, size_t count);
+
+/// @brief Move the paddle and the balls over a period of time. Balls whose paths can't reach the walls, the
+/// paddle or the blocks are moved together, the others are moved from one contact with the walls, the moving
+/// paddle or the blocks to the next, found by casting them along their paths, so they can't pass through anything
+/// however fast they go. Fewer than PARALLEL_NARROWPHASE_MIN_BALLS of them are moved one after another on the
+/// calling thread, and the blocks they hit are destroyed right away. More of them are split between
+/// NARROWPHASE_THREAD_COUNT threads, which are started with the first such step and wait for the next ones. Blocks
+/// hit in such a step are only destroyed at its end, in the same order for any number of threads, so every ball
+/// sees the blocks as they were when the step started and a few balls can bounce off the same block. Balls which
+/// fall out of the board are erased. Before the first ball is launched, it follows the paddle.
 /// @param state The current game state.
 /// @param board The game board.
 /// @param renderer The renderer.
-void collideBall(GameState* state, Board* board, Renderer* renderer);
+/// @param deltaTime The period of time to simulate.
+void simulateBoard(GameState* state, Board* board, Renderer* renderer, float deltaTime);
+
+/// @brief Predict the path of the first ball, following its reflections off the walls, the paddle and the blocks
+/// the same way simulateBoard does. The paddle is assumed to keep its current velocity until it stops at a wall,
+/// so the path matches the game as long as the input doesn't change. The board isn't changed, so blocks hit on the
+/// way stay in it. A ball which wasn't launched yet doesn't move, so its path is only its position.
+/// @param board The board on which the ball moves.
+/// @param maxBounces The number of reflections after which the prediction stops.
+/// @param maxDistance The length of the predicted path.
+/// @param points Array of at least maxBounces + 2 points, filled with the position of the ball, its positions at
+/// every reflection and at the end of the path.
+/// @return The number of points written.
+size_t predictBallTrajectory(const Board* board, size_t maxBounces, float maxDistance, Vec2* points);
 
 /// @brief Free the resources used by the board.
 /// @param board The board to free.
@@ -0,0 +1,200 @@
+/// @file bounds_soa.h
+/// @brief Rectangle bounds stored as a structure of arrays, so that a circle can be tested against four of them
+/// at once with SSE.
+
+#pragma once
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __SSE__
+#include <xmmintrin.h>
+#endif
+
+#include "entities.h"
+#include "vec.h"
+#include "vector.h"
+
+/// @brief Maximum number of bounds which can be tested in a single call to getCircleBoundsHitMask.
+#define MAX_BOUNDS_PER_HIT_MASK 32
+
+/// @brief Growable list of rectangle bounds with every coordinate kept in a separate array.
+typedef struct BoundsSoA
+{
+    Vector minX; // float
+    Vector minY; // float
+    Vector maxX; // float
+    Vector maxY; // float
+} BoundsSoA;
+
+/// @brief Tests a circle against four bounds stored in separate coordinate arrays. Uses the same closest point
+/// test as the ball collisions, so a set bit means that the ball collides with the bounds.
+/// @param minX Array of four left edges.
+/// @param minY Array of four bottom edges.
+/// @param maxX Array of four right edges.
+/// @param maxY Array of four top edges.
+/// @param center Center of the circle.
+/// @param radius Radius of the circle.
+/// @return Bitmask with the bit i set if the circle overlaps the bounds i.
+static inline uint32_t getCircleBoundsGroupHitMask(const float* minX, const float* minY, const float* maxX,
+    const float* maxY, Vec2 center, float radius)
+{
+#ifdef __SSE__
+    __m128 centerX = _mm_set1_ps(center.x);
+    __m128 centerY = _mm_set1_ps(center.y);
+    __m128 closestX = _mm_max_ps(_mm_loadu_ps(minX), _mm_min_ps(centerX, _mm_loadu_ps(maxX)));
+    __m128 closestY = _mm_max_ps(_mm_loadu_ps(minY), _mm_min_ps(centerY, _mm_loadu_ps(maxY)));
+    __m128 differenceX = _mm_sub_ps(centerX, closestX);
+    __m128 differenceY = _mm_sub_ps(centerY, closestY);
+    __m128 distSquared = _mm_add_ps(_mm_mul_ps(differenceX, differenceX), _mm_mul_ps(differenceY, differenceY));
+
+    return (uint32_t)_mm_movemask_ps(_mm_cmplt_ps(distSquared, _mm_set1_ps(radius * radius)));
+#else
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        Vec2 difference = {
+            .x = center.x - clamp(minX[i], maxX[i], center.x),
+            .y = center.y - clamp(minY[i], maxY[i], center.y),
+        };
+
+        if (dot(difference, difference) < radius * radius)
+            mask |= 1u << i;
+    }
+
+    return mask;
+#endif
+}
+
+/// @brief Tests other bounds against four bounds stored in separate coordinate arrays. Bounds which only touch
+/// each other don't overlap.
+/// @param minX Array of four left edges.
+/// @param minY Array of four bottom edges.
+/// @param maxX Array of four right edges.
+/// @param maxY Array of four top edges.
+/// @param bounds Pointer to the bounds tested against all four.
+/// @return Bitmask with the bit i set if the bounds overlap the bounds i.
+static inline uint32_t getBoundsGroupOverlapMask(const float* minX, const float* minY, const float* maxX,
+    const float* maxY, const RectBounds* bounds)
+{
+#ifdef __SSE__
+    __m128 overlapX = _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(bounds->topLeft.x), _mm_loadu_ps(maxX)),
+        _mm_cmpgt_ps(_mm_set1_ps(bounds->bottomRight.x), _mm_loadu_ps(minX)));
+    __m128 overlapY = _mm_and_ps(_mm_cmplt_ps(_mm_set1_ps(bounds->bottomRight.y), _mm_loadu_ps(maxY)),
+        _mm_cmpgt_ps(_mm_set1_ps(bounds->topLeft.y), _mm_loadu_ps(minY)));
+
+    return (uint32_t)_mm_movemask_ps(_mm_and_ps(overlapX, overlapY));
+#else
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        if (bounds->topLeft.x < maxX[i] && bounds->bottomRight.x > minX[i] && bounds->bottomRight.y < maxY[i]
+            && bounds->topLeft.y > minY[i])
+        {
+            mask |= 1u << i;
+        }
+    }
+
+    return mask;
+#endif
+}
+
+/// @brief Tests a circle against bounds stored in separate coordinate arrays, see getCircleBoundsGroupHitMask.
+/// @param minX Array of left edges.
+/// @param minY Array of bottom edges.
+/// @param maxX Array of right edges.
+/// @param maxY Array of top edges.
+/// @param count Number of bounds to test, at most MAX_BOUNDS_PER_HIT_MASK.
+/// @param center Center of the circle.
+/// @param radius Radius of the circle.
+/// @return Bitmask with the bit i set if the circle overlaps the bounds i.
+static inline uint32_t getCircleBoundsHitMask(const float* minX, const float* minY, const float* maxX,
+    const float* maxY, size_t count, Vec2 center, float radius)
+{
+    assert(count <= MAX_BOUNDS_PER_HIT_MASK);
+
+    uint32_t mask = 0;
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+        mask |= getCircleBoundsGroupHitMask(&minX[i], &minY[i], &maxX[i], &maxY[i], center, radius) << i;
+
+    // whatever didn't fill a whole group
+    for (; i < count; i++)
+    {
+        Vec2 difference = {
+            .x = center.x - clamp(minX[i], maxX[i], center.x),
+            .y = center.y - clamp(minY[i], maxY[i], center.y),
+        };
+
+        if (dot(difference, difference) < radius * radius)
+            mask |= 1u << i;
+    }
+
+    return mask;
+}
+
+static inline BoundsSoA boundsSoACreate()
+{
+    return (BoundsSoA) {
+        .minX = vectorCreate(),
+        .minY = vectorCreate(),
+        .maxX = vectorCreate(),
+        .maxY = vectorCreate(),
+    };
+}
+
+static inline size_t boundsSoASize(const BoundsSoA* bounds)
+{
+    return vectorSize(&bounds->minX, sizeof(float));
+}
+
+static inline void boundsSoAPushBack(BoundsSoA* bounds, RectBounds rect)
+{
+    vectorPushBack(&bounds->minX, &rect.topLeft.x, sizeof(float));
+    vectorPushBack(&bounds->minY, &rect.bottomRight.y, sizeof(float));
+    vectorPushBack(&bounds->maxX, &rect.bottomRight.x, sizeof(float));
+    vectorPushBack(&bounds->maxY, &rect.topLeft.y, sizeof(float));
+}
+
+static inline void boundsSoAErase(BoundsSoA* bounds, size_t index)
+{
+    vectorErase(&bounds->minX, index, sizeof(float));
+    vectorErase(&bounds->minY, index, sizeof(float));
+    vectorErase(&bounds->maxX, index, sizeof(float));
+    vectorErase(&bounds->maxY, index, sizeof(float));
+}
+
+static inline void boundsSoAClear(BoundsSoA* bounds)
+{
+    vectorClear(&bounds->minX);
+    vectorClear(&bounds->minY);
+    vectorClear(&bounds->maxX);
+    vectorClear(&bounds->maxY);
+}
+
+/// @brief Tests a circle against a range of bounds in a BoundsSoA, see getCircleBoundsHitMask.
+/// @param bounds Pointer to the bounds.
+/// @param first Index of the first bounds to test.
+/// @param count Number of bounds to test, at most MAX_BOUNDS_PER_HIT_MASK.
+/// @param center Center of the circle.
+/// @param radius Radius of the circle.
+/// @return Bitmask with the bit i set if the circle overlaps the bounds first + i.
+static inline uint32_t getBoundsSoACircleHitMask(const BoundsSoA* bounds, size_t first, size_t count,
+    Vec2 center, float radius)
+{
+    return getCircleBoundsHitMask(vectorGet(&bounds->minX, first, sizeof(float)),
+        vectorGet(&bounds->minY, first, sizeof(float)), vectorGet(&bounds->maxX, first, sizeof(float)),
+        vectorGet(&bounds->maxY, first, sizeof(float)), count, center, radius);
+}
+
+static inline void boundsSoAFree(BoundsSoA* bounds)
+{
+    vectorFree(&bounds->minX);
+    vectorFree(&bounds->minY);
+    vectorFree(&bounds->maxX);
+    vectorFree(&bounds->maxY);
+}
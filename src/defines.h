@@ -20,8 +20,14 @@
 #define WINDOW_WIDTH 800
 #define WINDOW_HEIGHT 800
 
-#define DELTA_TIME_LIMIT 0.035f
-#define SIMULATION_SUB_STEPS 16
+// frames longer than this, like the ones spent in a debugger, are cut short, so the simulation doesn't run a
+// burst of ticks to catch up with them
+#define DELTA_TIME_LIMIT 0.25f
+// simulation ticks per second, can be set at build time with the SIMULATION_TICK_RATE CMake option
+#ifndef SIMULATION_TICK_RATE
+#define SIMULATION_TICK_RATE 120
+#endif
+#define SIMULATION_TICK_TIME (1.0f / (float)SIMULATION_TICK_RATE)
 
 #define COORDINATE_SCALING (COORDINATE_SPACE / 1000.0f)
 
@@ -37,10 +43,20 @@
 #define BALL_START_POS_Y (PADDLE_START_POS_Y + BALL_RADIUS + FLT_EPSILON * 2.0f)
 #define BALL_LAUNCH_DIRECTION_X 0.0f
 #define BALL_LAUNCH_DIRECTION_Y 1.0f
-// ball speed should be higher than paddle speed for collisions to work properly
 #define BALL_LAUNCH_SPEED (600.0f * COORDINATE_SCALING)
 #define BALL_COLOR ((Vec4){ .r = 1.0f, .g = 1.0f, .b = 1.0f, .a = 1.0f })
 #define MIN_BALL_BOUNCE_ANGLE_OFF_PADDLE (5 * RADIANS_IN_DEG)
+// balls on the board in chaos mode, no more balls than this are ever drawn
+#define CHAOS_MODE_BALL_COUNT 4096
+// how far the ball can move away from the point where the blocks around it were looked up before it's done again
+#define BALL_BROADPHASE_CACHE_MARGIN (150.0f * COORDINATE_SCALING)
+// balls moved contact to contact in a step below which no threads are started for them
+#define PARALLEL_NARROWPHASE_MIN_BALLS 256
+// threads moving the balls contact to contact, 0 uses all of the hardware threads, can be set at build time with
+// the NARROWPHASE_THREAD_COUNT CMake option
+#ifndef NARROWPHASE_THREAD_COUNT
+#define NARROWPHASE_THREAD_COUNT 0
+#endif
 
 #ifdef _DEBUG
 #define STARTING_LEVEL 0
@@ -49,6 +65,10 @@
 #endif
 
 #define POINTS_PER_BLOCK_DESTROYED 10
+// the ball stops for the rest of a step once it has bounced this many times in it
+#define MAX_BALL_CONTACTS_PER_STEP 16
+// how far from the things it bounces off the ball stops, so that it doesn't start the next cast touching them
+#define BALL_CONTACT_SKIN (0.001f * COORDINATE_SCALING)
 
 #define BLOCK_CHAR '#'
 #define BLOCK_HORIZONTAL_PADDING (10.0f * COORDINATE_SCALING)
@@ -61,6 +81,7 @@
 #define MOVE_PADDLE_RIGHT_KEY_ALT       GLFW_KEY_RIGHT
 #define LAUNCH_BALL_KEY                 GLFW_KEY_SPACE
 #define RESTART_GAME_KEY                GLFW_KEY_SPACE
+#define CHAOS_MODE_KEY                  GLFW_KEY_C
 
 #define LAUNCH_BALL_CONTROLS_STR "Press SPACE to launch the ball."
 #define PADDLE_CONTROLS_STR "Use WASD or arrow keys to move the paddle."
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <float.h>
+#include <stdbool.h>
+
 #include "helpers.h"
 #include "vec.h"
 
@@ -62,6 +65,140 @@ static inline RectBounds getBallRectBounds(const Ball* ball)
     };
 }
 
+// bounds which only touch each other count as overlapping
+static inline bool rectBoundsOverlap(const RectBounds* a, const RectBounds* b)
+{
+    return a->topLeft.x <= b->bottomRight.x && a->bottomRight.x >= b->topLeft.x
+        && a->bottomRight.y <= b->topLeft.y && a->topLeft.y >= b->bottomRight.y;
+}
+
+// squared distance from a point to the closest point of the bounds, 0 if the point is inside of them
+static inline float getPointBoundsDistanceSquared(Vec2 point, const RectBounds* bounds)
+{
+    float dx = max(max(bounds->topLeft.x - point.x, point.x - bounds->bottomRight.x), 0.0f);
+    float dy = max(max(bounds->bottomRight.y - point.y, point.y - bounds->topLeft.y), 0.0f);
+
+    return dx * dx + dy * dy;
+}
+
+// limits the parameter range [tEnter, tExit] of a segment to the part inside of a slab, returns false if the
+// range became empty
+static inline bool clipSegmentToSlab(float start, float delta, float slabMin, float slabMax, float* tEnter,
+    float* tExit)
+{
+    if (delta == 0.0f)
+        return start >= slabMin && start <= slabMax;
+
+    float t1 = (slabMin - start) / delta;
+    float t2 = (slabMax - start) / delta;
+
+    *tEnter = max(*tEnter, min(t1, t2));
+    *tExit = min(*tExit, max(t1, t2));
+
+    return *tEnter <= *tExit;
+}
+
+// returns true if a circle moving from start to end can touch the bounds, the test is done against the bounds
+// grown by the radius, so it may pass near the corners even though the circle misses them
+static inline bool sweptCircleOverlapsBounds(Vec2 start, Vec2 end, float radius, const RectBounds* bounds)
+{
+    float tEnter = 0.0f;
+    float tExit = 1.0f;
+
+    return clipSegmentToSlab(start.x, end.x - start.x, bounds->topLeft.x - radius, bounds->bottomRight.x + radius,
+            &tEnter, &tExit)
+        && clipSegmentToSlab(start.y, end.y - start.y, bounds->bottomRight.y - radius, bounds->topLeft.y + radius,
+            &tEnter, &tExit);
+}
+
+/// @brief The first block touched by a circle or a ray cast along a straight line.
+typedef struct BlockCastHit
+{
+    const Block* block;
+    float distance; // distance travelled by the center until it touched the block
+    Vec2 normal; // points from the touched point of the block towards the center
+} BlockCastHit;
+
+// distances along a ray at which it enters and leaves a slab, returns false if the ray runs alongside the slab
+// outside of it
+static inline bool getRaySlabDistances(float origin, float direction, float slabMin, float slabMax, float* enter,
+    float* exit)
+{
+    if (direction == 0.0f)
+    {
+        *enter = -FLT_MAX;
+        *exit = FLT_MAX;
+        return origin >= slabMin && origin <= slabMax;
+    }
+
+    float t1 = (slabMin - origin) / direction;
+    float t2 = (slabMax - origin) / direction;
+
+    *enter = min(t1, t2);
+    *exit = max(t1, t2);
+
+    return true;
+}
+
+// returns true if a circle moving from the origin along a normalized direction touches the bounds within
+// maxDistance, the bounds are grown by the radius with rounded corners, so unlike sweptCircleOverlapsBounds the
+// test is exact, circles which already overlap the bounds at the origin don't hit them
+static inline bool castCircleAtBounds(Vec2 origin, Vec2 direction, float radius, const RectBounds* bounds,
+    float maxDistance, float* distance, Vec2* normal)
+{
+    float enterX, exitX, enterY, exitY;
+
+    if (!getRaySlabDistances(origin.x, direction.x, bounds->topLeft.x - radius, bounds->bottomRight.x + radius,
+            &enterX, &exitX)
+        || !getRaySlabDistances(origin.y, direction.y, bounds->bottomRight.y - radius, bounds->topLeft.y + radius,
+            &enterY, &exitY))
+    {
+        return false;
+    }
+
+    float enter = max(enterX, enterY);
+    float exit = min(exitX, exitY);
+
+    if (enter > exit || exit < 0.0f || enter > maxDistance)
+        return false;
+
+    Vec2 entry = addVecs(origin, scalar(direction, max(enter, 0.0f)));
+    Vec2 corner = {
+        .x = clamp(bounds->topLeft.x, bounds->bottomRight.x, entry.x),
+        .y = clamp(bounds->bottomRight.y, bounds->topLeft.y, entry.y),
+    };
+
+    // an entry next to a corner of the grown bounds only counts if the circle reaches the corner itself
+    if (corner.x != entry.x && corner.y != entry.y)
+    {
+        Vec2 toOrigin = subVecs(origin, corner);
+        float b = dot(toOrigin, direction);
+        float c = dot(toOrigin, toOrigin) - radius * radius;
+        float discriminant = b * b - c;
+
+        if (c <= 0.0f || b >= 0.0f || discriminant < 0.0f)
+            return false;
+
+        float t = -b - sqrtf(discriminant);
+
+        if (t > maxDistance)
+            return false;
+
+        *distance = t;
+        *normal = normalize(subVecs(addVecs(origin, scalar(direction, t)), corner));
+        return true;
+    }
+
+    if (enter < 0.0f)
+        return false;
+
+    *distance = enter;
+    *normal = enterX > enterY
+        ? (Vec2){ .x = direction.x > 0.0f ? -1.0f : 1.0f, .y = 0.0f }
+        : (Vec2){ .x = 0.0f, .y = direction.y > 0.0f ? -1.0f : 1.0f };
+    return true;
+}
+
 static inline RectBounds getBlockBorderRect(const Block* block)
 {
     return (RectBounds) {
@@ -21,7 +21,7 @@ void advanceLevel(Game* game)
     updateHudLevelText(&game->renderer.hudRenderer, game->state.level);
 
 #ifdef DRAW_QUAD_TREE
-    redrawQuadTree(&game->renderer.hudRenderer, &game->board.blocksQuadTree);
+    redrawQuadTree(&game->renderer.hudRenderer, &game->board.blocksIndex);
 #endif
 }
 
@@ -33,16 +33,13 @@ void freeGame(Game* game)
 
 void processGameInput(Game* game, GLFWwindow* window)
 {
-    processPaddleMovementInput(&game->board.paddle, window);
-    processBallLaunchInput(&game->state, &game->board.ball, &game->board.paddle, window);
+    processPaddleMovementInput(&game->board, window);
+    processBallLaunchInput(&game->state, &game->board, window);
+    processChaosModeInput(&game->state, &game->board, window);
 }
 
-void moveGameObjects(Game* game)
+void simulateGame(Game* game, float deltaTime)
 {
-    moveBall(&game->board.ball);
-}
-
-void collideGameObjects(Game* game)
-{
-    collideBall(&game->state, &game->board, &game->renderer);
+    simulateBoard(&game->state, &game->board, &game->renderer, deltaTime);
+    recordGameRenderState(&game->renderer.gameRenderer, &game->board);
 }
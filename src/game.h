@@ -17,7 +17,7 @@ typedef struct Game
 
 /// @brief Returns whether the game is over.
 /// @return True if game over, false otherwise.
-static inline bool gameOver(const Game* game) { return ballOutOfBounds(&game->board.ball); }
+static inline bool gameOver(const Game* game) { return allBallsOutOfBounds(&game->board); }
 
 /// @brief Initializes the game.
 /// @param game Pointer to the Game object which will be initialized by the function.
@@ -30,14 +30,13 @@ void advanceLevel(Game* game);
 /// @param game Pointer to the game object.
 void freeGame(Game* game);
 
-/// @brief Processes game input. Updates the paddle position or starts/restarts the game if the right key was
-/// pressed.
+/// @brief Processes game input. Updates the paddle position, starts/restarts the game or starts chaos mode if
+/// the right key was pressed.
 /// @param game Pointer to the game object.
 /// @param window Pointer to the window. Needed for input detection.
 void processGameInput(Game* game, GLFWwindow* window);
-/// @brief Moves game objects (the ball).
-/// @param Pointer to the game object.
-void moveGameObjects(Game* game);
-/// @brief Collides game objects and removes them from rendering data.
-/// @param Pointer to the game object.
-void collideGameObjects(Game* game);
+/// @brief Moves game objects (the paddle and the balls), collides them and removes destroyed blocks from
+/// rendering data.
+/// @param game Pointer to the game object.
+/// @param deltaTime The period of time to simulate.
+void simulateGame(Game* game, float deltaTime);
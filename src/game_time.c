@@ -1,4 +1,4 @@
 float prevTime;
 float currTime;
 float deltaTime;
-float subStepDeltaTime;
+float accumulatedTime;
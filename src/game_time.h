@@ -3,6 +3,8 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 
+#include <stdbool.h>
+
 #include "helpers.h"
 
 #include "defines.h"
@@ -10,11 +12,12 @@
 extern float prevTime;
 extern float currTime;
 extern float deltaTime;
-extern float subStepDeltaTime;
+extern float accumulatedTime; // time which has passed but which no simulation tick has covered yet
 
 static inline void initTime()
 {
     currTime = (float)glfwGetTime();
+    accumulatedTime = 0.0f;
 }
 
 static inline void updateTime()
@@ -22,5 +25,22 @@ static inline void updateTime()
     prevTime = currTime;
     currTime = (float)glfwGetTime();
     deltaTime = min(currTime - prevTime, DELTA_TIME_LIMIT);
-    subStepDeltaTime = deltaTime / SIMULATION_SUB_STEPS;
+    accumulatedTime += deltaTime;
+}
+
+// returns true and takes a tick's worth of time off the accumulator if there's enough time for another tick,
+// the simulation is run in ticks of SIMULATION_TICK_TIME no matter how long the frames take
+static inline bool consumeSimulationTick()
+{
+    if (accumulatedTime < SIMULATION_TICK_TIME)
+        return false;
+
+    accumulatedTime -= SIMULATION_TICK_TIME;
+    return true;
+}
+
+// how far into the next tick the rendered frame is, from 0 right at the last tick to just below 1
+static inline float getSimulationAlpha()
+{
+    return accumulatedTime / SIMULATION_TICK_TIME;
 }
@@ -2,8 +2,6 @@
 
 #include <stdbool.h>
 
-#include "game_time.h"
-
 #include "defines.h"
 
 static inline bool movePaddleLeftKeyPressed(GLFWwindow* window)
@@ -18,31 +16,42 @@ static inline bool movePaddleRightKeyPressed(GLFWwindow* window)
         || glfwGetKey(window, MOVE_PADDLE_RIGHT_KEY_ALT) == GLFW_PRESS;
 }
 
-void processPaddleMovementInput(Block* paddle, GLFWwindow* window)
+void processPaddleMovementInput(Board* board, GLFWwindow* window)
 {
+    board->paddleVelocity = 0.0f;
+
     if (movePaddleLeftKeyPressed(window))
-        paddle->position.x -= PADDLE_SPEED * subStepDeltaTime;
+        board->paddleVelocity -= PADDLE_SPEED;
 
     if (movePaddleRightKeyPressed(window))
-        paddle->position.x += PADDLE_SPEED * subStepDeltaTime;
-
-    if (paddle->position.x < 0.0f)
-        paddle->position.x = 0.0f;
-    else if (paddle->position.x + paddle->width > COORDINATE_SPACE)
-        paddle->position.x = COORDINATE_SPACE - paddle->width;
+        board->paddleVelocity += PADDLE_SPEED;
 }
 
-void processBallLaunchInput(GameState* state, Ball* ball, const Block* paddle, GLFWwindow* window)
+void processBallLaunchInput(GameState* state, Board* board, GLFWwindow* window)
 {
     if (!state->ballLaunched)
     {
+        Ball ball = ballSoAGet(&board->balls, 0);
+
         if (glfwGetKey(window, LAUNCH_BALL_KEY) == GLFW_PRESS)
         {
-            ball->speed = BALL_LAUNCH_SPEED;
+            ball.speed = BALL_LAUNCH_SPEED;
             state->ballLaunched = true;
             state->gameStarted = true;
         }
 
-        ball->position.x = paddle->position.x + paddle->width / 2.0f;
+        ball.position.x = board->paddle.position.x + board->paddle.width / 2.0f;
+        ballSoASet(&board->balls, 0, &ball);
+    }
+}
+
+void processChaosModeInput(const GameState* state, Board* board, GLFWwindow* window)
+{
+    size_t ballCount = ballSoASize(&board->balls);
+
+    if (state->ballLaunched && ballCount < CHAOS_MODE_BALL_COUNT
+        && glfwGetKey(window, CHAOS_MODE_KEY) == GLFW_PRESS)
+    {
+        addBalls(board, CHAOS_MODE_BALL_COUNT - ballCount);
     }
 }
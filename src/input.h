@@ -7,16 +7,22 @@
 #include <GLFW/glfw3.h>
 
 #include "game_state.h"
+#include "board.h"
 #include "entities.h"
 
 /// @brief Processes the input for launching the ball.
 /// @param state The current game state.
-/// @param ball The ball to be launched.
-/// @param paddle The paddle used to launch the ball.
+/// @param board The board whose first ball is launched off the paddle.
 /// @param window The GLFW window instance.
-void processBallLaunchInput(GameState* state, Ball* ball, const Block* paddle, GLFWwindow* window);
+void processBallLaunchInput(GameState* state, Board* board, GLFWwindow* window);
 
-/// @brief Processes the input for moving the paddle.
-/// @param paddle The paddle to be moved.
+/// @brief Processes the input for chaos mode, which fills the board with balls once the ball is launched.
+/// @param state The current game state.
+/// @param board The board to which the balls are added.
+/// @param window The GLFW window instance.
+void processChaosModeInput(const GameState* state, Board* board, GLFWwindow* window);
+
+/// @brief Processes the input for moving the paddle. The paddle is moved by simulateBoard.
+/// @param board The board whose paddle velocity is set.
 /// @param window The GLFW window instance.
-void processPaddleMovementInput(Block* paddle, GLFWwindow* window);
+void processPaddleMovementInput(Board* board, GLFWwindow* window);
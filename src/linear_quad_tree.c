@@ -0,0 +1,613 @@
+#include "linear_quad_tree.h"
+
+#include "memory.h"
+
+// Children are numbered in Morton order, the lower bit selects the right half and the upper bit selects the
+// top half of the parent
+#define BOTTOM_LEFT_CHILD_INDEX 0
+#define BOTTOM_RIGHT_CHILD_INDEX 1
+#define TOP_LEFT_CHILD_INDEX 2
+#define TOP_RIGHT_CHILD_INDEX 3
+
+#define CHILD_BIT(index) (1u << (index))
+
+// Nodes aren't stored anywhere, they only exist while the tree is being traversed
+typedef struct LinearQuadTreeNode
+{
+    uint32_t code;
+    uint8_t depth;
+    RectBounds bounds;
+} LinearQuadTreeNode;
+
+static inline LinearQuadTreeLeaf* getLeaf(const LinearQuadTree* quadTree, size_t index)
+{
+    return vectorGet(&quadTree->leaves, index, sizeof(LinearQuadTreeLeaf));
+}
+
+// number of codes at LINEAR_QUAD_TREE_MAX_DEPTH covered by a node at the given depth
+static inline uint32_t getNodeCodeSpan(uint8_t depth)
+{
+    return (uint32_t)1 << (2 * (LINEAR_QUAD_TREE_MAX_DEPTH - depth));
+}
+
+static inline Vec2 getMidpoint(const RectBounds* bounds)
+{
+    return (Vec2) {
+        .x = (bounds->topLeft.x + bounds->bottomRight.x) / 2.0f,
+        .y = (bounds->topLeft.y + bounds->bottomRight.y) / 2.0f,
+    };
+}
+
+static LinearQuadTreeNode getRootNode(const LinearQuadTree* quadTree)
+{
+    return (LinearQuadTreeNode) {
+        .code = 0,
+        .depth = 0,
+        .bounds = quadTree->bounds,
+    };
+}
+
+static LinearQuadTreeNode getChildNode(const LinearQuadTreeNode* node, unsigned int childIndex)
+{
+    Vec2 topLeft = node->bounds.topLeft;
+    Vec2 bottomRight = node->bounds.bottomRight;
+    Vec2 midpoint = getMidpoint(&node->bounds);
+
+    bool right = childIndex & 0x1;
+    bool top = childIndex & 0x2;
+
+    return (LinearQuadTreeNode) {
+        .code = node->code + childIndex * getNodeCodeSpan((uint8_t)(node->depth + 1)),
+        .depth = (uint8_t)(node->depth + 1),
+        .bounds = {
+            .topLeft = {
+                .x = right ? midpoint.x : topLeft.x,
+                .y = top ? topLeft.y : midpoint.y,
+            },
+            .bottomRight = {
+                .x = right ? bottomRight.x : midpoint.x,
+                .y = top ? midpoint.y : bottomRight.y,
+            },
+        },
+    };
+}
+
+// uses the same comparisons as the pointer based quad tree, so both trees split blocks the same way
+static uint8_t getChildrenByBounds(const LinearQuadTreeNode* node, const RectBounds* bounds)
+{
+    Vec2 midpoint = getMidpoint(&node->bounds);
+
+    bool left = bounds->topLeft.x < midpoint.x;
+    bool right = bounds->bottomRight.x > midpoint.x;
+    bool top = bounds->topLeft.y > midpoint.y;
+    bool bottom = bounds->bottomRight.y < midpoint.y;
+
+    uint8_t children = 0;
+
+    if (left && bottom)
+        children |= CHILD_BIT(BOTTOM_LEFT_CHILD_INDEX);
+
+    if (right && bottom)
+        children |= CHILD_BIT(BOTTOM_RIGHT_CHILD_INDEX);
+
+    if (left && top)
+        children |= CHILD_BIT(TOP_LEFT_CHILD_INDEX);
+
+    if (right && top)
+        children |= CHILD_BIT(TOP_RIGHT_CHILD_INDEX);
+
+    return children;
+}
+
+// returns the index of the first leaf in [first, last) whose code is not less than code
+static size_t lowerBoundLeaf(const LinearQuadTree* quadTree, size_t first, size_t last, uint32_t code)
+{
+    while (first < last)
+    {
+        size_t middle = first + (last - first) / 2;
+
+        if (*(const uint32_t*)vectorGet(&quadTree->leafCodes, middle, sizeof(uint32_t)) < code)
+            first = middle + 1;
+        else
+            last = middle;
+    }
+
+    return first;
+}
+
+// leaves of a node occupy the range [first, last), a node is a leaf if its range starts with a leaf of the same
+// depth, in which case the rest of the range contains its continuations
+static inline bool nodeIsLeaf(const LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t first)
+{
+    return getLeaf(quadTree, first)->depth == node->depth;
+}
+
+// splits the range of a node's leaves into ranges of its children, the range of the child i is
+// [childRanges[i], childRanges[i + 1])
+static void getChildRanges(const LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t first,
+    size_t last, size_t childRanges[5])
+{
+    uint32_t childSpan = getNodeCodeSpan((uint8_t)(node->depth + 1));
+
+    childRanges[0] = first;
+    childRanges[2] = lowerBoundLeaf(quadTree, first, last, node->code + 2 * childSpan);
+    childRanges[1] = lowerBoundLeaf(quadTree, first, childRanges[2], node->code + childSpan);
+    childRanges[3] = lowerBoundLeaf(quadTree, childRanges[2], last, node->code + 3 * childSpan);
+    childRanges[4] = last;
+}
+
+static void insertLeaf(LinearQuadTree* quadTree, size_t index, const LinearQuadTreeLeaf* leaf)
+{
+    vectorInsert(&quadTree->leaves, index, leaf, sizeof(LinearQuadTreeLeaf));
+    vectorInsert(&quadTree->leafCodes, index, &leaf->code, sizeof(uint32_t));
+}
+
+static void pushBackLeaf(LinearQuadTree* quadTree, const LinearQuadTreeLeaf* leaf)
+{
+    vectorPushBack(&quadTree->leaves, leaf, sizeof(LinearQuadTreeLeaf));
+    vectorPushBack(&quadTree->leafCodes, &leaf->code, sizeof(uint32_t));
+}
+
+static LinearQuadTreeLeaf createLeaf(uint32_t code, uint8_t depth)
+{
+    return (LinearQuadTreeLeaf) {
+        .code = code,
+        .depth = depth,
+        .blockCount = 0,
+    };
+}
+
+static inline uint32_t getBlockIndex(const LinearQuadTree* quadTree, const Block* block)
+{
+    return (uint32_t)(block - quadTree->blocks);
+}
+
+static size_t linearQuadTreeInsertImpl(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t first,
+    size_t last, uint32_t blockIndex, bool* inserted);
+
+// returns the number of leaves added to the array
+static size_t splitLeaf(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t index,
+    uint32_t blockIndex, bool* inserted)
+{
+    LinearQuadTreeLeaf oldLeaf = *getLeaf(quadTree, index);
+
+    // the first child has the same code as the split leaf
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        LinearQuadTreeNode child = getChildNode(node, i);
+        LinearQuadTreeLeaf childLeaf = createLeaf(child.code, child.depth);
+
+        if (i == 0)
+            *getLeaf(quadTree, index) = childLeaf;
+        else
+            insertLeaf(quadTree, index + i, &childLeaf);
+    }
+
+    size_t added = 3;
+
+    for (size_t i = 0; i < oldLeaf.blockCount; i++)
+    {
+        added += linearQuadTreeInsertImpl(quadTree, node, index, index + 1 + added, oldLeaf.blocks[i],
+            inserted);
+    }
+
+    added += linearQuadTreeInsertImpl(quadTree, node, index, index + 1 + added, blockIndex, inserted);
+    return added;
+}
+
+// returns the number of leaves added to the array
+static size_t addBlockToLeaf(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t first, size_t last,
+    uint32_t blockIndex, bool* inserted)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        LinearQuadTreeLeaf* leaf = getLeaf(quadTree, i);
+
+        if (leaf->blockCount < MAX_QUAD_TREE_NODE_BLOCKS)
+        {
+            leaf->blocks[leaf->blockCount++] = blockIndex;
+            *inserted = true;
+            return 0;
+        }
+    }
+
+    if (node->depth < LINEAR_QUAD_TREE_MAX_DEPTH)
+        return splitLeaf(quadTree, node, first, blockIndex, inserted);
+
+    LinearQuadTreeLeaf continuation = createLeaf(node->code, node->depth);
+    continuation.blocks[continuation.blockCount++] = blockIndex;
+    insertLeaf(quadTree, last, &continuation);
+    *inserted = true;
+
+    return 1;
+}
+
+static size_t linearQuadTreeInsertImpl(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t first,
+    size_t last, uint32_t blockIndex, bool* inserted)
+{
+    if (nodeIsLeaf(quadTree, node, first))
+        return addBlockToLeaf(quadTree, node, first, last, blockIndex, inserted);
+
+    RectBounds blockBounds = getBlockRectBounds(&quadTree->blocks[blockIndex]);
+    uint8_t children = getChildrenByBounds(node, &blockBounds);
+
+    size_t childRanges[5];
+    getChildRanges(quadTree, node, first, last, childRanges);
+
+    size_t added = 0;
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        if (!(children & CHILD_BIT(i)))
+            continue;
+
+        // leaves added to the previous children shift the ranges of the following ones
+        LinearQuadTreeNode child = getChildNode(node, i);
+        added += linearQuadTreeInsertImpl(quadTree, &child, childRanges[i] + added, childRanges[i + 1] + added,
+            blockIndex, inserted);
+    }
+
+    return added;
+}
+
+static void emitLeaves(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, const Vector* scratch,
+    size_t first, size_t count)
+{
+    LinearQuadTreeLeaf leaf = createLeaf(node->code, node->depth);
+
+    for (size_t i = first; i < first + count; i++)
+    {
+        uint32_t blockIndex = *(const uint32_t*)vectorGet(scratch, i, sizeof(uint32_t));
+
+        // only full leaves at the maximum depth are continued
+        if (leaf.blockCount == MAX_QUAD_TREE_NODE_BLOCKS)
+        {
+            pushBackLeaf(quadTree, &leaf);
+            leaf = createLeaf(node->code, node->depth);
+        }
+
+        leaf.blocks[leaf.blockCount++] = blockIndex;
+
+        if (queryStampsMark(&quadTree->blockQueryStamps, blockIndex))
+            quadTree->elemCount++;
+    }
+
+    pushBackLeaf(quadTree, &leaf);
+}
+
+// scratch holds the indices of the blocks inserted into the node in the range [first, first + count), the
+// result is the same as inserting the blocks one by one
+static void buildImpl(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, Vector* scratch, size_t first,
+    size_t count)
+{
+    if (count <= MAX_QUAD_TREE_NODE_BLOCKS || node->depth == LINEAR_QUAD_TREE_MAX_DEPTH)
+    {
+        emitLeaves(quadTree, node, scratch, first, count);
+        return;
+    }
+
+    // children are visited in Morton order, so the leaves are emitted already sorted
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        LinearQuadTreeNode child = getChildNode(node, i);
+        size_t childFirst = vectorSize(scratch, sizeof(uint32_t));
+
+        for (size_t j = first; j < first + count; j++)
+        {
+            uint32_t blockIndex = *(const uint32_t*)vectorGet(scratch, j, sizeof(uint32_t));
+            RectBounds blockBounds = getBlockRectBounds(&quadTree->blocks[blockIndex]);
+
+            if (getChildrenByBounds(node, &blockBounds) & CHILD_BIT(i))
+                vectorPushBack(scratch, &blockIndex, sizeof(uint32_t));
+        }
+
+        buildImpl(quadTree, &child, scratch, childFirst, vectorSize(scratch, sizeof(uint32_t)) - childFirst);
+        vectorResize(scratch, childFirst, sizeof(uint32_t));
+    }
+}
+
+LinearQuadTree linearQuadTreeCreate(RectBounds bounds, const Block* blocks, size_t blockCount)
+{
+    LinearQuadTree quadTree = {
+        .bounds = bounds,
+        .leaves = vectorCreate(),
+        .leafCodes = vectorCreate(),
+        .elemCount = 0,
+        .blocks = blocks,
+        .blockQueryStamps = queryStampsCreate(blockCount),
+    };
+
+    Vector scratch = vectorCreate();
+    vectorReserve(&scratch, blockCount * 2, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < (uint32_t)blockCount; i++)
+        vectorPushBack(&scratch, &i, sizeof(uint32_t));
+
+    queryStampsAdvance(&quadTree.blockQueryStamps);
+
+    LinearQuadTreeNode root = getRootNode(&quadTree);
+    buildImpl(&quadTree, &root, &scratch, 0, blockCount);
+
+    vectorFree(&scratch);
+
+    return quadTree;
+}
+
+bool linearQuadTreeInsert(LinearQuadTree* quadTree, const Block* block)
+{
+    bool inserted = false;
+
+    LinearQuadTreeNode root = getRootNode(quadTree);
+    linearQuadTreeInsertImpl(quadTree, &root, 0, linearQuadTreeLeafCount(quadTree),
+        getBlockIndex(quadTree, block), &inserted);
+
+    if (inserted)
+        quadTree->elemCount++;
+
+    return inserted;
+}
+
+static void removeBlockFromLeaf(LinearQuadTreeLeaf* leaf, uint32_t blockIndex, bool* removed)
+{
+    for (size_t i = 0; i < leaf->blockCount; i++)
+    {
+        if (leaf->blocks[i] == blockIndex)
+        {
+            eraseFromArr(leaf->blocks, i, leaf->blockCount, sizeof(uint32_t));
+            leaf->blockCount--;
+            *removed = true;
+            return;
+        }
+    }
+}
+
+static void linearQuadTreeRemoveBlockImpl(LinearQuadTree* quadTree, const LinearQuadTreeNode* node, size_t first,
+    size_t last, uint32_t blockIndex, const RectBounds* blockBounds, bool* removed)
+{
+    if (nodeIsLeaf(quadTree, node, first))
+    {
+        for (size_t i = first; i < last; i++)
+            removeBlockFromLeaf(getLeaf(quadTree, i), blockIndex, removed);
+
+        return;
+    }
+
+    uint8_t children = getChildrenByBounds(node, blockBounds);
+
+    size_t childRanges[5];
+    getChildRanges(quadTree, node, first, last, childRanges);
+
+    for (unsigned int i = 0; i < 4; i++)
+    {
+        if (!(children & CHILD_BIT(i)))
+            continue;
+
+        LinearQuadTreeNode child = getChildNode(node, i);
+        linearQuadTreeRemoveBlockImpl(quadTree, &child, childRanges[i], childRanges[i + 1], blockIndex,
+            blockBounds, removed);
+    }
+}
+
+bool linearQuadTreeRemoveBlock(LinearQuadTree* quadTree, const Block* block)
+{
+    bool removed = false;
+    RectBounds blockBounds = getBlockRectBounds(block);
+
+    LinearQuadTreeNode root = getRootNode(quadTree);
+    linearQuadTreeRemoveBlockImpl(quadTree, &root, 0, linearQuadTreeLeafCount(quadTree),
+        getBlockIndex(quadTree, block), &blockBounds, &removed);
+
+    if (removed)
+        quadTree->elemCount--;
+
+    return removed;
+}
+
+// a node waiting to be visited, together with the range of leaves it covers
+typedef struct LinearQuadTreeVisit
+{
+    LinearQuadTreeNode node;
+    size_t first;
+    size_t last;
+} LinearQuadTreeVisit;
+
+// returns false if the visitor stopped the query
+static bool visitLinearQuadTreeLeaves(LinearQuadTree* quadTree, size_t first, size_t last, BlockVisitor visitor,
+    void* context)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        const LinearQuadTreeLeaf* leaf = getLeaf(quadTree, i);
+
+        for (size_t j = 0; j < leaf->blockCount; j++)
+        {
+            if (!queryStampsMark(&quadTree->blockQueryStamps, leaf->blocks[j]))
+                continue;
+
+            if (!visitor(&quadTree->blocks[leaf->blocks[j]], context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+bool linearQuadTreeVisitByBounds(LinearQuadTree* quadTree, RectBounds bounds, BlockVisitor visitor,
+    void* context)
+{
+    queryStampsAdvance(&quadTree->blockQueryStamps);
+
+    // every visited node pushes at most four children in place of itself
+    LinearQuadTreeVisit stack[3 * LINEAR_QUAD_TREE_MAX_DEPTH + 1];
+    size_t stackSize = 0;
+
+    stack[stackSize++] = (LinearQuadTreeVisit) {
+        .node = getRootNode(quadTree),
+        .first = 0,
+        .last = linearQuadTreeLeafCount(quadTree),
+    };
+
+    while (stackSize > 0)
+    {
+        LinearQuadTreeVisit visit = stack[--stackSize];
+
+        if (nodeIsLeaf(quadTree, &visit.node, visit.first))
+        {
+            if (!visitLinearQuadTreeLeaves(quadTree, visit.first, visit.last, visitor, context))
+                return false;
+
+            continue;
+        }
+
+        uint8_t children = getChildrenByBounds(&visit.node, &bounds);
+
+        size_t childRanges[5];
+        getChildRanges(quadTree, &visit.node, visit.first, visit.last, childRanges);
+
+        // pushed in reverse, so that the children are visited in Morton order
+        for (unsigned int i = 4; i-- > 0;)
+        {
+            if (!(children & CHILD_BIT(i)))
+                continue;
+
+            stack[stackSize++] = (LinearQuadTreeVisit) {
+                .node = getChildNode(&visit.node, i),
+                .first = childRanges[i],
+                .last = childRanges[i + 1],
+            };
+        }
+    }
+
+    return true;
+}
+
+void linearQuadTreeRetrieveAllByBounds(LinearQuadTree* quadTree, RectBounds bounds, Vector* result)
+{
+    linearQuadTreeVisitByBounds(quadTree, bounds, pushBackBlockVisitor, result);
+}
+
+// returns false if the visitor stopped the query, without the stamps blocks stored in many leaves are visited
+// once for every leaf
+static bool visitLinearQuadTreeLeavesBySweptCircle(const LinearQuadTree* quadTree, QueryStamps* stamps,
+    size_t first, size_t last, Vec2 start, Vec2 end, float radius, BlockVisitor visitor, void* context)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        const LinearQuadTreeLeaf* leaf = getLeaf(quadTree, i);
+
+        for (size_t j = 0; j < leaf->blockCount; j++)
+        {
+            const Block* block = &quadTree->blocks[leaf->blocks[j]];
+            RectBounds blockBounds = getBlockRectBounds(block);
+
+            if (!sweptCircleOverlapsBounds(start, end, radius, &blockBounds)
+                || (stamps && !queryStampsMark(stamps, leaf->blocks[j])))
+            {
+                continue;
+            }
+
+            if (!visitor(block, context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+static bool visitLinearQuadTreeBySweptCircle(const LinearQuadTree* quadTree, QueryStamps* stamps, Vec2 start,
+    Vec2 end, float radius, BlockVisitor visitor, void* context)
+{
+    LinearQuadTreeVisit stack[3 * LINEAR_QUAD_TREE_MAX_DEPTH + 1];
+    size_t stackSize = 0;
+
+    stack[stackSize++] = (LinearQuadTreeVisit) {
+        .node = getRootNode(quadTree),
+        .first = 0,
+        .last = linearQuadTreeLeafCount(quadTree),
+    };
+
+    while (stackSize > 0)
+    {
+        LinearQuadTreeVisit visit = stack[--stackSize];
+
+        if (nodeIsLeaf(quadTree, &visit.node, visit.first))
+        {
+            if (!visitLinearQuadTreeLeavesBySweptCircle(quadTree, stamps, visit.first, visit.last, start, end,
+                radius, visitor, context))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        size_t childRanges[5];
+        getChildRanges(quadTree, &visit.node, visit.first, visit.last, childRanges);
+
+        for (unsigned int i = 4; i-- > 0;)
+        {
+            LinearQuadTreeNode child = getChildNode(&visit.node, i);
+
+            if (!sweptCircleOverlapsBounds(start, end, radius, &child.bounds))
+                continue;
+
+            stack[stackSize++] = (LinearQuadTreeVisit) {
+                .node = child,
+                .first = childRanges[i],
+                .last = childRanges[i + 1],
+            };
+        }
+    }
+
+    return true;
+}
+
+bool linearQuadTreeVisitBySweptCircle(LinearQuadTree* quadTree, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context)
+{
+    queryStampsAdvance(&quadTree->blockQueryStamps);
+    return visitLinearQuadTreeBySweptCircle(quadTree, &quadTree->blockQueryStamps, start, end, radius, visitor,
+        context);
+}
+
+bool linearQuadTreeVisitBySweptCircleReadOnly(const LinearQuadTree* quadTree, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context)
+{
+    return visitLinearQuadTreeBySweptCircle(quadTree, NULL, start, end, radius, visitor, context);
+}
+
+// extracts every other bit of a Morton code
+static uint32_t compactCodeBits(uint32_t code)
+{
+    code &= 0x55555555;
+    code = (code | (code >> 1)) & 0x33333333;
+    code = (code | (code >> 2)) & 0x0F0F0F0F;
+    code = (code | (code >> 4)) & 0x00FF00FF;
+    code = (code | (code >> 8)) & 0x0000FFFF;
+
+    return code;
+}
+
+RectBounds linearQuadTreeGetLeafBounds(const LinearQuadTree* quadTree, const LinearQuadTreeLeaf* leaf)
+{
+    float cellsPerSide = (float)(1u << LINEAR_QUAD_TREE_MAX_DEPTH);
+    float cellWidth = (quadTree->bounds.bottomRight.x - quadTree->bounds.topLeft.x) / cellsPerSide;
+    float cellHeight = (quadTree->bounds.topLeft.y - quadTree->bounds.bottomRight.y) / cellsPerSide;
+    float cellsInLeaf = (float)(1u << (LINEAR_QUAD_TREE_MAX_DEPTH - leaf->depth));
+
+    float left = quadTree->bounds.topLeft.x + (float)compactCodeBits(leaf->code) * cellWidth;
+    float bottom = quadTree->bounds.bottomRight.y + (float)compactCodeBits(leaf->code >> 1) * cellHeight;
+
+    return (RectBounds) {
+        .topLeft = { .x = left, .y = bottom + cellsInLeaf * cellHeight },
+        .bottomRight = { .x = left + cellsInLeaf * cellWidth, .y = bottom },
+    };
+}
+
+void linearQuadTreeFree(LinearQuadTree* quadTree)
+{
+    vectorFree(&quadTree->leaves);
+    vectorFree(&quadTree->leafCodes);
+    queryStampsFree(&quadTree->blockQueryStamps);
+    quadTree->elemCount = 0;
+}
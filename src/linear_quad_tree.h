@@ -0,0 +1,112 @@
+/// @file linear_quad_tree.h
+/// @brief A linear quad tree used as an alternative to the pointer based QuadTree. Only the leaves are stored,
+/// in a flat array sorted by their Morton codes. Node bounds are derived from the codes instead of being stored.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_visitor.h"
+#include "entities.h"
+#include "quad_tree.h"
+#include "query_stamps.h"
+#include "vector.h"
+
+/// @brief Depth at which linear quad tree leaves can no longer be split. Full leaves at this depth are
+/// continued in additional entries with the same code.
+#define LINEAR_QUAD_TREE_MAX_DEPTH 10
+
+/// @brief A linear quad tree leaf.
+typedef struct LinearQuadTreeLeaf
+{
+    uint32_t code; // Morton code of the leaf's bottom-left cell at LINEAR_QUAD_TREE_MAX_DEPTH
+    uint8_t depth;
+    uint8_t blockCount;
+    uint32_t blocks[MAX_QUAD_TREE_NODE_BLOCKS]; // indices into the block array
+} LinearQuadTreeLeaf;
+
+/// @brief Linear quad tree with the same semantics as QuadTree. Contains no pointers to its own storage, so
+/// the leaf array can be copied as is.
+typedef struct LinearQuadTree
+{
+    RectBounds bounds;
+    Vector leaves; // LinearQuadTreeLeaf, sorted by code
+    Vector leafCodes; // uint32_t, codes of the leaves kept apart to make binary searches cache friendly
+    size_t elemCount;
+
+    // PRIVATE
+    const Block* blocks;
+    QueryStamps blockQueryStamps; // used to skip blocks stored in many leaves
+} LinearQuadTree;
+
+/// @brief Returns the number of leaves in a linear quad tree.
+/// @param quadTree Pointer to the linear quad tree.
+/// @return Number of leaves.
+static inline size_t linearQuadTreeLeafCount(const LinearQuadTree* quadTree)
+{
+    return vectorSize(&quadTree->leaves, sizeof(LinearQuadTreeLeaf));
+}
+
+/// @brief Creates a linear quad tree and inserts all of the blocks into it at once.
+/// @param bounds The area which the quad tree will cover.
+/// @param blocks Array of blocks which will be inserted into the quad tree.
+/// @param blockCount Number of blocks in the array.
+/// @return Created linear quad tree.
+LinearQuadTree linearQuadTreeCreate(RectBounds bounds, const Block* blocks, size_t blockCount);
+/// @brief Inserts a block into the linear quad tree.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param block Pointer to the block. Has to come from the block array passed to linearQuadTreeCreate.
+/// @return True if the block was added to any of the leaves, false otherwise.
+bool linearQuadTreeInsert(LinearQuadTree* quadTree, const Block* block);
+/// @brief Removes a block from the linear quad tree.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param block Pointer to the block.
+/// @return True if the block was stored in the linear quad tree, false otherwise.
+bool linearQuadTreeRemoveBlock(LinearQuadTree* quadTree, const Block* block);
+/// @brief Calls a visitor for all the blocks which at least partially cover a certain area, without allocating
+/// any memory. Every block is visited at most once, even if it's stored in many leaves.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param visitor Function called for every found block. It must not modify the linear quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool linearQuadTreeVisitByBounds(LinearQuadTree* quadTree, RectBounds bounds, BlockVisitor visitor,
+    void* context);
+/// @brief Retrieves all the blocks which at least partially cover a certain area. Every block is retrieved
+/// at most once, even if it's stored in many leaves.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void linearQuadTreeRetrieveAllByBounds(LinearQuadTree* quadTree, RectBounds bounds, Vector* result);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, without
+/// allocating any memory. Every block is visited at most once.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the linear quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool linearQuadTreeVisitBySweptCircle(LinearQuadTree* quadTree, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, like
+/// linearQuadTreeVisitBySweptCircle, but without changing the linear quad tree, so that many threads can query it
+/// at once. Blocks stored in many leaves are visited once for every leaf.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the linear quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool linearQuadTreeVisitBySweptCircleReadOnly(const LinearQuadTree* quadTree, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context);
+/// @brief Returns the area covered by a leaf.
+/// @param quadTree Pointer to the linear quad tree.
+/// @param leaf Pointer to the leaf.
+/// @return Bounds of the leaf.
+RectBounds linearQuadTreeGetLeafBounds(const LinearQuadTree* quadTree, const LinearQuadTreeLeaf* leaf);
+/// @brief Frees a linear quad tree object.
+/// @param quadTree Pointer to the linear quad tree.
+void linearQuadTreeFree(LinearQuadTree* quadTree);
@@ -0,0 +1,301 @@
+#include "loose_quad_tree.h"
+
+#include <string.h>
+
+#include "memory.h"
+
+#define TOP_LEFT_QUADRANT_INDEX 0
+#define TOP_RIGHT_QUADRANT_INDEX 1
+#define BOTTOM_RIGHT_QUADRANT_INDEX 2
+#define BOTTOM_LEFT_QUADRANT_INDEX 3
+
+// every popped node pushes at most four children in place of itself
+#define VISIT_STACK_CAPACITY (3 * LOOSE_QUAD_TREE_MAX_DEPTH + 1)
+
+static inline LooseQuadTreeNode* getNode(const LooseQuadTree* quadTree, uint32_t index)
+{
+    return vectorGet(&quadTree->nodes, index, sizeof(LooseQuadTreeNode));
+}
+
+static inline Vec2 getCellMidpoint(const RectBounds* cell)
+{
+    return (Vec2) {
+        .x = (cell->topLeft.x + cell->bottomRight.x) / 2.0f,
+        .y = (cell->topLeft.y + cell->bottomRight.y) / 2.0f,
+    };
+}
+
+static inline bool cellContainsPoint(const RectBounds* cell, Vec2 point)
+{
+    return point.x >= cell->topLeft.x && point.x <= cell->bottomRight.x
+        && point.y >= cell->bottomRight.y && point.y <= cell->topLeft.y;
+}
+
+static uint32_t pushNode(LooseQuadTree* quadTree, RectBounds cell, uint32_t parent)
+{
+    uint32_t index = (uint32_t)vectorSize(&quadTree->nodes, sizeof(LooseQuadTreeNode));
+
+    vectorPushBack(&quadTree->nodes, &(LooseQuadTreeNode) {
+        .cell = cell,
+        .parent = parent,
+        .firstChild = NO_LOOSE_QUAD_TREE_INDEX,
+        .firstBlock = NO_LOOSE_QUAD_TREE_INDEX,
+        .lastBlock = NO_LOOSE_QUAD_TREE_INDEX,
+        .blockCount = 0,
+    }, sizeof(LooseQuadTreeNode));
+
+    return index;
+}
+
+static void splitNode(LooseQuadTree* quadTree, uint32_t nodeIndex)
+{
+    RectBounds cell = getNode(quadTree, nodeIndex)->cell;
+    Vec2 topLeft = cell.topLeft;
+    Vec2 bottomRight = cell.bottomRight;
+    Vec2 middlePoint = getCellMidpoint(&cell);
+
+    // pushing the children may move the nodes, so the parent is looked up again afterwards
+    uint32_t firstChild = pushNode(quadTree, (RectBounds) {
+        .topLeft = topLeft,
+        .bottomRight = middlePoint,
+    }, nodeIndex);
+
+    pushNode(quadTree, (RectBounds) {
+        .topLeft = (Vec2){ .x = middlePoint.x, .y = topLeft.y },
+        .bottomRight = (Vec2){ .x = bottomRight.x, .y = middlePoint.y },
+    }, nodeIndex);
+
+    pushNode(quadTree, (RectBounds) {
+        .topLeft = middlePoint,
+        .bottomRight = bottomRight,
+    }, nodeIndex);
+
+    pushNode(quadTree, (RectBounds) {
+        .topLeft = (Vec2){ .x = topLeft.x, .y = middlePoint.y },
+        .bottomRight = (Vec2){ .x = middlePoint.x, .y = bottomRight.y },
+    }, nodeIndex);
+
+    getNode(quadTree, nodeIndex)->firstChild = firstChild;
+}
+
+static uint32_t getChildIndex(const LooseQuadTreeNode* node, Vec2 point)
+{
+    Vec2 midpoint = getCellMidpoint(&node->cell);
+
+    if (point.y >= midpoint.y)
+        return point.x >= midpoint.x ? TOP_RIGHT_QUADRANT_INDEX : TOP_LEFT_QUADRANT_INDEX;
+
+    return point.x >= midpoint.x ? BOTTOM_RIGHT_QUADRANT_INDEX : BOTTOM_LEFT_QUADRANT_INDEX;
+}
+
+LooseQuadTree looseQuadTreeCreate(RectBounds bounds, const Block* blocks, size_t blockCount)
+{
+    size_t arraySize = sizeof(uint32_t) * (blockCount > 0 ? blockCount : 1);
+
+    LooseQuadTree quadTree = {
+        .elemCount = 0,
+        .nodes = vectorCreate(),
+        .blockNodes = checkedMalloc(arraySize),
+        .nextBlocks = checkedMalloc(arraySize),
+        .previousBlocks = checkedMalloc(arraySize),
+        .blocks = blocks,
+    };
+
+    memset(quadTree.blockNodes, 0xFF, arraySize);
+    pushNode(&quadTree, bounds, NO_LOOSE_QUAD_TREE_INDEX);
+
+    for (size_t i = 0; i < blockCount; i++)
+        looseQuadTreeInsert(&quadTree, &blocks[i]);
+
+    return quadTree;
+}
+
+bool looseQuadTreeInsert(LooseQuadTree* quadTree, const Block* block)
+{
+    uint32_t blockIndex = (uint32_t)(block - quadTree->blocks);
+
+    if (quadTree->blockNodes[blockIndex] != NO_LOOSE_QUAD_TREE_INDEX)
+        return false;
+
+    RectBounds blockBounds = getBlockRectBounds(block);
+    Vec2 center = getCellMidpoint(&blockBounds);
+    uint32_t nodeIndex = 0;
+
+    // a child's loose bounds reach half of its cell past its edges, so a block no bigger than the cell fits
+    // into them as long as its center is inside of the cell, blocks centered outside of the tree stay in the root
+    if (cellContainsPoint(&getNode(quadTree, 0)->cell, center))
+    {
+        for (size_t depth = 0; depth < LOOSE_QUAD_TREE_MAX_DEPTH; depth++)
+        {
+            const RectBounds* cell = &getNode(quadTree, nodeIndex)->cell;
+            float childCellWidth = (cell->bottomRight.x - cell->topLeft.x) / 2.0f;
+            float childCellHeight = (cell->topLeft.y - cell->bottomRight.y) / 2.0f;
+
+            if (block->width > childCellWidth || block->height > childCellHeight)
+                break;
+
+            if (getNode(quadTree, nodeIndex)->firstChild == NO_LOOSE_QUAD_TREE_INDEX)
+                splitNode(quadTree, nodeIndex);
+
+            const LooseQuadTreeNode* node = getNode(quadTree, nodeIndex);
+            nodeIndex = node->firstChild + getChildIndex(node, center);
+        }
+    }
+
+    // blocks are appended, so that they're visited in the order in which they were inserted
+    LooseQuadTreeNode* node = getNode(quadTree, nodeIndex);
+
+    quadTree->blockNodes[blockIndex] = nodeIndex;
+    quadTree->nextBlocks[blockIndex] = NO_LOOSE_QUAD_TREE_INDEX;
+    quadTree->previousBlocks[blockIndex] = node->lastBlock;
+
+    if (node->lastBlock != NO_LOOSE_QUAD_TREE_INDEX)
+        quadTree->nextBlocks[node->lastBlock] = blockIndex;
+    else
+        node->firstBlock = blockIndex;
+
+    node->lastBlock = blockIndex;
+
+    for (uint32_t i = nodeIndex; i != NO_LOOSE_QUAD_TREE_INDEX; i = getNode(quadTree, i)->parent)
+        getNode(quadTree, i)->blockCount++;
+
+    quadTree->elemCount++;
+    return true;
+}
+
+bool looseQuadTreeRemoveBlock(LooseQuadTree* quadTree, const Block* block)
+{
+    uint32_t blockIndex = (uint32_t)(block - quadTree->blocks);
+    uint32_t nodeIndex = quadTree->blockNodes[blockIndex];
+
+    if (nodeIndex == NO_LOOSE_QUAD_TREE_INDEX)
+        return false;
+
+    LooseQuadTreeNode* node = getNode(quadTree, nodeIndex);
+    uint32_t next = quadTree->nextBlocks[blockIndex];
+    uint32_t previous = quadTree->previousBlocks[blockIndex];
+
+    if (previous != NO_LOOSE_QUAD_TREE_INDEX)
+        quadTree->nextBlocks[previous] = next;
+    else
+        node->firstBlock = next;
+
+    if (next != NO_LOOSE_QUAD_TREE_INDEX)
+        quadTree->previousBlocks[next] = previous;
+    else
+        node->lastBlock = previous;
+
+    // the counts let the queries skip subtrees which were emptied
+    for (uint32_t i = nodeIndex; i != NO_LOOSE_QUAD_TREE_INDEX; i = getNode(quadTree, i)->parent)
+        getNode(quadTree, i)->blockCount--;
+
+    quadTree->blockNodes[blockIndex] = NO_LOOSE_QUAD_TREE_INDEX;
+    quadTree->elemCount--;
+
+    return true;
+}
+
+RectBounds looseQuadTreeGetNodeBounds(const LooseQuadTree* quadTree, const LooseQuadTreeNode* node)
+{
+    (void)quadTree;
+
+    float marginX = (node->cell.bottomRight.x - node->cell.topLeft.x) / 2.0f;
+    float marginY = (node->cell.topLeft.y - node->cell.bottomRight.y) / 2.0f;
+
+    return (RectBounds) {
+        .topLeft = { .x = node->cell.topLeft.x - marginX, .y = node->cell.topLeft.y + marginY },
+        .bottomRight = { .x = node->cell.bottomRight.x + marginX, .y = node->cell.bottomRight.y - marginY },
+    };
+}
+
+bool looseQuadTreeVisitByBounds(const LooseQuadTree* quadTree, RectBounds bounds, BlockVisitor visitor,
+    void* context)
+{
+    uint32_t stack[VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const LooseQuadTreeNode* node = getNode(quadTree, stack[--stackSize]);
+
+        for (uint32_t i = node->firstBlock; i != NO_LOOSE_QUAD_TREE_INDEX; i = quadTree->nextBlocks[i])
+        {
+            RectBounds blockBounds = getBlockRectBounds(&quadTree->blocks[i]);
+
+            if (rectBoundsOverlap(&blockBounds, &bounds) && !visitor(&quadTree->blocks[i], context))
+                return false;
+        }
+
+        if (node->firstChild == NO_LOOSE_QUAD_TREE_INDEX)
+            continue;
+
+        // pushed in reverse, so that the children are visited in the same order as in the other quad trees
+        for (uint32_t i = 4; i-- > 0;)
+        {
+            const LooseQuadTreeNode* child = getNode(quadTree, node->firstChild + i);
+            RectBounds childBounds = looseQuadTreeGetNodeBounds(quadTree, child);
+
+            if (child->blockCount > 0 && rectBoundsOverlap(&childBounds, &bounds))
+                stack[stackSize++] = node->firstChild + i;
+        }
+    }
+
+    return true;
+}
+
+void looseQuadTreeRetrieveAllByBounds(const LooseQuadTree* quadTree, RectBounds bounds, Vector* result)
+{
+    looseQuadTreeVisitByBounds(quadTree, bounds, pushBackBlockVisitor, result);
+}
+
+bool looseQuadTreeVisitBySweptCircle(const LooseQuadTree* quadTree, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context)
+{
+    uint32_t stack[VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        const LooseQuadTreeNode* node = getNode(quadTree, stack[--stackSize]);
+
+        for (uint32_t i = node->firstBlock; i != NO_LOOSE_QUAD_TREE_INDEX; i = quadTree->nextBlocks[i])
+        {
+            RectBounds blockBounds = getBlockRectBounds(&quadTree->blocks[i]);
+
+            if (sweptCircleOverlapsBounds(start, end, radius, &blockBounds)
+                && !visitor(&quadTree->blocks[i], context))
+            {
+                return false;
+            }
+        }
+
+        if (node->firstChild == NO_LOOSE_QUAD_TREE_INDEX)
+            continue;
+
+        for (uint32_t i = 4; i-- > 0;)
+        {
+            const LooseQuadTreeNode* child = getNode(quadTree, node->firstChild + i);
+            RectBounds childBounds = looseQuadTreeGetNodeBounds(quadTree, child);
+
+            if (child->blockCount > 0 && sweptCircleOverlapsBounds(start, end, radius, &childBounds))
+                stack[stackSize++] = node->firstChild + i;
+        }
+    }
+
+    return true;
+}
+
+void looseQuadTreeFree(LooseQuadTree* quadTree)
+{
+    vectorFree(&quadTree->nodes);
+    quadTree->elemCount = 0;
+
+    free(quadTree->blockNodes);
+    quadTree->blockNodes = NULL;
+    free(quadTree->nextBlocks);
+    quadTree->nextBlocks = NULL;
+    free(quadTree->previousBlocks);
+    quadTree->previousBlocks = NULL;
+}
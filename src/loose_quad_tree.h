@@ -0,0 +1,97 @@
+/// @file loose_quad_tree.h
+/// @brief A loose quad tree, in which every block is stored in exactly one node.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "block_visitor.h"
+#include "entities.h"
+#include "vector.h"
+
+/// @brief Depth of the smallest loose quad tree nodes. Blocks smaller than their cells are stored in them too.
+#define LOOSE_QUAD_TREE_MAX_DEPTH 8
+
+/// @brief Node index used for missing nodes and blocks.
+#define NO_LOOSE_QUAD_TREE_INDEX UINT32_MAX
+
+/// @brief Node of a loose quad tree. A node owns a cell of the tree, but the blocks stored in it may reach
+/// half a cell past its edges, so its loose bounds are twice as big as the cell.
+typedef struct LooseQuadTreeNode
+{
+    RectBounds cell;
+    uint32_t parent;
+    uint32_t firstChild; // index of the first of four contiguous children or NO_LOOSE_QUAD_TREE_INDEX
+    uint32_t firstBlock; // head of the list of blocks stored in this node
+    uint32_t lastBlock;
+    uint32_t blockCount; // blocks stored in the whole subtree
+} LooseQuadTreeNode;
+
+/// @brief Quad tree whose nodes overlap, so that every block fits into a single node picked by the position of
+/// its center and its size. Blocks are never stored twice and removing one only unlinks it from its node. Like
+/// QuadTree, it doesn't manage the blocks on its own, it only stores their indices in the block array passed to
+/// looseQuadTreeCreate.
+typedef struct LooseQuadTree
+{
+    size_t elemCount;
+
+    // PRIVATE
+    Vector nodes; // LooseQuadTreeNode, the root comes first
+    uint32_t* blockNodes; // node of every block in the block array, NO_LOOSE_QUAD_TREE_INDEX if it isn't stored
+    uint32_t* nextBlocks; // links of the per node block lists
+    uint32_t* previousBlocks;
+    const Block* blocks;
+} LooseQuadTree;
+
+/// @brief Creates a loose quad tree and inserts all of the blocks into it.
+/// @param bounds The area which the root cell of the tree will cover.
+/// @param blocks Array of blocks which will be inserted into the tree.
+/// @param blockCount Number of blocks in the array.
+/// @return Created loose quad tree.
+LooseQuadTree looseQuadTreeCreate(RectBounds bounds, const Block* blocks, size_t blockCount);
+/// @brief Inserts a block into the tree, into the deepest node whose cell contains the block's center and
+/// whose loose bounds contain the whole block.
+/// @param quadTree Pointer to the loose quad tree.
+/// @param block Pointer to the block. It must come from the block array passed to looseQuadTreeCreate.
+/// @return True if the block was inserted, false if it was already stored in the tree.
+bool looseQuadTreeInsert(LooseQuadTree* quadTree, const Block* block);
+/// @brief Removes a block from the tree in constant time, apart from updating the block counts above it.
+/// @param quadTree Pointer to the loose quad tree.
+/// @param block Pointer to the block.
+/// @return True if the block was stored in the tree, false otherwise.
+bool looseQuadTreeRemoveBlock(LooseQuadTree* quadTree, const Block* block);
+/// @brief Calls a visitor for all the blocks which at least partially cover a certain area, without allocating
+/// any memory. Every block is visited at most once.
+/// @param quadTree Pointer to the loose quad tree.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param visitor Function called for every found block. It must not modify the tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool looseQuadTreeVisitByBounds(const LooseQuadTree* quadTree, RectBounds bounds, BlockVisitor visitor,
+    void* context);
+/// @brief Retrieves all the blocks which at least partially cover a certain area. Every block is retrieved
+/// at most once.
+/// @param quadTree Pointer to the loose quad tree.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void looseQuadTreeRetrieveAllByBounds(const LooseQuadTree* quadTree, RectBounds bounds, Vector* result);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, without
+/// allocating any memory. Every block is visited at most once.
+/// @param quadTree Pointer to the loose quad tree.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool looseQuadTreeVisitBySweptCircle(const LooseQuadTree* quadTree, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context);
+/// @brief Returns the loose bounds of a node, the area which the blocks stored in it can cover.
+/// @param quadTree Pointer to the loose quad tree.
+/// @param node Pointer to the node.
+/// @return Loose bounds of the node.
+RectBounds looseQuadTreeGetNodeBounds(const LooseQuadTree* quadTree, const LooseQuadTreeNode* node);
+/// @brief Frees a loose quad tree object.
+/// @param quadTree Pointer to the loose quad tree.
+void looseQuadTreeFree(LooseQuadTree* quadTree);
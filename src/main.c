@@ -31,14 +31,14 @@ int main()
         updateTime();
         glClear(GL_COLOR_BUFFER_BIT);
 
-        for (size_t i = 0; i < SIMULATION_SUB_STEPS; i++)
+        // the simulation runs at its own tick rate, as many ticks as the time since the last frame covers
+        while (consumeSimulationTick())
         {
             processGameInput(&game, window);
-            moveGameObjects(&game);
-            collideGameObjects(&game);
+            simulateGame(&game, SIMULATION_TICK_TIME);
         }
 
-        updateRenderer(&game.renderer, &game.board);
+        updateRenderer(&game.renderer, &game.board, getSimulationAlpha());
         render(&game.renderer, &game.state, &game.board);
 
         if (game.state.boardCleared)
@@ -21,6 +21,16 @@ static inline void* checkedMalloc(size_t size)
     return tmp;
 }
 
+static inline void* checkedCalloc(size_t count, size_t size)
+{
+    void* tmp = calloc(count, size);
+
+    if (!tmp)
+        exit(EXIT_BAD_ALLOC);
+
+    return tmp;
+}
+
 static inline void* checkedRealloc(void* ptr, size_t newSize)
 {
     void* tmp = realloc(ptr, newSize);
@@ -1,8 +1,13 @@
 #include "quad_tree.h"
 
+#include <assert.h>
+#include <float.h>
 #include <stdbool.h>
+#include <string.h>
 
+#include "helpers.h"
 #include "memory.h"
+#include "thread.h"
 
 #define TOP_LEFT_QUADRANT_INDEX 0
 #define TOP_RIGHT_QUADRANT_INDEX 1
@@ -17,25 +22,108 @@
 #define NO_QUADRANTS                0x0
 #define ALL_QUADRANTS               0xF
 
-static QuadTreeNode* createQuadTreeNode(RectBounds bounds)
+#define NO_LEAF_REF UINT32_MAX
+
+static_assert(QUAD_TREE_NODE_BOUNDS_CAPACITY <= MAX_BOUNDS_PER_HIT_MASK,
+    "A quad tree leaf has to fit into a single hit mask");
+
+// an entry in the list of leaves which store a block
+typedef struct QuadTreeLeafRef
 {
-    QuadTreeNode* node = checkedMalloc(sizeof(QuadTreeNode));
+    uint32_t leaf;
+    uint32_t next;
+} QuadTreeLeafRef;
 
-    *node = (QuadTreeNode) {
-        .bounds = bounds,
-    };
+// an entry of the queue of the nearest block queries, either a node or one of the blocks of a leaf
+typedef struct QuadTreeQueueEntry
+{
+    float distanceSquared;
+    uint32_t node;
+    uint32_t block; // none for nodes
+} QuadTreeQueueEntry;
+
+// a node waiting to be visited by a batched query, with the range of the batch query list holding the queries
+// which reach it
+typedef struct QuadTreeBatchEntry
+{
+    uint32_t node;
+    uint32_t firstQuery; // the query itself if it's the only one, nodes reached by a single query need no list
+    uint32_t queryCount;
+} QuadTreeBatchEntry;
+
+// a node waiting to be visited by a cast, with the distance at which the cast reaches it
+typedef struct QuadTreeCastEntry
+{
+    uint32_t node;
+    float distance;
+} QuadTreeCastEntry;
+
+// the node array may move when it grows, so nodes are held by their index across allocations
+static uint32_t allocateQuadTreeNodeGroup(QuadTree* quadTree)
+{
+    uint32_t group = quadTree->freeGroups;
+
+    if (group != NO_QUAD_TREE_INDEX)
+    {
+        quadTree->freeGroups = quadTreeGetNode(quadTree, group)->nodes;
+        return group;
+    }
+
+    group = (uint32_t)vectorSize(&quadTree->nodes, sizeof(QuadTreeNode));
+
+    // the groups are initialized by the caller, the array only has to double when it's full
+    if ((group + 4) * sizeof(QuadTreeNode) > quadTree->nodes.allocatedSize)
+        vectorReserve(&quadTree->nodes, 2 * (group + 4), sizeof(QuadTreeNode));
+
+    vectorResize(&quadTree->nodes, group + 4, sizeof(QuadTreeNode));
+
+    return group;
+}
+
+static void releaseQuadTreeNodeGroup(QuadTree* quadTree, uint32_t group)
+{
+    QuadTreeNode* nodes = quadTreeGetNode(quadTree, group);
 
     for (size_t i = 0; i < 4; i++)
-        node->nodes[i] = NULL;
+        nodes[i].parent = NO_QUAD_TREE_INDEX;
 
-    for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS; i++)
-        node->blocks[i] = NULL;
+    nodes->nodes = quadTree->freeGroups;
+    quadTree->freeGroups = group;
+}
+
+// far enough from the board for the squared distance to any circle on it to stay finite and never hit
+#define EMPTY_SLOT_COORD -1.0e18f
+
+static void clearNodeBlock(QuadTreeNode* node, size_t slot)
+{
+    if (slot < MAX_QUAD_TREE_NODE_BLOCKS)
+        node->blocks[slot] = NO_QUAD_TREE_INDEX;
+
+    node->blockMinX[slot] = EMPTY_SLOT_COORD;
+    node->blockMinY[slot] = EMPTY_SLOT_COORD;
+    node->blockMaxX[slot] = EMPTY_SLOT_COORD;
+    node->blockMaxY[slot] = EMPTY_SLOT_COORD;
+}
+
+static void initQuadTreeNode(QuadTreeNode* node, RectBounds bounds, uint32_t parent)
+{
+    *node = (QuadTreeNode) {
+        .bounds = bounds,
+        .parent = parent,
+        .nodes = NO_QUAD_TREE_INDEX,
+        .overflow = NO_QUAD_TREE_INDEX,
+    };
 
-    return node;
+    for (size_t i = 0; i < QUAD_TREE_NODE_BOUNDS_CAPACITY; i++)
+        clearNodeBlock(node, i);
 }
 
-static void splitQuadTreeNode(QuadTreeNode* node)
+static void splitQuadTreeNode(QuadTree* quadTree, uint32_t nodeIndex)
 {
+    uint32_t group = allocateQuadTreeNodeGroup(quadTree);
+    QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+    QuadTreeNode* subnodes = quadTreeGetNode(quadTree, group);
+
     Vec2 topLeft = node->bounds.topLeft;
     Vec2 bottomRight = node->bounds.bottomRight;
     Vec2 middlePoint = (Vec2) {
@@ -43,25 +131,27 @@ static void splitQuadTreeNode(QuadTreeNode* node)
         .y = (topLeft.y + bottomRight.y) / 2.0f,
     };
 
-    node->nodes[TOP_LEFT_QUADRANT_INDEX] = createQuadTreeNode((RectBounds) {
+    initQuadTreeNode(&subnodes[TOP_LEFT_QUADRANT_INDEX], (RectBounds) {
         .topLeft = topLeft,
         .bottomRight = middlePoint,
-    });
+    }, nodeIndex);
 
-    node->nodes[TOP_RIGHT_QUADRANT_INDEX] = createQuadTreeNode((RectBounds) {
+    initQuadTreeNode(&subnodes[TOP_RIGHT_QUADRANT_INDEX], (RectBounds) {
         .topLeft = (Vec2){ .x = middlePoint.x, .y = topLeft.y },
         .bottomRight = (Vec2){ .x = bottomRight.x, .y = middlePoint.y },
-    });
+    }, nodeIndex);
 
-    node->nodes[BOTTOM_RIGHT_QUADRANT_INDEX] = createQuadTreeNode((RectBounds) {
+    initQuadTreeNode(&subnodes[BOTTOM_RIGHT_QUADRANT_INDEX], (RectBounds) {
         .topLeft = middlePoint,
         .bottomRight = bottomRight,
-    });
+    }, nodeIndex);
 
-    node->nodes[BOTTOM_LEFT_QUADRANT_INDEX] = createQuadTreeNode((RectBounds) {
+    initQuadTreeNode(&subnodes[BOTTOM_LEFT_QUADRANT_INDEX], (RectBounds) {
         .topLeft = (Vec2){ .x = topLeft.x, .y = middlePoint.y },
         .bottomRight = (Vec2){ .x = middlePoint.x, .y = bottomRight.y },
-    });
+    }, nodeIndex);
+
+    node->nodes = group;
 }
 
 static uint8_t getNodeQuadrantsByBounds(const QuadTreeNode* node, const RectBounds* bounds)
@@ -99,195 +189,1608 @@ static uint8_t getNodeQuadrantsByBounds(const QuadTreeNode* node, const RectBoun
     return quadrants;
 }
 
-static uint8_t getNodeQuadrantsForBlock(const QuadTreeNode* node, const Block* block)
+static uint8_t getNodeQuadrantsForBlock(const QuadTree* quadTree, const QuadTreeNode* node, uint32_t block)
 {
-    RectBounds blockBounds = getBlockRectBounds(block);
+    RectBounds blockBounds = getBlockRectBounds(&quadTree->blocks[block]);
     return getNodeQuadrantsByBounds(node, &blockBounds);
 }
 
-QuadTree quadTreeCreate(RectBounds bounds)
+QuadTree quadTreeCreate(RectBounds bounds, const Block* blocks, size_t blockCount)
 {
-    QuadTreeNode* root = createQuadTreeNode(bounds);
-
-    return (QuadTree) {
-        .root = root,
+    QuadTree quadTree = {
         .elemCount = 0,
+        .queryStats = { .queryCount = 0, .visitedNodeCount = 0, .candidateCount = 0 },
+        .nodes = vectorCreate(),
+        .freeGroups = NO_QUAD_TREE_INDEX,
+        .blocks = blocks,
+        .blockCount = blockCount,
+        .leafRefs = vectorCreate(),
+        .blockLeafRefs = checkedMalloc(sizeof(uint32_t) * blockCount),
+        .freeLeafRefs = NO_LEAF_REF,
+        .blockQueryStamps = queryStampsCreate(blockCount),
+        .nearestQueue = vectorCreate(),
+        .batchQueries = vectorCreate(),
+    };
+
+    QuadTreeNode root;
+    initQuadTreeNode(&root, bounds, NO_QUAD_TREE_INDEX);
+
+    vectorReserve(&quadTree.nodes, 1 + 4 * QUAD_TREE_NODE_POOL_INITIAL_GROUPS, sizeof(QuadTreeNode));
+    vectorPushBack(&quadTree.nodes, &root, sizeof(QuadTreeNode));
+
+    memset(quadTree.blockLeafRefs, 0xFF, sizeof(uint32_t) * blockCount);
+    vectorReserve(&quadTree.leafRefs, blockCount, sizeof(QuadTreeLeafRef));
+
+    return quadTree;
+}
+
+QuadTree quadTreeClone(const QuadTree* quadTree, const Block* blocks)
+{
+    // nothing refers to memory owned by the tree, so every array is copied as it is
+    QuadTree clone = *quadTree;
+
+    clone.queryStats = (QuadTreeQueryStats){ .queryCount = 0, .visitedNodeCount = 0, .candidateCount = 0 };
+    clone.nodes = vectorCopy(&quadTree->nodes);
+    clone.blocks = blocks;
+    clone.leafRefs = vectorCopy(&quadTree->leafRefs);
+    clone.blockLeafRefs = checkedMalloc(sizeof(uint32_t) * quadTree->blockCount);
+    clone.blockQueryStamps = queryStampsCreate(quadTree->blockCount);
+    clone.nearestQueue = vectorCreate();
+    clone.batchQueries = vectorCreate();
+
+    memcpy(clone.blockLeafRefs, quadTree->blockLeafRefs, sizeof(uint32_t) * quadTree->blockCount);
+
+    return clone;
+}
+
+static inline QuadTreeLeafRef* getLeafRef(const QuadTree* quadTree, uint32_t index)
+{
+    return vectorGet(&quadTree->leafRefs, index, sizeof(QuadTreeLeafRef));
+}
+
+static void freeLeafRef(QuadTree* quadTree, uint32_t index)
+{
+    getLeafRef(quadTree, index)->next = quadTree->freeLeafRefs;
+    quadTree->freeLeafRefs = index;
+}
+
+static void linkLeafRef(QuadTree* quadTree, uint32_t block, uint32_t leaf)
+{
+    uint32_t index = quadTree->freeLeafRefs;
+
+    if (index != NO_LEAF_REF)
+    {
+        quadTree->freeLeafRefs = getLeafRef(quadTree, index)->next;
+    }
+    else
+    {
+        index = (uint32_t)vectorSize(&quadTree->leafRefs, sizeof(QuadTreeLeafRef));
+        vectorPushBack(&quadTree->leafRefs, &(QuadTreeLeafRef){ .leaf = NO_QUAD_TREE_INDEX, .next = NO_LEAF_REF },
+            sizeof(QuadTreeLeafRef));
+    }
+
+    uint32_t* head = &quadTree->blockLeafRefs[block];
+
+    *getLeafRef(quadTree, index) = (QuadTreeLeafRef) {
+        .leaf = leaf,
+        .next = *head,
     };
+
+    *head = index;
 }
 
-static void quadTreeInsertImpl(QuadTreeNode* node, const Block* block);
+static void unlinkLeafRef(QuadTree* quadTree, uint32_t block, uint32_t leaf)
+{
+    uint32_t* link = &quadTree->blockLeafRefs[block];
+
+    while (*link != NO_LEAF_REF)
+    {
+        uint32_t index = *link;
+        QuadTreeLeafRef* ref = getLeafRef(quadTree, index);
+
+        if (ref->leaf == leaf)
+        {
+            *link = ref->next;
+            freeLeafRef(quadTree, index);
+            return;
+        }
+
+        link = &ref->next;
+    }
+}
 
-static inline void insertIntoQuadrants(QuadTreeNode* node, const Block* block, uint8_t quadrants)
+static bool quadTreeInsertImpl(QuadTree* quadTree, uint32_t nodeIndex, uint32_t block, size_t depth);
+
+// returns whether the block was added to any of the leaves
+static inline bool insertIntoQuadrants(QuadTree* quadTree, uint32_t subnodes, uint32_t block, uint8_t quadrants,
+    size_t depth)
 {
+    bool inserted = false;
+
     if (quadrants & TOP_LEFT_QUADRANT_BIT)
-        quadTreeInsertImpl(node->nodes[TOP_LEFT_QUADRANT_INDEX], block);
+        inserted |= quadTreeInsertImpl(quadTree, subnodes + TOP_LEFT_QUADRANT_INDEX, block, depth + 1);
 
     if (quadrants & TOP_RIGHT_QUADRANT_BIT)
-        quadTreeInsertImpl(node->nodes[TOP_RIGHT_QUADRANT_INDEX], block);
+        inserted |= quadTreeInsertImpl(quadTree, subnodes + TOP_RIGHT_QUADRANT_INDEX, block, depth + 1);
 
     if (quadrants & BOTTOM_RIGHT_QUADRANT_BIT)
-        quadTreeInsertImpl(node->nodes[BOTTOM_RIGHT_QUADRANT_INDEX], block);
+        inserted |= quadTreeInsertImpl(quadTree, subnodes + BOTTOM_RIGHT_QUADRANT_INDEX, block, depth + 1);
 
     if (quadrants & BOTTOM_LEFT_QUADRANT_BIT)
-        quadTreeInsertImpl(node->nodes[BOTTOM_LEFT_QUADRANT_INDEX], block);
+        inserted |= quadTreeInsertImpl(quadTree, subnodes + BOTTOM_LEFT_QUADRANT_INDEX, block, depth + 1);
+
+    return inserted;
+}
+
+static void setNodeBlock(const QuadTree* quadTree, QuadTreeNode* node, size_t slot, uint32_t block)
+{
+    RectBounds bounds = getBlockRectBounds(&quadTree->blocks[block]);
+
+    node->blocks[slot] = block;
+    node->blockMinX[slot] = bounds.topLeft.x;
+    node->blockMinY[slot] = bounds.bottomRight.y;
+    node->blockMaxX[slot] = bounds.bottomRight.x;
+    node->blockMaxY[slot] = bounds.topLeft.y;
 }
 
-static void addBlockToNode(QuadTreeNode* node, const Block* block)
+static void addBlockToNode(const QuadTree* quadTree, QuadTreeNode* node, uint32_t block)
 {
     for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS; i++)
     {
-        if (node->blocks[i] == NULL)
+        if (node->blocks[i] == NO_QUAD_TREE_INDEX)
         {
-            node->blocks[i] = block;
+            setNodeBlock(quadTree, node, i, block);
             return;
         }
     }
 }
 
-static bool blockInserted = false;
+// overflow leaves take a whole group from the pool, they only show up when many blocks overlap in a tiny area
+static uint32_t appendOverflowLeaf(QuadTree* quadTree, uint32_t leaf, uint32_t last)
+{
+    uint32_t overflow = allocateQuadTreeNodeGroup(quadTree);
+    initQuadTreeNode(quadTreeGetNode(quadTree, overflow), quadTreeGetNode(quadTree, leaf)->bounds, leaf);
+
+    quadTreeGetNode(quadTree, last)->overflow = overflow;
+    return overflow;
+}
+
+static void addBlockToOverflowLeaves(QuadTree* quadTree, uint32_t leaf, uint32_t block)
+{
+    uint32_t last = leaf;
+
+    while (quadTreeGetNode(quadTree, last)->overflow != NO_QUAD_TREE_INDEX)
+        last = quadTreeGetNode(quadTree, last)->overflow;
+
+    if (quadTreeNodeFull(quadTreeGetNode(quadTree, last)))
+        last = appendOverflowLeaf(quadTree, leaf, last);
 
-static void quadTreeInsertImpl(QuadTreeNode* node, const Block* block)
+    addBlockToNode(quadTree, quadTreeGetNode(quadTree, last), block);
+}
+
+static bool quadTreeInsertImpl(QuadTree* quadTree, uint32_t nodeIndex, uint32_t block, size_t depth)
 {
+    QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
     if (quadTreeNodeHasSubnodes(node))
     {
-        uint8_t quadrants = getNodeQuadrantsForBlock(node, block);
-        insertIntoQuadrants(node, block, quadrants);
-        return;
+        uint8_t quadrants = getNodeQuadrantsForBlock(quadTree, node, block);
+        return insertIntoQuadrants(quadTree, node->nodes, block, quadrants, depth);
     }
 
-    if (quadTreeNodeFull(node))
+    if (quadTreeNodeFull(node) && depth < QUAD_TREE_MAX_DEPTH)
     {
-        splitQuadTreeNode(node);
+        splitQuadTreeNode(quadTree, nodeIndex);
 
         for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS; i++)
         {
-            quadTreeInsertImpl(node, node->blocks[i]);
-            node->blocks[i] = NULL;
+            // moving the previous blocks may have grown the node array
+            node = quadTreeGetNode(quadTree, nodeIndex);
+
+            uint32_t movedBlock = node->blocks[i];
+            clearNodeBlock(node, i);
+
+            unlinkLeafRef(quadTree, movedBlock, nodeIndex);
+            quadTreeInsertImpl(quadTree, nodeIndex, movedBlock, depth);
         }
 
-        uint8_t quadrants = getNodeQuadrantsForBlock(node, block);
-        insertIntoQuadrants(node, block, quadrants);
-        return;
+        node = quadTreeGetNode(quadTree, nodeIndex);
+        uint8_t quadrants = getNodeQuadrantsForBlock(quadTree, node, block);
+        return insertIntoQuadrants(quadTree, node->nodes, block, quadrants, depth);
     }
 
-    addBlockToNode(node, block);
-    blockInserted = true;
+    // blocks in the overflow leaves are referenced through the first leaf of the chain
+    if (quadTreeNodeFull(node))
+        addBlockToOverflowLeaves(quadTree, nodeIndex, block);
+    else
+        addBlockToNode(quadTree, node, block);
+
+    linkLeafRef(quadTree, block, nodeIndex);
+
+    return true;
 }
 
-void quadTreeInsert(QuadTree* quadTree, const Block* block)
+bool quadTreeInsert(QuadTree* quadTree, const Block* block)
 {
-    blockInserted = false;
-    quadTreeInsertImpl(quadTree->root, block);
+    bool inserted = quadTreeInsertImpl(quadTree, QUAD_TREE_ROOT_INDEX, (uint32_t)(block - quadTree->blocks), 0);
 
-    if (blockInserted)
+    if (inserted)
         quadTree->elemCount++;
+
+    return inserted;
 }
 
-static bool blockRemoved = false;
+static const uint8_t quadrantBits[4] = {
+    [TOP_LEFT_QUADRANT_INDEX] = TOP_LEFT_QUADRANT_BIT,
+    [TOP_RIGHT_QUADRANT_INDEX] = TOP_RIGHT_QUADRANT_BIT,
+    [BOTTOM_RIGHT_QUADRANT_INDEX] = BOTTOM_RIGHT_QUADRANT_BIT,
+    [BOTTOM_LEFT_QUADRANT_INDEX] = BOTTOM_LEFT_QUADRANT_BIT,
+};
 
-void quadTreeRemoveBlockImpl(QuadTreeNode* node, const Block* block)
+// a subtree which the bulk build leaves for one of the workers
+typedef struct QuadTreeBuildTask
 {
-    if (quadTreeNodeHasSubnodes(node))
+    uint32_t node; // node of the tree which becomes the root of the subtree
+    RectBounds bounds;
+    size_t depth;
+    Vector blocks; // uint32_t, blocks routed into the node in the order of the block array
+    size_t worker;
+    QuadTree subtree; // only its nodes are used, the root of the subtree comes first
+} QuadTreeBuildTask;
+
+typedef struct QuadTreeBuilder
+{
+    QuadTree* quadTree;
+    Vector scratch; // uint32_t, block lists of the nodes on the path to the current one
+    Vector quadrants; // uint8_t, quadrants of the blocks in the lists of the nodes which are being split
+    size_t taskDepth; // depth at which nodes which need to be split are left for the workers
+    Vector* tasks; // QuadTreeBuildTask
+} QuadTreeBuilder;
+
+typedef struct QuadTreeBuildWorker
+{
+    Thread thread;
+    size_t index;
+    const Block* blocks;
+    QuadTreeBuildTask* tasks;
+    size_t taskCount;
+} QuadTreeBuildWorker;
+
+static inline uint32_t getBuilderBlock(const QuadTreeBuilder* builder, size_t index)
+{
+    return *(uint32_t*)vectorGet(&builder->scratch, index, sizeof(uint32_t));
+}
+
+// builds the same node as inserting the blocks one by one would, a node is split exactly when more blocks than
+// it can hold are routed into it and the blocks keep their order in the leaves
+static void buildQuadTreeNode(QuadTreeBuilder* builder, uint32_t nodeIndex, size_t first, size_t count,
+    size_t depth)
+{
+    QuadTree* quadTree = builder->quadTree;
+
+    if (count <= MAX_QUAD_TREE_NODE_BLOCKS || depth == QUAD_TREE_MAX_DEPTH)
     {
-        uint8_t quadrants = getNodeQuadrantsForBlock(node, block);
+        uint32_t last = nodeIndex;
 
-        if (quadrants & TOP_LEFT_QUADRANT_BIT)
-            quadTreeRemoveBlockImpl(node->nodes[TOP_LEFT_QUADRANT_INDEX], block);
+        for (size_t i = 0; i < count; i++)
+        {
+            if (quadTreeNodeFull(quadTreeGetNode(quadTree, last)))
+                last = appendOverflowLeaf(quadTree, nodeIndex, last);
+
+            addBlockToNode(quadTree, quadTreeGetNode(quadTree, last), getBuilderBlock(builder, first + i));
+        }
 
-        if (quadrants & TOP_RIGHT_QUADRANT_BIT)
-            quadTreeRemoveBlockImpl(node->nodes[TOP_RIGHT_QUADRANT_INDEX], block);
+        return;
+    }
 
-        if (quadrants & BOTTOM_RIGHT_QUADRANT_BIT)
-            quadTreeRemoveBlockImpl(node->nodes[BOTTOM_RIGHT_QUADRANT_INDEX], block);
+    if (depth == builder->taskDepth)
+    {
+        QuadTreeBuildTask task = {
+            .node = nodeIndex,
+            .bounds = quadTreeGetNode(quadTree, nodeIndex)->bounds,
+            .depth = depth,
+            .blocks = vectorCreate(),
+        };
 
-        if (quadrants & BOTTOM_LEFT_QUADRANT_BIT)
-            quadTreeRemoveBlockImpl(node->nodes[BOTTOM_LEFT_QUADRANT_INDEX], block);
+        vectorResize(&task.blocks, count, sizeof(uint32_t));
+        memcpy(task.blocks.data, vectorGet(&builder->scratch, first, sizeof(uint32_t)), sizeof(uint32_t) * count);
+        vectorPushBack(builder->tasks, &task, sizeof(QuadTreeBuildTask));
 
         return;
     }
 
-    for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS; i++)
+    splitQuadTreeNode(quadTree, nodeIndex);
+
+    const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+    uint32_t subnodes = node->nodes;
+    size_t firstQuadrants = vectorSize(&builder->quadrants, sizeof(uint8_t));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t quadrants = getNodeQuadrantsForBlock(quadTree, node, getBuilderBlock(builder, first + i));
+        vectorPushBack(&builder->quadrants, &quadrants, sizeof(uint8_t));
+    }
+
+    for (uint32_t i = 0; i < 4; i++)
     {
-        if (node->blocks[i] == block)
+        size_t subnodeFirst = vectorSize(&builder->scratch, sizeof(uint32_t));
+
+        for (size_t j = 0; j < count; j++)
         {
-            eraseFromArr(node->blocks, i, MAX_QUAD_TREE_NODE_BLOCKS, sizeof(const Block*));
-            node->blocks[MAX_QUAD_TREE_NODE_BLOCKS - 1] = NULL;
-            blockRemoved = true;
-            return;
+            uint8_t quadrants = *(uint8_t*)vectorGet(&builder->quadrants, firstQuadrants + j, sizeof(uint8_t));
+
+            // copied first, the push may move the list it comes from
+            uint32_t block = getBuilderBlock(builder, first + j);
+
+            if (quadrants & quadrantBits[i])
+                vectorPushBack(&builder->scratch, &block, sizeof(uint32_t));
+        }
+
+        size_t subnodeCount = vectorSize(&builder->scratch, sizeof(uint32_t)) - subnodeFirst;
+        buildQuadTreeNode(builder, subnodes + i, subnodeFirst, subnodeCount, depth + 1);
+
+        vectorResize(&builder->scratch, subnodeFirst, sizeof(uint32_t));
+    }
+
+    vectorResize(&builder->quadrants, firstQuadrants, sizeof(uint8_t));
+}
+
+static void runQuadTreeBuildTasks(void* arg)
+{
+    QuadTreeBuildWorker* worker = arg;
+
+    for (size_t i = 0; i < worker->taskCount; i++)
+    {
+        QuadTreeBuildTask* task = &worker->tasks[i];
+
+        if (task->worker != worker->index)
+            continue;
+
+        QuadTreeNode root;
+        initQuadTreeNode(&root, task->bounds, NO_QUAD_TREE_INDEX);
+
+        task->subtree = (QuadTree) {
+            .nodes = vectorCreate(),
+            .freeGroups = NO_QUAD_TREE_INDEX,
+            .blocks = worker->blocks,
+        };
+
+        vectorPushBack(&task->subtree.nodes, &root, sizeof(QuadTreeNode));
+
+        // the task's block list becomes the scratch of the subtree
+        QuadTreeBuilder builder = {
+            .quadTree = &task->subtree,
+            .scratch = task->blocks,
+            .quadrants = vectorCreate(),
+            .taskDepth = SIZE_MAX,
+            .tasks = NULL,
+        };
+
+        buildQuadTreeNode(&builder, 0, 0, vectorSize(&task->blocks, sizeof(uint32_t)), task->depth);
+        task->blocks = builder.scratch;
+        vectorFree(&builder.quadrants);
+    }
+}
+
+static int compareQuadTreeBuildTasks(const void* lhs, const void* rhs)
+{
+    size_t lhsSize = ((const QuadTreeBuildTask*)lhs)->blocks.size;
+    size_t rhsSize = ((const QuadTreeBuildTask*)rhs)->blocks.size;
+
+    return (lhsSize < rhsSize) - (lhsSize > rhsSize);
+}
+
+// the biggest subtrees are handed out first, each to the worker with the fewest blocks so far
+static void assignQuadTreeBuildTasks(QuadTreeBuildTask* tasks, size_t taskCount, size_t workerCount)
+{
+    qsort(tasks, taskCount, sizeof(QuadTreeBuildTask), compareQuadTreeBuildTasks);
+
+    size_t* workerLoads = checkedCalloc(workerCount, sizeof(size_t));
+
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        size_t worker = 0;
+
+        for (size_t j = 1; j < workerCount; j++)
+        {
+            if (workerLoads[j] < workerLoads[worker])
+                worker = j;
         }
+
+        tasks[i].worker = worker;
+        workerLoads[worker] += vectorSize(&tasks[i].blocks, sizeof(uint32_t));
     }
+
+    free(workerLoads);
 }
 
-void quadTreeRemoveBlock(QuadTree* quadTree, const Block* block)
+static inline uint32_t remapSubtreeNode(const QuadTreeBuildTask* task, uint32_t base, uint32_t index)
 {
-    blockRemoved = false;
-    quadTreeRemoveBlockImpl(quadTree->root, block);
+    if (index == NO_QUAD_TREE_INDEX)
+        return NO_QUAD_TREE_INDEX;
 
-    if (blockRemoved)
-        quadTree->elemCount--;
+    return index == 0 ? task->node : base + index;
 }
 
-static void quadTreeRetrieveAllByBoundsImpl(const QuadTreeNode* node, RectBounds bounds, Vector* result)
+// the root of the subtree replaces the node it was built for, the rest is appended to the node array
+static void mergeQuadTreeSubtree(QuadTree* quadTree, const QuadTreeBuildTask* task)
 {
-    if (quadTreeNodeHasSubnodes(node))
+    size_t subtreeSize = vectorSize(&task->subtree.nodes, sizeof(QuadTreeNode));
+    uint32_t base = (uint32_t)vectorSize(&quadTree->nodes, sizeof(QuadTreeNode)) - 1;
+
+    vectorResize(&quadTree->nodes, base + subtreeSize, sizeof(QuadTreeNode));
+
+    for (uint32_t i = 0; i < subtreeSize; i++)
     {
-        uint8_t quadrants = getNodeQuadrantsByBounds(node, &bounds);
+        QuadTreeNode node = *quadTreeGetNode(&task->subtree, i);
 
-        if (quadrants & TOP_LEFT_QUADRANT_BIT)
-            quadTreeRetrieveAllByBoundsImpl(node->nodes[TOP_LEFT_QUADRANT_INDEX], bounds, result);
+        node.nodes = remapSubtreeNode(task, base, node.nodes);
+        node.overflow = remapSubtreeNode(task, base, node.overflow);
+        node.parent = remapSubtreeNode(task, base, node.parent);
 
-        if (quadrants & TOP_RIGHT_QUADRANT_BIT)
-            quadTreeRetrieveAllByBoundsImpl(node->nodes[TOP_RIGHT_QUADRANT_INDEX], bounds, result);
+        if (i == 0)
+            node.parent = quadTreeGetNode(quadTree, task->node)->parent;
 
-        if (quadrants & BOTTOM_RIGHT_QUADRANT_BIT)
-            quadTreeRetrieveAllByBoundsImpl(node->nodes[BOTTOM_RIGHT_QUADRANT_INDEX], bounds, result);
+        *quadTreeGetNode(quadTree, remapSubtreeNode(task, base, i)) = node;
+    }
+}
 
-        if (quadrants & BOTTOM_LEFT_QUADRANT_BIT)
-            quadTreeRetrieveAllByBoundsImpl(node->nodes[BOTTOM_LEFT_QUADRANT_INDEX], bounds, result);
+static void buildQuadTreeSubtrees(QuadTree* quadTree, QuadTreeBuildTask* tasks, size_t taskCount,
+    size_t workerCount)
+{
+    assignQuadTreeBuildTasks(tasks, taskCount, workerCount);
 
-        return;
+    QuadTreeBuildWorker* workers = checkedMalloc(sizeof(QuadTreeBuildWorker) * workerCount);
+    bool* started = checkedCalloc(workerCount, sizeof(bool));
+
+    for (size_t i = 0; i < workerCount; i++)
+    {
+        workers[i] = (QuadTreeBuildWorker) {
+            .index = i,
+            .blocks = quadTree->blocks,
+            .tasks = tasks,
+            .taskCount = taskCount,
+        };
     }
 
-    for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS; i++)
+    // the calling thread is the first worker, the tasks of workers which failed to start are run by it too
+    for (size_t i = 1; i < workerCount; i++)
+        started[i] = threadStart(&workers[i].thread, runQuadTreeBuildTasks, &workers[i]);
+
+    for (size_t i = 0; i < workerCount; i++)
     {
-        if (node->blocks[i] == NULL)
-            break;
+        if (!started[i])
+            runQuadTreeBuildTasks(&workers[i]);
+    }
+
+    for (size_t i = 1; i < workerCount; i++)
+    {
+        if (started[i])
+            threadJoin(&workers[i].thread);
+    }
+
+    free(started);
+    free(workers);
+
+    size_t nodeCount = vectorSize(&quadTree->nodes, sizeof(QuadTreeNode));
+
+    for (size_t i = 0; i < taskCount; i++)
+        nodeCount += vectorSize(&tasks[i].subtree.nodes, sizeof(QuadTreeNode)) - 1;
+
+    vectorReserve(&quadTree->nodes, nodeCount, sizeof(QuadTreeNode));
+
+    for (size_t i = 0; i < taskCount; i++)
+    {
+        mergeQuadTreeSubtree(quadTree, &tasks[i]);
+
+        vectorFree(&tasks[i].subtree.nodes);
+        vectorFree(&tasks[i].blocks);
+    }
+}
+
+// links the leaf references of all the blocks once the nodes are in place
+static void linkQuadTreeLeafRefs(QuadTree* quadTree)
+{
+    uint32_t stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = QUAD_TREE_ROOT_INDEX;
 
-        bool foundDuplicate = false;
+    while (stackSize > 0)
+    {
+        uint32_t leaf = stack[--stackSize];
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+
+        if (quadTreeNodeHasSubnodes(node))
+        {
+            for (uint32_t i = 0; i < 4; i++)
+                stack[stackSize++] = node->nodes + i;
+
+            continue;
+        }
 
-        for (size_t j = 0; j < vectorSize(result, sizeof(const Block*)); j++)
+        for (uint32_t i = leaf; i != NO_QUAD_TREE_INDEX; i = quadTreeGetNode(quadTree, i)->overflow)
         {
-            const Block* tmp = *(const Block**)vectorGet(result, j, sizeof(const Block*));
+            node = quadTreeGetNode(quadTree, i);
 
-            if (tmp == node->blocks[i])
+            for (size_t j = 0; j < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[j] != NO_QUAD_TREE_INDEX; j++)
             {
-                foundDuplicate = true;
-                break;
+                if (quadTree->blockLeafRefs[node->blocks[j]] == NO_LEAF_REF)
+                    quadTree->elemCount++;
+
+                linkLeafRef(quadTree, node->blocks[j], leaf);
             }
         }
+    }
+}
+
+QuadTree quadTreeBuild(RectBounds bounds, const Block* blocks, size_t blockCount, size_t threadCount)
+{
+    QuadTree quadTree = quadTreeCreate(bounds, blocks, blockCount);
+
+    if (threadCount == 0)
+        threadCount = getHardwareThreadCount();
+
+    if (blockCount < QUAD_TREE_PARALLEL_BUILD_MIN_BLOCKS)
+        threadCount = 1;
+
+    Vector tasks = vectorCreate();
+
+    QuadTreeBuilder builder = {
+        .quadTree = &quadTree,
+        .scratch = vectorCreate(),
+        .quadrants = vectorCreate(),
+        .taskDepth = SIZE_MAX,
+        .tasks = &tasks,
+    };
+
+    // the top of the tree is built right away, deep enough to leave a few subtrees for every thread
+    if (threadCount > 1)
+    {
+        builder.taskDepth = 0;
+
+        for (size_t subtrees = 1; subtrees < QUAD_TREE_BUILD_TASKS_PER_THREAD * threadCount; subtrees *= 4)
+            builder.taskDepth++;
 
-        if (!foundDuplicate)
-            vectorPushBack(result, &node->blocks[i], sizeof(const Block*));
+        builder.taskDepth = min(builder.taskDepth, QUAD_TREE_MAX_DEPTH);
     }
+
+    vectorReserve(&builder.scratch, blockCount, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < blockCount; i++)
+        vectorPushBack(&builder.scratch, &i, sizeof(uint32_t));
+
+    buildQuadTreeNode(&builder, QUAD_TREE_ROOT_INDEX, 0, blockCount, 0);
+    vectorFree(&builder.scratch);
+    vectorFree(&builder.quadrants);
+
+    size_t taskCount = vectorSize(&tasks, sizeof(QuadTreeBuildTask));
+
+    if (taskCount > 0)
+        buildQuadTreeSubtrees(&quadTree, tasks.data, taskCount, threadCount);
+
+    vectorFree(&tasks);
+    linkQuadTreeLeafRefs(&quadTree);
+
+    return quadTree;
 }
 
-void quadTreeRetrieveAllByBounds(const QuadTree* quadTree, RectBounds bounds, Vector* result)
+// gathers the distinct blocks stored in the subnodes into the node's own block array, fails if there are more
+// of them than a single node can hold
+static bool gatherSubnodeBlocks(const QuadTree* quadTree, QuadTreeNode* node)
 {
-    quadTreeRetrieveAllByBoundsImpl(quadTree->root, bounds, result);
+    size_t blockCount = 0;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        const QuadTreeNode* subnode = quadTreeGetNode(quadTree, node->nodes + (uint32_t)i);
+
+        // overflow leaves are only kept behind full leaves, so their blocks wouldn't fit either
+        if (quadTreeNodeHasSubnodes(subnode) || subnode->overflow != NO_QUAD_TREE_INDEX)
+            return false;
+
+        for (size_t j = 0; j < MAX_QUAD_TREE_NODE_BLOCKS && subnode->blocks[j] != NO_QUAD_TREE_INDEX; j++)
+        {
+            uint32_t block = subnode->blocks[j];
+            bool alreadyGathered = false;
+
+            // blocks which overlap many quadrants are stored in each of them
+            for (size_t k = 0; k < blockCount; k++)
+            {
+                if (node->blocks[k] == block)
+                {
+                    alreadyGathered = true;
+                    break;
+                }
+            }
+
+            if (alreadyGathered)
+                continue;
+
+            if (blockCount == MAX_QUAD_TREE_NODE_BLOCKS)
+                return false;
+
+            setNodeBlock(quadTree, node, blockCount++, block);
+        }
+    }
+
+    return true;
 }
 
-void quadTreeFreeImpl(QuadTreeNode* node)
+// returns whether the node became a leaf
+static bool collapseQuadTreeNode(QuadTree* quadTree, uint32_t nodeIndex)
 {
-    if (quadTreeNodeHasSubnodes(node))
-        for (size_t i = 0; i < 4; i++)
-            quadTreeFreeImpl(node->nodes[i]);
+    QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
+    if (!gatherSubnodeBlocks(quadTree, node))
+    {
+        for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS; i++)
+            clearNodeBlock(node, i);
+
+        return false;
+    }
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        const QuadTreeNode* subnode = quadTreeGetNode(quadTree, node->nodes + i);
 
-    free(node);
+        for (size_t j = 0; j < MAX_QUAD_TREE_NODE_BLOCKS && subnode->blocks[j] != NO_QUAD_TREE_INDEX; j++)
+            unlinkLeafRef(quadTree, subnode->blocks[j], node->nodes + i);
+    }
+
+    for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[i] != NO_QUAD_TREE_INDEX; i++)
+        linkLeafRef(quadTree, node->blocks[i], nodeIndex);
+
+    releaseQuadTreeNodeGroup(quadTree, node->nodes);
+    node->nodes = NO_QUAD_TREE_INDEX;
+
+    return true;
 }
 
-void quadTreeFree(QuadTree* quadTree)
+static size_t findBlockInNode(const QuadTreeNode* node, uint32_t block)
 {
-    quadTreeFreeImpl(quadTree->root);
-    quadTree->root = NULL;
-    quadTree->elemCount = 0;
+    size_t slot = 0;
+
+    while (slot < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[slot] != block)
+        slot++;
+
+    return slot;
+}
+
+// erases the block from a leaf or its overflow leaves
+static void eraseBlockFromLeaf(QuadTree* quadTree, uint32_t leaf, uint32_t block)
+{
+    QuadTreeNode* previous = NULL;
+    uint32_t nodeIndex = leaf;
+    QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+    size_t slot = findBlockInNode(node, block);
+
+    while (slot == MAX_QUAD_TREE_NODE_BLOCKS && node->overflow != NO_QUAD_TREE_INDEX)
+    {
+        previous = node;
+        nodeIndex = node->overflow;
+        node = quadTreeGetNode(quadTree, nodeIndex);
+        slot = findBlockInNode(node, block);
+    }
+
+    if (slot == MAX_QUAD_TREE_NODE_BLOCKS)
+        return;
+
+    // the following blocks are shifted through the whole chain to keep the order in which they're visited, every
+    // leaf but the last one stays full
+    while (true)
+    {
+        size_t blockCount = quadTreeNodeBlockCount(node);
+
+        for (size_t j = slot; j + 1 < blockCount; j++)
+        {
+            node->blocks[j] = node->blocks[j + 1];
+            node->blockMinX[j] = node->blockMinX[j + 1];
+            node->blockMinY[j] = node->blockMinY[j + 1];
+            node->blockMaxX[j] = node->blockMaxX[j + 1];
+            node->blockMaxY[j] = node->blockMaxY[j + 1];
+        }
+
+        if (node->overflow == NO_QUAD_TREE_INDEX)
+        {
+            clearNodeBlock(node, blockCount - 1);
+            break;
+        }
+
+        QuadTreeNode* overflow = quadTreeGetNode(quadTree, node->overflow);
+        setNodeBlock(quadTree, node, blockCount - 1, overflow->blocks[0]);
+
+        previous = node;
+        nodeIndex = node->overflow;
+        node = overflow;
+        slot = 0;
+    }
+
+    if (previous && node->blocks[0] == NO_QUAD_TREE_INDEX)
+    {
+        previous->overflow = NO_QUAD_TREE_INDEX;
+        releaseQuadTreeNodeGroup(quadTree, nodeIndex);
+    }
+}
+
+bool quadTreeRemoveBlock(QuadTree* quadTree, const Block* block)
+{
+    uint32_t blockIndex = (uint32_t)(block - quadTree->blocks);
+    uint32_t* head = &quadTree->blockLeafRefs[blockIndex];
+
+    if (*head == NO_LEAF_REF)
+        return false;
+
+    // the block is erased from all of its leaves before any of them is collapsed, so that it isn't gathered
+    // into their parents
+    for (uint32_t i = *head; i != NO_LEAF_REF; i = getLeafRef(quadTree, i)->next)
+        eraseBlockFromLeaf(quadTree, getLeafRef(quadTree, i)->leaf, blockIndex);
+
+    while (*head != NO_LEAF_REF)
+    {
+        uint32_t index = *head;
+        uint32_t node = quadTreeGetNode(quadTree, getLeafRef(quadTree, index)->leaf)->parent;
+
+        *head = getLeafRef(quadTree, index)->next;
+        freeLeafRef(quadTree, index);
+
+        // leaves folded into their parent while collapsing the previous ones have no parent anymore
+        while (node != NO_QUAD_TREE_INDEX && collapseQuadTreeNode(quadTree, node))
+            node = quadTreeGetNode(quadTree, node)->parent;
+    }
+
+    quadTree->elemCount--;
+    return true;
+}
+
+// the query counters compile to nothing unless QUAD_TREE_QUERY_STATS is defined
+static inline void countQueries(QuadTree* quadTree, size_t count)
+{
+#ifdef QUAD_TREE_QUERY_STATS
+    quadTree->queryStats.queryCount += count;
+#else
+    (void)quadTree;
+    (void)count;
+#endif
+}
+
+static inline void countVisitedNode(QuadTree* quadTree)
+{
+#ifdef QUAD_TREE_QUERY_STATS
+    quadTree->queryStats.visitedNodeCount++;
+#else
+    (void)quadTree;
+#endif
+}
+
+static inline void countCandidates(QuadTree* quadTree, size_t count)
+{
+#ifdef QUAD_TREE_QUERY_STATS
+    quadTree->queryStats.candidateCount += count;
+#else
+    (void)quadTree;
+    (void)count;
+#endif
+}
+
+// returns false if the visitor stopped the query
+static bool visitQuadTreeLeaf(QuadTree* quadTree, uint32_t leaf, BlockVisitor visitor, void* context)
+{
+    for (; leaf != NO_QUAD_TREE_INDEX; leaf = quadTreeGetNode(quadTree, leaf)->overflow)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+        countVisitedNode(quadTree);
+
+        for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[i] != NO_QUAD_TREE_INDEX; i++)
+        {
+            // blocks which were inserted into many quadrants were already stamped by this query
+            uint32_t block = node->blocks[i];
+
+            if (!queryStampsMark(&quadTree->blockQueryStamps, block))
+                continue;
+
+            countCandidates(quadTree, 1);
+
+            if (!visitor(&quadTree->blocks[block], context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// returns false if the visitor stopped the query
+static bool visitQuadTreeLeafByCircle(QuadTree* quadTree, uint32_t leaf, Vec2 center, float radius,
+    BlockVisitor visitor, void* context)
+{
+    for (; leaf != NO_QUAD_TREE_INDEX; leaf = quadTreeGetNode(quadTree, leaf)->overflow)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+        countVisitedNode(quadTree);
+        uint32_t hits = quadTreeLeafCircleHits(node, center, radius);
+
+        for (size_t i = 0; hits; i++, hits >>= 1)
+        {
+            if (!(hits & 1u))
+                continue;
+
+            uint32_t block = node->blocks[i];
+
+            if (!queryStampsMark(&quadTree->blockQueryStamps, block))
+                continue;
+
+            countCandidates(quadTree, 1);
+
+            if (!visitor(&quadTree->blocks[block], context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// returns false if the visitor stopped the query
+static bool visitQuadTreeLeafBySweptCircle(QuadTree* quadTree, uint32_t leaf, Vec2 start, Vec2 end,
+    float radius, BlockVisitor visitor, void* context)
+{
+    for (; leaf != NO_QUAD_TREE_INDEX; leaf = quadTreeGetNode(quadTree, leaf)->overflow)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+        countVisitedNode(quadTree);
+
+        for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[i] != NO_QUAD_TREE_INDEX; i++)
+        {
+            RectBounds blockBounds = {
+                .topLeft = { .x = node->blockMinX[i], .y = node->blockMaxY[i] },
+                .bottomRight = { .x = node->blockMaxX[i], .y = node->blockMinY[i] },
+            };
+
+            if (!sweptCircleOverlapsBounds(start, end, radius, &blockBounds))
+                continue;
+
+            uint32_t block = node->blocks[i];
+
+            if (!queryStampsMark(&quadTree->blockQueryStamps, block))
+                continue;
+
+            countCandidates(quadTree, 1);
+
+            if (!visitor(&quadTree->blocks[block], context))
+                return false;
+        }
+    }
+
+    return true;
+}
+
+// pushed in reverse, so that the quadrants are visited in the same order as in the other traversals
+static inline size_t pushQuadrants(uint32_t* stack, size_t stackSize, uint32_t subnodes, uint8_t quadrants)
+{
+    assert(stackSize + 4 <= QUAD_TREE_VISIT_STACK_CAPACITY);
+
+    if (quadrants & BOTTOM_LEFT_QUADRANT_BIT)
+        stack[stackSize++] = subnodes + BOTTOM_LEFT_QUADRANT_INDEX;
+
+    if (quadrants & BOTTOM_RIGHT_QUADRANT_BIT)
+        stack[stackSize++] = subnodes + BOTTOM_RIGHT_QUADRANT_INDEX;
+
+    if (quadrants & TOP_RIGHT_QUADRANT_BIT)
+        stack[stackSize++] = subnodes + TOP_RIGHT_QUADRANT_INDEX;
+
+    if (quadrants & TOP_LEFT_QUADRANT_BIT)
+        stack[stackSize++] = subnodes + TOP_LEFT_QUADRANT_INDEX;
+
+    return stackSize;
+}
+
+bool quadTreeVisitByBounds(QuadTree* quadTree, RectBounds bounds, BlockVisitor visitor, void* context)
+{
+    queryStampsAdvance(&quadTree->blockQueryStamps);
+    countQueries(quadTree, 1);
+
+    uint32_t stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = QUAD_TREE_ROOT_INDEX;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            if (!visitQuadTreeLeaf(quadTree, nodeIndex, visitor, context))
+                return false;
+
+            continue;
+        }
+
+        countVisitedNode(quadTree);
+        stackSize = pushQuadrants(stack, stackSize, node->nodes, getNodeQuadrantsByBounds(node, &bounds));
+    }
+
+    return true;
+}
+
+void quadTreeRetrieveAllByBounds(QuadTree* quadTree, RectBounds bounds, Vector* result)
+{
+    quadTreeVisitByBounds(quadTree, bounds, pushBackBlockVisitor, result);
+}
+
+bool quadTreeVisitByCircle(QuadTree* quadTree, Vec2 center, float radius, BlockVisitor visitor, void* context)
+{
+    queryStampsAdvance(&quadTree->blockQueryStamps);
+    countQueries(quadTree, 1);
+
+    RectBounds circleBounds = {
+        .topLeft = { .x = center.x - radius, .y = center.y + radius },
+        .bottomRight = { .x = center.x + radius, .y = center.y - radius },
+    };
+
+    uint32_t stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = QUAD_TREE_ROOT_INDEX;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            if (!visitQuadTreeLeafByCircle(quadTree, nodeIndex, center, radius, visitor, context))
+                return false;
+
+            continue;
+        }
+
+        countVisitedNode(quadTree);
+        stackSize = pushQuadrants(stack, stackSize, node->nodes, getNodeQuadrantsByBounds(node, &circleBounds));
+    }
+
+    return true;
+}
+
+bool quadTreeVisitBySweptCircle(QuadTree* quadTree, Vec2 start, Vec2 end, float radius, BlockVisitor visitor,
+    void* context)
+{
+    queryStampsAdvance(&quadTree->blockQueryStamps);
+    countQueries(quadTree, 1);
+
+    uint32_t stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = QUAD_TREE_ROOT_INDEX;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            if (!visitQuadTreeLeafBySweptCircle(quadTree, nodeIndex, start, end, radius, visitor, context))
+                return false;
+
+            continue;
+        }
+
+        countVisitedNode(quadTree);
+        assert(stackSize + 4 <= QUAD_TREE_VISIT_STACK_CAPACITY);
+        const QuadTreeNode* subnodes = quadTreeGetNode(quadTree, node->nodes);
+
+        // the path may cross the quadrants in any order, they're visited in the usual one
+        for (uint32_t i = 4; i-- > 0;)
+        {
+            if (sweptCircleOverlapsBounds(start, end, radius, &subnodes[i].bounds))
+                stack[stackSize++] = node->nodes + i;
+        }
+    }
+
+    return true;
+}
+
+void quadTreeRetrieveAllBySweptCircle(QuadTree* quadTree, Vec2 start, Vec2 end, float radius, Vector* result)
+{
+    quadTreeVisitBySweptCircle(quadTree, start, end, radius, pushBackBlockVisitor, result);
+}
+
+// returns true if the leaf owns the top right corner of the overlap of two bounds, which lies in a single leaf,
+// quadrants own their edges towards the middle of the parent, the same way getNodeQuadrantsByBounds assigns them
+static inline bool leafOwnsOverlap(const RectBounds* leaf, const RectBounds* root, const RectBounds* a,
+    const RectBounds* b)
+{
+    float x = min(a->bottomRight.x, b->bottomRight.x);
+    float y = min(a->topLeft.y, b->topLeft.y);
+
+    return (x > leaf->topLeft.x || leaf->topLeft.x == root->topLeft.x)
+        && (x <= leaf->bottomRight.x || leaf->bottomRight.x == root->bottomRight.x)
+        && (y > leaf->bottomRight.y || leaf->bottomRight.y == root->bottomRight.y)
+        && (y <= leaf->topLeft.y || leaf->topLeft.y == root->topLeft.y);
+}
+
+static void pairLeafBlocks(QuadTree* quadTree, uint32_t leaf, const uint32_t* queries, size_t queryCount,
+    const RectBounds* bounds, Vector* result)
+{
+    const RectBounds* leafBounds = &quadTreeGetNode(quadTree, leaf)->bounds;
+    const RectBounds* rootBounds = &quadTreeGetNode(quadTree, QUAD_TREE_ROOT_INDEX)->bounds;
+
+    for (; leaf != NO_QUAD_TREE_INDEX; leaf = quadTreeGetNode(quadTree, leaf)->overflow)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+        countVisitedNode(quadTree);
+
+        for (size_t i = 0; i < queryCount; i++)
+        {
+            const RectBounds* queryBounds = &bounds[queries[i]];
+            uint32_t overlaps = 0;
+
+            // empty slots never overlap, like in quadTreeLeafCircleHits
+            for (size_t j = 0; j < QUAD_TREE_NODE_BOUNDS_CAPACITY; j += 4)
+            {
+                overlaps |= getBoundsGroupOverlapMask(&node->blockMinX[j], &node->blockMinY[j],
+                    &node->blockMaxX[j], &node->blockMaxY[j], queryBounds) << j;
+            }
+
+            for (size_t j = 0; overlaps; j++, overlaps >>= 1)
+            {
+                if (!(overlaps & 1u))
+                    continue;
+
+                RectBounds blockBounds = {
+                    .topLeft = { .x = node->blockMinX[j], .y = node->blockMaxY[j] },
+                    .bottomRight = { .x = node->blockMaxX[j], .y = node->blockMinY[j] },
+                };
+
+                // a block stored in many leaves is only paired in the one which owns its overlap with the query
+                if (leafOwnsOverlap(leafBounds, rootBounds, queryBounds, &blockBounds))
+                {
+                    QuadTreeQueryPair pair = { .query = queries[i], .block = node->blocks[j] };
+                    vectorPushBack(result, &pair, sizeof(QuadTreeQueryPair));
+                }
+            }
+        }
+    }
+}
+
+// finishes a subtree which only a single query of the batch reaches, the same way quadTreeVisitByBounds does
+static void pairSubtreeBlocks(QuadTree* quadTree, uint32_t nodeIndex, uint32_t query,
+    const RectBounds* bounds, Vector* result)
+{
+    uint32_t stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = nodeIndex;
+
+    while (stackSize > 0)
+    {
+        nodeIndex = stack[--stackSize];
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            pairLeafBlocks(quadTree, nodeIndex, &query, 1, bounds, result);
+            continue;
+        }
+
+        countVisitedNode(quadTree);
+        stackSize = pushQuadrants(stack, stackSize, node->nodes, getNodeQuadrantsByBounds(node, &bounds[query]));
+    }
+}
+
+void quadTreeRetrieveAllPairsByBounds(QuadTree* quadTree, const RectBounds* bounds, size_t boundsCount,
+    Vector* result)
+{
+    size_t firstPair = vectorSize(result, sizeof(QuadTreeQueryPair));
+    countQueries(quadTree, boundsCount);
+
+    if (boundsCount < QUAD_TREE_MIN_BATCH_QUERIES)
+    {
+        for (uint32_t i = 0; i < boundsCount; i++)
+            pairSubtreeBlocks(quadTree, QUAD_TREE_ROOT_INDEX, i, bounds, result);
+
+        countCandidates(quadTree, vectorSize(result, sizeof(QuadTreeQueryPair)) - firstPair);
+        return;
+    }
+
+    Vector* queries = &quadTree->batchQueries;
+    vectorResize(queries, boundsCount, sizeof(uint32_t));
+
+    for (uint32_t i = 0; i < boundsCount; i++)
+        *(uint32_t*)vectorGet(queries, i, sizeof(uint32_t)) = i;
+
+    QuadTreeBatchEntry stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = (QuadTreeBatchEntry){
+        .node = QUAD_TREE_ROOT_INDEX,
+        .firstQuery = 0,
+        .queryCount = (uint32_t)boundsCount,
+    };
+
+    while (stackSize > 0)
+    {
+        QuadTreeBatchEntry entry = stack[--stackSize];
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, entry.node);
+        const uint32_t* activeQueries = &entry.firstQuery;
+
+        // the lists of the entries below on the stack come before this one, everything after it is done with
+        if (entry.queryCount > 1)
+        {
+            vectorResize(queries, entry.firstQuery + entry.queryCount, sizeof(uint32_t));
+            activeQueries = vectorGet(queries, entry.firstQuery, sizeof(uint32_t));
+        }
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            pairLeafBlocks(quadTree, entry.node, activeQueries, entry.queryCount, bounds, result);
+            continue;
+        }
+
+        assert(stackSize + 4 <= QUAD_TREE_VISIT_STACK_CAPACITY);
+
+        if (entry.queryCount == 1)
+        {
+            pairSubtreeBlocks(quadTree, entry.node, entry.firstQuery, bounds, result);
+            continue;
+        }
+
+        countVisitedNode(quadTree);
+
+        // every subnode gets room for all of the queries, the lists are laid out in the order in which the
+        // subnodes are pushed, so the list of the subnode popped next is always the last one
+        uint32_t firstQuery = (uint32_t)vectorSize(queries, sizeof(uint32_t));
+        vectorResize(queries, firstQuery + 4 * entry.queryCount, sizeof(uint32_t));
+
+        activeQueries = vectorGet(queries, entry.firstQuery, sizeof(uint32_t));
+        uint32_t* subnodeQueries = vectorGet(queries, firstQuery, sizeof(uint32_t));
+        uint32_t subnodeQueryCounts[4] = { 0 };
+
+        for (uint32_t i = 0; i < entry.queryCount; i++)
+        {
+            uint32_t query = activeQueries[i];
+            uint8_t quadrants = getNodeQuadrantsByBounds(node, &bounds[query]);
+
+            for (uint32_t j = 0; j < 4; j++)
+            {
+                if (quadrants & quadrantBits[j])
+                    subnodeQueries[(3 - j) * entry.queryCount + subnodeQueryCounts[j]++] = query;
+            }
+        }
+
+        for (uint32_t j = 4; j-- > 0;)
+        {
+            if (subnodeQueryCounts[j] == 0)
+                continue;
+
+            uint32_t listOffset = (3 - j) * entry.queryCount;
+
+            stack[stackSize++] = (QuadTreeBatchEntry){
+                .node = node->nodes + j,
+                .firstQuery = subnodeQueryCounts[j] == 1 ? subnodeQueries[listOffset] : firstQuery + listOffset,
+                .queryCount = subnodeQueryCounts[j],
+            };
+        }
+    }
+
+    countCandidates(quadTree, vectorSize(result, sizeof(QuadTreeQueryPair)) - firstPair);
+}
+
+static void pushQueueEntry(Vector* queue, QuadTreeQueueEntry entry)
+{
+    vectorPushBack(queue, &entry, sizeof(QuadTreeQueueEntry));
+
+    QuadTreeQueueEntry* entries = queue->data;
+    size_t i = vectorSize(queue, sizeof(QuadTreeQueueEntry)) - 1;
+
+    // the new entry rises above every farther parent
+    while (i > 0 && entries[(i - 1) / 2].distanceSquared > entry.distanceSquared)
+    {
+        entries[i] = entries[(i - 1) / 2];
+        i = (i - 1) / 2;
+    }
+
+    entries[i] = entry;
+}
+
+static QuadTreeQueueEntry popQueueEntry(Vector* queue)
+{
+    QuadTreeQueueEntry* entries = queue->data;
+    size_t count = vectorSize(queue, sizeof(QuadTreeQueueEntry)) - 1;
+    QuadTreeQueueEntry nearest = entries[0];
+    QuadTreeQueueEntry last = entries[count];
+    size_t i = 0;
+
+    // the last entry sinks from the top below every nearer child
+    for (size_t child = 1; child < count; child = 2 * i + 1)
+    {
+        if (child + 1 < count && entries[child + 1].distanceSquared < entries[child].distanceSquared)
+            child++;
+
+        if (entries[child].distanceSquared >= last.distanceSquared)
+            break;
+
+        entries[i] = entries[child];
+        i = child;
+    }
+
+    entries[i] = last;
+    vectorResize(queue, count, sizeof(QuadTreeQueueEntry));
+
+    return nearest;
+}
+
+static void pushNearestLeafBlocks(QuadTree* quadTree, uint32_t leaf, Vec2 point, float maxDistanceSquared)
+{
+    for (; leaf != NO_QUAD_TREE_INDEX; leaf = quadTreeGetNode(quadTree, leaf)->overflow)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+        countVisitedNode(quadTree);
+
+        for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[i] != NO_QUAD_TREE_INDEX; i++)
+        {
+            RectBounds blockBounds = {
+                .topLeft = { .x = node->blockMinX[i], .y = node->blockMaxY[i] },
+                .bottomRight = { .x = node->blockMaxX[i], .y = node->blockMinY[i] },
+            };
+
+            uint32_t block = node->blocks[i];
+            float distanceSquared = getPointBoundsDistanceSquared(point, &blockBounds);
+
+            // a block is as far from the point in every leaf which stores it, so only its first entry is kept
+            if (distanceSquared <= maxDistanceSquared && queryStampsMark(&quadTree->blockQueryStamps, block))
+            {
+                QuadTreeQueueEntry entry = { .distanceSquared = distanceSquared, .node = leaf, .block = block };
+                pushQueueEntry(&quadTree->nearestQueue, entry);
+            }
+        }
+    }
+}
+
+static void pushNearestNode(QuadTree* quadTree, uint32_t nodeIndex, Vec2 point, float maxDistanceSquared)
+{
+    const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+    float distanceSquared = getPointBoundsDistanceSquared(point, &node->bounds);
+
+    if (distanceSquared <= maxDistanceSquared)
+    {
+        QuadTreeQueueEntry entry = {
+            .distanceSquared = distanceSquared,
+            .node = nodeIndex,
+            .block = NO_QUAD_TREE_INDEX,
+        };
+        pushQueueEntry(&quadTree->nearestQueue, entry);
+    }
+}
+
+// nodes are never nearer than the blocks inside of them, so the blocks leave the queue in the order of distance
+static bool quadTreeVisitNearestImpl(QuadTree* quadTree, Vec2 point, float maxDistanceSquared,
+    BlockVisitor visitor, void* context)
+{
+    queryStampsAdvance(&quadTree->blockQueryStamps);
+    countQueries(quadTree, 1);
+
+    Vector* queue = &quadTree->nearestQueue;
+    vectorClear(queue);
+    pushNearestNode(quadTree, QUAD_TREE_ROOT_INDEX, point, maxDistanceSquared);
+
+    while (vectorSize(queue, sizeof(QuadTreeQueueEntry)) > 0)
+    {
+        QuadTreeQueueEntry entry = popQueueEntry(queue);
+
+        if (entry.block != NO_QUAD_TREE_INDEX)
+        {
+            countCandidates(quadTree, 1);
+
+            if (!visitor(&quadTree->blocks[entry.block], context))
+                return false;
+
+            continue;
+        }
+
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, entry.node);
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            pushNearestLeafBlocks(quadTree, entry.node, point, maxDistanceSquared);
+            continue;
+        }
+
+        countVisitedNode(quadTree);
+        uint32_t subnodes = node->nodes;
+
+        for (uint32_t i = 0; i < 4; i++)
+            pushNearestNode(quadTree, subnodes + i, point, maxDistanceSquared);
+    }
+
+    return true;
+}
+
+bool quadTreeVisitNearest(QuadTree* quadTree, Vec2 point, float maxDistance, BlockVisitor visitor, void* context)
+{
+    return quadTreeVisitNearestImpl(quadTree, point, maxDistance * maxDistance, visitor, context);
+}
+
+// fills an array with the visited blocks until it's full
+typedef struct NearestBlocks
+{
+    const Block** blocks;
+    size_t count;
+    size_t capacity;
+} NearestBlocks;
+
+static bool gatherNearestBlockVisitor(const Block* block, void* context)
+{
+    NearestBlocks* nearest = context;
+    nearest->blocks[nearest->count++] = block;
+
+    return nearest->count < nearest->capacity;
+}
+
+size_t quadTreeFindNearest(QuadTree* quadTree, Vec2 point, size_t count, const Block** result)
+{
+    if (count == 0)
+        return 0;
+
+    NearestBlocks nearest = { .blocks = result, .count = 0, .capacity = count };
+    quadTreeVisitNearestImpl(quadTree, point, FLT_MAX, gatherNearestBlockVisitor, &nearest);
+
+    return nearest.count;
+}
+
+void quadTreeRetrieveAllInRadius(QuadTree* quadTree, Vec2 point, float radius, Vector* result)
+{
+    quadTreeVisitNearest(quadTree, point, radius, pushBackBlockVisitor, result);
+}
+
+// returns true and the distance at which a circle cast reaches the bounds if it does so within maxDistance, the
+// test is conservative around the corners
+static bool castCircleAtNode(Vec2 origin, Vec2 direction, float radius, const RectBounds* bounds,
+    float maxDistance, float* distance)
+{
+    float enter = 0.0f;
+    float exit = maxDistance;
+
+    if (!clipSegmentToSlab(origin.x, direction.x, bounds->topLeft.x - radius, bounds->bottomRight.x + radius,
+            &enter, &exit)
+        || !clipSegmentToSlab(origin.y, direction.y, bounds->bottomRight.y - radius, bounds->topLeft.y + radius,
+            &enter, &exit))
+    {
+        return false;
+    }
+
+    *distance = enter;
+    return true;
+}
+
+static void castCircleAtLeaf(const QuadTree* quadTree, uint32_t leaf, Vec2 origin, Vec2 direction, float radius,
+    BlockCastHit* hit)
+{
+    for (; leaf != NO_QUAD_TREE_INDEX; leaf = quadTreeGetNode(quadTree, leaf)->overflow)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, leaf);
+
+        for (size_t i = 0; i < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[i] != NO_QUAD_TREE_INDEX; i++)
+        {
+            RectBounds blockBounds = {
+                .topLeft = { .x = node->blockMinX[i], .y = node->blockMaxY[i] },
+                .bottomRight = { .x = node->blockMaxX[i], .y = node->blockMinY[i] },
+            };
+
+            float distance;
+            Vec2 normal;
+
+            // blocks stored in many leaves are simply tested again, the cast only keeps the nearest hit
+            if (castCircleAtBounds(origin, direction, radius, &blockBounds, hit->distance, &distance, &normal)
+                && (hit->block == NULL || distance < hit->distance))
+            {
+                *hit = (BlockCastHit){
+                    .block = &quadTree->blocks[node->blocks[i]],
+                    .distance = distance,
+                    .normal = normal,
+                };
+            }
+        }
+    }
+}
+
+bool quadTreeCircleCast(const QuadTree* quadTree, Vec2 origin, Vec2 direction, float radius, float maxDistance,
+    BlockCastHit* hit)
+{
+    BlockCastHit nearest = { .block = NULL, .distance = maxDistance, .normal = { .x = 0.0f, .y = 0.0f } };
+
+    QuadTreeCastEntry stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+
+    float rootDistance;
+
+    if (castCircleAtNode(origin, direction, radius, &quadTreeGetNode(quadTree, QUAD_TREE_ROOT_INDEX)->bounds,
+            maxDistance, &rootDistance))
+    {
+        stack[stackSize++] = (QuadTreeCastEntry){ .node = QUAD_TREE_ROOT_INDEX, .distance = rootDistance };
+    }
+
+    while (stackSize > 0)
+    {
+        QuadTreeCastEntry entry = stack[--stackSize];
+
+        // nothing in a node reached after the nearest hit so far can be hit before it
+        if (nearest.block != NULL && entry.distance > nearest.distance)
+            continue;
+
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, entry.node);
+
+        if (!quadTreeNodeHasSubnodes(node))
+        {
+            castCircleAtLeaf(quadTree, entry.node, origin, direction, radius, &nearest);
+            continue;
+        }
+
+        QuadTreeCastEntry subnodes[4];
+        size_t subnodeCount = 0;
+
+        // the subnodes are sorted from the farthest to the nearest, so that the nearest is popped first
+        for (uint32_t i = 0; i < 4; i++)
+        {
+            QuadTreeCastEntry subnode = { .node = node->nodes + i };
+            const RectBounds* bounds = &quadTreeGetNode(quadTree, subnode.node)->bounds;
+
+            if (!castCircleAtNode(origin, direction, radius, bounds, nearest.distance, &subnode.distance))
+                continue;
+
+            size_t j = subnodeCount++;
+
+            for (; j > 0 && subnodes[j - 1].distance < subnode.distance; j--)
+                subnodes[j] = subnodes[j - 1];
+
+            subnodes[j] = subnode;
+        }
+
+        assert(stackSize + subnodeCount <= QUAD_TREE_VISIT_STACK_CAPACITY);
+
+        for (size_t i = 0; i < subnodeCount; i++)
+            stack[stackSize++] = subnodes[i];
+    }
+
+    if (nearest.block == NULL)
+        return false;
+
+    *hit = nearest;
+    return true;
+}
+
+bool quadTreeRaycast(const QuadTree* quadTree, Vec2 origin, Vec2 direction, float maxDistance, BlockCastHit* hit)
+{
+    return quadTreeCircleCast(quadTree, origin, direction, 0.0f, maxDistance, hit);
+}
+
+static void quadTreeGetStatsImpl(const QuadTree* quadTree, uint32_t nodeIndex, size_t depth, QuadTreeStats* stats)
+{
+    const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
+    stats->nodeCount++;
+    stats->depth = max(stats->depth, depth);
+
+    if (!quadTreeNodeHasSubnodes(node))
+    {
+        assert(depth <= QUAD_TREE_MAX_DEPTH);
+
+        for (uint32_t i = nodeIndex; i != NO_QUAD_TREE_INDEX; i = quadTreeGetNode(quadTree, i)->overflow)
+        {
+            size_t blockCount = quadTreeNodeBlockCount(quadTreeGetNode(quadTree, i));
+
+            stats->leafCount++;
+            stats->leafDepthHistogram[depth]++;
+            stats->leafOccupancyHistogram[blockCount]++;
+            stats->blockReferenceCount += blockCount;
+
+            if (i != nodeIndex)
+            {
+                stats->nodeCount++;
+                stats->overflowLeafCount++;
+            }
+        }
+
+        return;
+    }
+
+    for (uint32_t i = 0; i < 4; i++)
+        quadTreeGetStatsImpl(quadTree, node->nodes + i, depth + 1, stats);
+}
+
+QuadTreeStats quadTreeGetStats(const QuadTree* quadTree)
+{
+    QuadTreeStats stats;
+    memset(&stats, 0, sizeof(QuadTreeStats));
+    quadTreeGetStatsImpl(quadTree, QUAD_TREE_ROOT_INDEX, 0, &stats);
+
+    // every leaf which stores a block adds a reference to its list
+    for (size_t i = 0; i < quadTree->blockCount; i++)
+    {
+        uint32_t ref = quadTree->blockLeafRefs[i];
+
+        if (ref != NO_LEAF_REF && getLeafRef(quadTree, ref)->next != NO_LEAF_REF)
+            stats.duplicatedBlockCount++;
+    }
+
+    stats.memoryBytes = sizeof(QuadTree) + quadTree->nodes.allocatedSize + quadTree->leafRefs.allocatedSize
+        + sizeof(uint32_t) * quadTree->blockCount + sizeof(uint32_t) * quadTree->blockQueryStamps.count
+        + quadTree->nearestQueue.allocatedSize + quadTree->batchQueries.allocatedSize;
+
+    return stats;
+}
+
+static inline double getRatio(size_t numerator, size_t denominator)
+{
+    return denominator > 0 ? (double)numerator / (double)denominator : 0.0;
+}
+
+void quadTreePrintStats(const QuadTree* quadTree, FILE* file)
+{
+    QuadTreeStats stats = quadTreeGetStats(quadTree);
+    const QuadTreeQueryStats* queryStats = &quadTree->queryStats;
+
+    fprintf(file, "[Quad Tree]: %zu blocks, %zu nodes, %zu leaves (%zu overflow), depth %zu, %.1f KiB.\n",
+        quadTree->elemCount, stats.nodeCount, stats.leafCount, stats.overflowLeafCount, stats.depth,
+        (double)stats.memoryBytes / 1024.0);
+    fprintf(file, "  %.2f leaves per block, %zu blocks stored in more than one leaf.\n",
+        getRatio(stats.blockReferenceCount, quadTree->elemCount), stats.duplicatedBlockCount);
+
+    fprintf(file, "  leaves by depth:");
+
+    for (size_t i = 0; i <= stats.depth; i++)
+        fprintf(file, " %zu", stats.leafDepthHistogram[i]);
+
+    fprintf(file, "\n  leaves by blocks:");
+
+    for (size_t i = 0; i <= MAX_QUAD_TREE_NODE_BLOCKS; i++)
+        fprintf(file, " %zu", stats.leafOccupancyHistogram[i]);
+
+    fprintf(file, "\n  %zu queries, %.1f nodes visited and %.1f candidates per query.\n", queryStats->queryCount,
+        getRatio(queryStats->visitedNodeCount, queryStats->queryCount),
+        getRatio(queryStats->candidateCount, queryStats->queryCount));
+}
+
+void quadTreeWriteStatsCsvHeader(FILE* file)
+{
+    fprintf(file, "label,blocks,nodes,leaves,overflow_leaves,depth,block_references,duplicated_blocks,"
+        "memory_bytes,queries,visited_nodes,candidates");
+
+    for (size_t i = 0; i <= QUAD_TREE_MAX_DEPTH; i++)
+        fprintf(file, ",leaves_at_depth_%zu", i);
+
+    for (size_t i = 0; i <= MAX_QUAD_TREE_NODE_BLOCKS; i++)
+        fprintf(file, ",leaves_with_%zu_blocks", i);
+
+    fprintf(file, "\n");
+}
+
+void quadTreeWriteStatsCsv(const QuadTree* quadTree, const char* label, FILE* file)
+{
+    QuadTreeStats stats = quadTreeGetStats(quadTree);
+    const QuadTreeQueryStats* queryStats = &quadTree->queryStats;
+
+    fprintf(file, "%s,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu,%zu", label, quadTree->elemCount, stats.nodeCount,
+        stats.leafCount, stats.overflowLeafCount, stats.depth, stats.blockReferenceCount,
+        stats.duplicatedBlockCount, stats.memoryBytes, queryStats->queryCount, queryStats->visitedNodeCount,
+        queryStats->candidateCount);
+
+    for (size_t i = 0; i <= QUAD_TREE_MAX_DEPTH; i++)
+        fprintf(file, ",%zu", stats.leafDepthHistogram[i]);
+
+    for (size_t i = 0; i <= MAX_QUAD_TREE_NODE_BLOCKS; i++)
+        fprintf(file, ",%zu", stats.leafOccupancyHistogram[i]);
+
+    fprintf(file, "\n");
+}
+
+void quadTreeFree(QuadTree* quadTree)
+{
+    vectorFree(&quadTree->nodes);
+    quadTree->freeGroups = NO_QUAD_TREE_INDEX;
+    quadTree->elemCount = 0;
+
+    vectorFree(&quadTree->leafRefs);
+    free(quadTree->blockLeafRefs);
+    quadTree->blockLeafRefs = NULL;
+
+    queryStampsFree(&quadTree->blockQueryStamps);
+    vectorFree(&quadTree->nearestQueue);
+    vectorFree(&quadTree->batchQueries);
 }
@@ -4,37 +4,141 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
 
+#include "block_visitor.h"
+#include "bounds_soa.h"
 #include "entities.h"
+#include "query_stamps.h"
 #include "vector.h"
 
-/// @brief Maximum number of blocks which can be store if a quad tree node.
+/// @brief Maximum number of blocks which can be store if a quad tree node. Can be set at build time with the
+/// QUAD_TREE_NODE_CAPACITY CMake option.
+#ifndef MAX_QUAD_TREE_NODE_BLOCKS
 #define MAX_QUAD_TREE_NODE_BLOCKS 5
+#endif
 
-typedef struct QuadTreeNode QuadTreeNode;
+/// @brief Depth at which quad tree leaves are no longer split. Blocks which don't fit into a full leaf at this
+/// depth go to its overflow leaves. Can be set at build time with the QUAD_TREE_MAX_DEPTH CMake option.
+#ifndef QUAD_TREE_MAX_DEPTH
+#define QUAD_TREE_MAX_DEPTH 8
+#endif
 
-/// @brief A quad tree node.
+/// @brief Length of the block bounds arrays in a quad tree node, rounded up to whole SIMD groups. Slots without
+/// a block hold bounds which no circle on the board can reach.
+#define QUAD_TREE_NODE_BOUNDS_CAPACITY ((MAX_QUAD_TREE_NODE_BLOCKS + 3) / 4 * 4)
+
+/// @brief Number of sibling groups (four nodes each) which a new quad tree reserves room for. The node array
+/// doubles whenever it runs out of room.
+#define QUAD_TREE_NODE_POOL_INITIAL_GROUPS 16
+
+/// @brief Capacity of the node stack used by the quad tree queries. Every visited node above the maximum depth
+/// pushes at most four subnodes in place of itself.
+#define QUAD_TREE_VISIT_STACK_CAPACITY (3 * QUAD_TREE_MAX_DEPTH + 1)
+
+/// @brief Number of blocks below which quadTreeBuild doesn't start any threads.
+#define QUAD_TREE_PARALLEL_BUILD_MIN_BLOCKS 4096
+
+/// @brief Minimum number of subtrees which quadTreeBuild splits the work into for every thread, so that the
+/// threads stay busy even when the blocks aren't spread evenly.
+#define QUAD_TREE_BUILD_TASKS_PER_THREAD 4
+
+/// @brief Number of queries below which quadTreeRetrieveAllPairsByBounds walks the tree once for every query,
+/// since a few queries share too few nodes for splitting the batch between them to pay off.
+#define QUAD_TREE_MIN_BATCH_QUERIES 16
+
+/// @brief Index of the root in the node array of a quad tree.
+#define QUAD_TREE_ROOT_INDEX 0
+
+/// @brief Index used for missing quad tree nodes and empty block slots.
+#define NO_QUAD_TREE_INDEX UINT32_MAX
+
+/// @brief A quad tree node. Nodes refer to each other and to the blocks by index, so they stay valid when the
+/// node array is moved or copied.
 typedef struct QuadTreeNode
 {
     RectBounds bounds;
-    QuadTreeNode* nodes[4];
-    const Block* blocks[MAX_QUAD_TREE_NODE_BLOCKS];
+    uint32_t parent; // none for the root and for pooled nodes, the first leaf in the chain for overflows
+    uint32_t nodes; // first of four contiguous subnodes or none
+    uint32_t overflow; // leaf with the blocks which didn't fit into this one at QUAD_TREE_MAX_DEPTH or none
+    uint32_t blocks[MAX_QUAD_TREE_NODE_BLOCKS]; // indices in the block array passed to quadTreeCreate
+
+    // bounds of the stored blocks, kept in the node so that the whole leaf can be tested without touching them
+    float blockMinX[QUAD_TREE_NODE_BOUNDS_CAPACITY];
+    float blockMinY[QUAD_TREE_NODE_BOUNDS_CAPACITY];
+    float blockMaxX[QUAD_TREE_NODE_BOUNDS_CAPACITY];
+    float blockMaxY[QUAD_TREE_NODE_BOUNDS_CAPACITY];
 } QuadTreeNode;
 
+/// @brief Counters of the work done by the queries of a quad tree. They're only updated when the code is compiled
+/// with QUAD_TREE_QUERY_STATS defined, which the LOG_QUAD_TREE_STATS and QUAD_TREE_STATS_CSV CMake options do.
+/// Ray and circle casts take a const tree, so they aren't counted.
+typedef struct QuadTreeQueryStats
+{
+    size_t queryCount; // every area of a batched query counts as a query
+    size_t visitedNodeCount; // nodes whose subnodes or blocks were tested, overflow leaves included
+    size_t candidateCount; // blocks passed to the visitors or pairs found by the batched queries
+} QuadTreeQueryStats;
+
 /// @brief Quad tree structure used to efficiently find blocks on the board within a certain. It doesn't
-/// manage the objects on its own, just stores pointers to them.
+/// manage the objects on its own, just stores their indices in the block array passed to quadTreeCreate. All
+/// of its state lives in the structure, so separate quad trees can be used from different threads. Nothing
+/// in it points into its own memory, so it can be copied with quadTreeClone one array at a time.
 typedef struct QuadTree
 {
-    QuadTreeNode* root;
     size_t elemCount;
+    QuadTreeQueryStats queryStats; // since the tree was created, copies start counting from zero
+
+    // PRIVATE
+    Vector nodes; // QuadTreeNode, the root followed by groups of four siblings
+    uint32_t freeGroups; // groups released by collapsed nodes, linked through the nodes index of their first node
+    const Block* blocks; // the only pointer out of the tree, quadTreeClone points copies at moved blocks
+    size_t blockCount;
+    Vector leafRefs; // QuadTreeLeafRef, linked into a list of leaves for every stored block
+    uint32_t* blockLeafRefs; // index of the first leaf reference of every block in the block array
+    uint32_t freeLeafRefs; // index of the first unused leaf reference
+    QueryStamps blockQueryStamps; // used to skip blocks stored in many leaves
+    Vector nearestQueue; // binary heap of the nodes and blocks yet to be visited by the nearest block queries
+    Vector batchQueries; // lists of the queries of a batched query which reach the nodes on its stack
 } QuadTree;
 
+/// @brief A block found by a batched query, together with the query which found it.
+typedef struct QuadTreeQueryPair
+{
+    uint32_t query; // index in the array of query bounds
+    uint32_t block; // index in the block array passed to quadTreeCreate
+} QuadTreeQueryPair;
+
+/// @brief Shape of a quad tree at some point in time.
+typedef struct QuadTreeStats
+{
+    size_t nodeCount;
+    size_t leafCount;
+    size_t overflowLeafCount; // included in the node and leaf counts
+    size_t depth; // depth of the deepest leaf, the root is at depth 0
+    size_t leafDepthHistogram[QUAD_TREE_MAX_DEPTH + 1]; // leaves at every depth, overflow leaves at their chain's
+    size_t leafOccupancyHistogram[MAX_QUAD_TREE_NODE_BLOCKS + 1]; // leaves holding every number of blocks
+    size_t blockReferenceCount; // blocks stored in the leaves, counted once for every leaf which stores them
+    size_t duplicatedBlockCount; // blocks stored in more than one leaf
+    size_t memoryBytes; // memory held by the tree, including the unused room in its arrays
+} QuadTreeStats;
+
+/// @brief Returns a node of a quad tree. The pointer is only valid until the next insertion.
+/// @param quadTree Pointer to the quad tree.
+/// @param index Index of the node, QUAD_TREE_ROOT_INDEX for the root.
+/// @return Pointer to the node.
+static inline QuadTreeNode* quadTreeGetNode(const QuadTree* quadTree, uint32_t index)
+{
+    return vectorGet(&quadTree->nodes, index, sizeof(QuadTreeNode));
+}
+
 /// @brief Returns whether a quad tree node has subnodes.
 /// @param node Pointer to the node.
 /// @return True if the node has subnodes, false otherwise.
 static inline bool quadTreeNodeHasSubnodes(const QuadTreeNode* node)
 {
-    return node->nodes[0] != NULL;
+    return node->nodes != NO_QUAD_TREE_INDEX;
 }
 
 /// @brief Returns whether a quad tree node is full.
@@ -42,26 +146,193 @@ static inline bool quadTreeNodeHasSubnodes(const QuadTreeNode* node)
 /// @return True if the node is full, false otherwise.
 static inline bool quadTreeNodeFull(const QuadTreeNode* node)
 {
-    return node->blocks[MAX_QUAD_TREE_NODE_BLOCKS - 1] != NULL;
+    return node->blocks[MAX_QUAD_TREE_NODE_BLOCKS - 1] != NO_QUAD_TREE_INDEX;
+}
+
+/// @brief Returns the number of blocks stored in a quad tree node.
+/// @param node Pointer to the node.
+/// @return Number of stored blocks.
+static inline size_t quadTreeNodeBlockCount(const QuadTreeNode* node)
+{
+    size_t count = 0;
+
+    while (count < MAX_QUAD_TREE_NODE_BLOCKS && node->blocks[count] != NO_QUAD_TREE_INDEX)
+        count++;
+
+    return count;
+}
+
+/// @brief Tests a circle against all the blocks stored in a quad tree leaf at once.
+/// @param leaf Pointer to the leaf.
+/// @param center Center of the circle.
+/// @param radius Radius of the circle.
+/// @return Bitmask with the bit i set if the circle collides with the block in the slot i of the leaf.
+static inline uint32_t quadTreeLeafCircleHits(const QuadTreeNode* leaf, Vec2 center, float radius)
+{
+    uint32_t mask = 0;
+
+    // empty slots never hit, so whole groups can be tested without counting the blocks first
+    for (size_t i = 0; i < QUAD_TREE_NODE_BOUNDS_CAPACITY; i += 4)
+    {
+        mask |= getCircleBoundsGroupHitMask(&leaf->blockMinX[i], &leaf->blockMinY[i], &leaf->blockMaxX[i],
+            &leaf->blockMaxY[i], center, radius) << i;
+    }
+
+    return mask;
 }
 
 /// @brief Creates a quad tree.
 /// @param bounds The area which the quad tree will cover.
+/// @param blocks Array of blocks which may be inserted into the quad tree.
+/// @param blockCount Number of blocks in the array.
+/// @return Created quad tree.
+QuadTree quadTreeCreate(RectBounds bounds, const Block* blocks, size_t blockCount);
+/// @brief Creates a quad tree and inserts all of the blocks into it at once. The blocks are partitioned between
+/// the quadrants top-down and the subtrees are built in parallel, but the nodes and the order of the blocks in the
+/// leaves are the same as if the blocks were inserted one by one with quadTreeInsert in the order of the array.
+/// @param bounds The area which the quad tree will cover.
+/// @param blocks Array of blocks which will be inserted into the quad tree.
+/// @param blockCount Number of blocks in the array.
+/// @param threadCount Number of threads which build the tree, 0 to use all of the hardware threads. Boards with
+/// fewer than QUAD_TREE_PARALLEL_BUILD_MIN_BLOCKS blocks are always built on the calling thread.
 /// @return Created quad tree.
-QuadTree quadTreeCreate(RectBounds bounds);
-/// @brief Inserts a block pointer into the quad tree.
+QuadTree quadTreeBuild(RectBounds bounds, const Block* blocks, size_t blockCount, size_t threadCount);
+/// @brief Copies a quad tree. The copy refers to the blocks by the same indices, so it can be pointed at a copy
+/// of the block array, and the original tree and blocks can be freed afterwards.
+/// @param quadTree Pointer to the quad tree.
+/// @param blocks Array of blocks which the copy will refer to, with the same layout as the original one.
+/// @return Copy of the quad tree.
+QuadTree quadTreeClone(const QuadTree* quadTree, const Block* blocks);
+/// @brief Inserts a block into the quad tree.
 /// @param quadTree Pointer to the quad tree.
 /// @param block Pointer to the block.
-void quadTreeInsert(QuadTree* quadTree, const Block* block);
-/// @brief Removes a block pointer from the quad tree.
+/// @return True if the block was added to any of the leaves, false otherwise.
+bool quadTreeInsert(QuadTree* quadTree, const Block* block);
+/// @brief Removes a block from the quad tree. The block is unlinked straight from the leaves which store
+/// it, without descending from the root. Nodes whose subnodes are left holding no more than
+/// MAX_QUAD_TREE_NODE_BLOCKS distinct blocks are collapsed back into leaves.
 /// @param quadTree Pointer to the quad tree.
 /// @param block Pointer to the block.
-void quadTreeRemoveBlock(QuadTree* quadTree, const Block* block);
-/// @brief Retrieves all the blocks which at least partially cover a certain area.
+/// @return True if the block was stored in the quad tree, false otherwise.
+bool quadTreeRemoveBlock(QuadTree* quadTree, const Block* block);
+/// @brief Calls a visitor for all the blocks which at least partially cover a certain area, without allocating
+/// any memory. Every block is visited at most once, even if it's stored in many leaves.
+/// @param quadTree Pointer to the quad tree.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param visitor Function called for every found block. It must not modify the quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool quadTreeVisitByBounds(QuadTree* quadTree, RectBounds bounds, BlockVisitor visitor, void* context);
+/// @brief Retrieves all the blocks which at least partially cover a certain area. Every block is retrieved
+/// at most once, even if it's stored in many leaves.
 /// @param quadTree Pointer to the quad tree.
 /// @param bounds The area which will be searched for blocks that cover it at least partially.
 /// @param block Pointer to a vector which will be filled with pointers to the retrieved blocks.
-void quadTreeRetrieveAllByBounds(const QuadTree* quadTree, RectBounds bounds, Vector* result);
-/// @brief Frees a quad tree object.
+void quadTreeRetrieveAllByBounds(QuadTree* quadTree, RectBounds bounds, Vector* result);
+/// @brief Calls a visitor for all the blocks which a circle collides with, without allocating any memory. Every
+/// block is visited at most once. The blocks are tested a leaf at a time against their bounds stored in the leaf.
+/// @param quadTree Pointer to the quad tree.
+/// @param center Center of the circle.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every block hit by the circle. It must not modify the quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool quadTreeVisitByCircle(QuadTree* quadTree, Vec2 center, float radius, BlockVisitor visitor, void* context);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, without
+/// allocating any memory. Every block is visited at most once. The test is conservative around the corners of
+/// the blocks.
+/// @param quadTree Pointer to the quad tree.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool quadTreeVisitBySweptCircle(QuadTree* quadTree, Vec2 start, Vec2 end, float radius, BlockVisitor visitor,
+    void* context);
+/// @brief Retrieves all the blocks which a circle moving along a straight path can touch in a single traversal.
+/// Every block is retrieved at most once.
+/// @param quadTree Pointer to the quad tree.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void quadTreeRetrieveAllBySweptCircle(QuadTree* quadTree, Vec2 start, Vec2 end, float radius, Vector* result);
+/// @brief Finds the blocks overlapping any of many areas at once, walking the tree a single time. Every node
+/// narrows down the list of areas which reach it, so the nodes shared by nearby areas are only visited once.
+/// Every block is paired with an area at most once, even if it's stored in many leaves, and only if their bounds
+/// overlap, bounds which only touch each other don't form a pair. Memory is only allocated when the result or
+/// the query lists of the tree need to grow beyond their largest size so far.
+/// @param quadTree Pointer to the quad tree.
+/// @param bounds Array of the areas which will be searched for blocks.
+/// @param boundsCount Number of areas in the array.
+/// @param result Pointer to a vector to which a QuadTreeQueryPair is appended for every found block and area.
+void quadTreeRetrieveAllPairsByBounds(QuadTree* quadTree, const RectBounds* bounds, size_t boundsCount,
+    Vector* result);
+/// @brief Calls a visitor for all the blocks within a certain distance from a point, nearest first. The nodes
+/// are visited best-first, in the order of their distance from the point, so the query only looks at the blocks
+/// closer than the last visited one and at the nodes which can hold such blocks. Every block is visited at most
+/// once. Memory is only allocated when the queue of the tree needs to grow beyond its largest size so far.
+/// @param quadTree Pointer to the quad tree.
+/// @param point The point from which the distance to the blocks is measured.
+/// @param maxDistance Largest distance from the point to the closest point of a visited block.
+/// @param visitor Function called for every found block. It must not modify the quad tree.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool quadTreeVisitNearest(QuadTree* quadTree, Vec2 point, float maxDistance, BlockVisitor visitor, void* context);
+/// @brief Finds the blocks nearest to a point, measured to the closest point of every block.
+/// @param quadTree Pointer to the quad tree.
+/// @param point The point from which the distance to the blocks is measured.
+/// @param count Number of blocks to find.
+/// @param result Array of at least count elements which will be filled with the found blocks, nearest first.
+/// @return Number of found blocks, less than count only if the quad tree holds fewer blocks.
+size_t quadTreeFindNearest(QuadTree* quadTree, Vec2 point, size_t count, const Block** result);
+/// @brief Retrieves all the blocks whose closest point is at most a certain distance from a point, nearest
+/// first. Every block is retrieved at most once.
+/// @param quadTree Pointer to the quad tree.
+/// @param point The point from which the distance to the blocks is measured.
+/// @param radius Largest distance from the point to the closest point of a retrieved block.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void quadTreeRetrieveAllInRadius(QuadTree* quadTree, Vec2 point, float radius, Vector* result);
+/// @brief Finds the first block which a circle moving along a straight line touches. The nodes along the line are
+/// visited from the nearest to the farthest and the cast stops at the first node which lies past the nearest hit
+/// found so far. The quad tree isn't modified and no memory is allocated, so many casts can run at once.
+/// @param quadTree Pointer to the quad tree.
+/// @param origin Center of the circle at the start of the cast.
+/// @param direction Normalized direction in which the circle moves.
+/// @param radius Radius of the circle.
+/// @param maxDistance Largest distance which the circle travels.
+/// @param hit Pointer to the hit which is filled if a block was touched. Blocks which the circle already overlaps
+/// at the origin aren't touched.
+/// @return True if the circle touched a block, false otherwise.
+bool quadTreeCircleCast(const QuadTree* quadTree, Vec2 origin, Vec2 direction, float radius, float maxDistance,
+    BlockCastHit* hit);
+/// @brief Finds the first block hit by a ray, the same way as quadTreeCircleCast does for a circle.
+/// @param quadTree Pointer to the quad tree.
+/// @param origin Origin of the ray.
+/// @param direction Normalized direction of the ray.
+/// @param maxDistance Length of the ray.
+/// @param hit Pointer to the hit which is filled if a block was hit. Blocks containing the origin aren't hit.
+/// @return True if the ray hit a block, false otherwise.
+bool quadTreeRaycast(const QuadTree* quadTree, Vec2 origin, Vec2 direction, float maxDistance, BlockCastHit* hit);
+/// @brief Walks the quad tree and gathers its node counts, depth, histograms of the leaves and memory usage.
+/// @param quadTree Pointer to the quad tree.
+/// @return Stats of the quad tree.
+QuadTreeStats quadTreeGetStats(const QuadTree* quadTree);
+/// @brief Prints the stats and the query counters of a quad tree in a human readable form.
+/// @param quadTree Pointer to the quad tree.
+/// @param file File to which the stats are written.
+void quadTreePrintStats(const QuadTree* quadTree, FILE* file);
+/// @brief Writes the names of the columns written by quadTreeWriteStatsCsv.
+/// @param file File to which the line is written.
+void quadTreeWriteStatsCsvHeader(FILE* file);
+/// @brief Writes the stats and the query counters of a quad tree as a single CSV line, with a column for every
+/// bucket of the histograms.
+/// @param quadTree Pointer to the quad tree.
+/// @param label Value of the first column, used to tell the lines apart. It must not contain commas.
+/// @param file File to which the line is written.
+void quadTreeWriteStatsCsv(const QuadTree* quadTree, const char* label, FILE* file);
+/// @brief Frees a quad tree object. All nodes are released together with the node array, without walking
+/// the tree.
 /// @param quadTree Pointer to the quad tree
 void quadTreeFree(QuadTree* quadTree);
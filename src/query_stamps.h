@@ -0,0 +1,67 @@
+/// @file query_stamps.h
+/// @brief Per-block generation stamps used by spatial indices to retrieve every block at most once per query.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "memory.h"
+
+/// @brief Stamp of the last query which retrieved a given block, for every block in the indexed array.
+typedef struct QueryStamps
+{
+    uint32_t* stamps;
+    size_t count;
+    uint32_t current;
+} QueryStamps;
+
+/// @brief Creates query stamps for an array of blocks.
+/// @param count Number of blocks in the array.
+/// @return Created query stamps.
+static inline QueryStamps queryStampsCreate(size_t count)
+{
+    return (QueryStamps) {
+        .stamps = checkedCalloc(count, sizeof(uint32_t)),
+        .count = count,
+        .current = 0,
+    };
+}
+
+/// @brief Starts a new query. Blocks marked by previous queries count as unmarked again.
+/// @param stamps Pointer to the query stamps.
+static inline void queryStampsAdvance(QueryStamps* stamps)
+{
+    stamps->current++;
+
+    // stamps left over from before the wrap around could match new ones
+    if (stamps->current == 0)
+    {
+        memset(stamps->stamps, 0, sizeof(uint32_t) * stamps->count);
+        stamps->current = 1;
+    }
+}
+
+/// @brief Marks a block as retrieved by the current query.
+/// @param stamps Pointer to the query stamps.
+/// @param index Index of the block.
+/// @return True if the block wasn't marked by the current query before, false otherwise.
+static inline bool queryStampsMark(QueryStamps* stamps, size_t index)
+{
+    if (stamps->stamps[index] == stamps->current)
+        return false;
+
+    stamps->stamps[index] = stamps->current;
+    return true;
+}
+
+/// @brief Frees query stamps.
+/// @param stamps Pointer to the query stamps.
+static inline void queryStampsFree(QueryStamps* stamps)
+{
+    free(stamps->stamps);
+    stamps->stamps = NULL;
+    stamps->count = 0;
+}
@@ -12,7 +12,7 @@
 #include <assert.h>
 
 #include "gl.h"
-#include "quad_tree.h"
+#include "spatial_index.h"
 #include "str_utils.h"
 #include "vector.h"
 #include "shader.h"
@@ -60,9 +60,15 @@ typedef struct BlockInstanceVertex
 
 typedef struct BallVertex
 {
-    Vec2 position;
+    Vec2 corner; // of a square from (-1, -1) to (1, 1), scaled by the radius in the shader
 } BallVertex;
 
+typedef struct BallInstanceVertex
+{
+    Vec2 center;
+    float radius;
+} BallInstanceVertex;
+
 void initRenderer(Renderer* renderer, const Board* board)
 {
     renderer->quadIB = createQuadIB(MAX_QUADS, GL_STATIC_DRAW);
@@ -70,9 +76,9 @@ void initRenderer(Renderer* renderer, const Board* board)
     initHudRenderer(&renderer->hudRenderer, board, renderer->quadIB);
 }
 
-void updateRenderer(Renderer* renderer, const Board* board)
+void updateRenderer(Renderer* renderer, const Board* board, float alpha)
 {
-    updateGameRenderer(&renderer->gameRenderer, board);
+    updateGameRenderer(&renderer->gameRenderer, board, alpha);
 }
 
 void freeRenderer(const Renderer* renderer)
@@ -166,28 +172,29 @@ static GLuint createBlocksInstanceBuffer(const Block* blocks, size_t blockCount)
     return instBuff;
 }
 
-static void getBallVertices(BallVertex vertices[4], const Ball* ball)
+static GLuint createBallVB()
 {
-    float x1 = ball->position.x - ball->radius;
-    float x2 = ball->position.x + ball->radius;
-    float y1 = ball->position.y - ball->radius;
-    float y2 = ball->position.y + ball->radius;
+    GLuint VB = genVB();
 
-    vertices[0] = (BallVertex){ .position = { .x = x1, .y = y1 } };
-    vertices[1] = (BallVertex){ .position = { .x = x2, .y = y1 } };
-    vertices[2] = (BallVertex){ .position = { .x = x2, .y = y2 } };
-    vertices[3] = (BallVertex){ .position = { .x = x1, .y = y2 } };
+    BallVertex vertices[4] = {
+        { .corner = { .x = -1.0f, .y = -1.0f } },
+        { .corner = { .x = 1.0f, .y = -1.0f } },
+        { .corner = { .x = 1.0f, .y = 1.0f } },
+        { .corner = { .x = -1.0f, .y = 1.0f } },
+    };
+    glBufferData(GL_ARRAY_BUFFER, sizeof(BallVertex) * 4, vertices, GL_STATIC_DRAW);
+
+    return VB;
 }
 
-static GLuint createBallVB(const Ball* ball)
+// the instances are written anew every frame, there's room for as many of them as there can be balls
+static GLuint createBallsInstanceBuffer()
 {
-    GLuint VB = genVB();
-
-    BallVertex vertices[4];
-    getBallVertices(vertices, ball);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(BallVertex) * 4, vertices, GL_DYNAMIC_DRAW);
+    GLuint instBuff = genVB();
+    glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)(sizeof(BallInstanceVertex) * CHAOS_MODE_BALL_COUNT), NULL,
+        GL_STREAM_DRAW);
 
-    return VB;
+    return instBuff;
 }
 
 static PaddleShaderUnifs retrievePaddleShaderUnifs(GLuint paddleShader)
@@ -202,8 +209,6 @@ static PaddleShaderUnifs retrievePaddleShaderUnifs(GLuint paddleShader)
 static BallShaderUnifs retrieveBallShaderUnifs(GLuint ballShader)
 {
     return (BallShaderUnifs) {
-        .ballCenter = retrieveUniformLocation(ballShader, "ballCenter"),
-        .ballRadiusSquared = retrieveUniformLocation(ballShader, "ballRadiusSquared"),
         .color = retrieveUniformLocation(ballShader, "color"),
     };
 }
@@ -284,20 +289,26 @@ static InstancedQuadRenderer createBlocksRenderer(const Block* blocks, size_t bl
     return renderer;
 }
 
-static void setBallRendererVertexAttributes()
+static void setBallsRendererVertexAttributes(GLuint VB, GLuint instanceBuffer)
 {
-    vertexAttribfv(0, BallVertex, position);
+    glBindBuffer(GL_ARRAY_BUFFER, VB);
+    vertexAttribfv(0, BallVertex, corner);
+
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    instVertexAttribfv(1, BallInstanceVertex, center);
+    instVertexAttribfv(2, BallInstanceVertex, radius);
 }
 
-static QuadRenderer createBallRenderer(const Ball* ball, GLuint quadIB)
+static InstancedQuadRenderer createBallsRenderer(GLuint quadIB)
 {
-    QuadRenderer renderer = {
+    InstancedQuadRenderer renderer = {
         .VA = genVA(),
-        .VB = createBallVB(ball),
+        .VB = createBallVB(),
+        .instanceBuffer = createBallsInstanceBuffer(),
     };
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, quadIB);
-    setBallRendererVertexAttributes();
+    setBallsRendererVertexAttributes(renderer.VB, renderer.instanceBuffer);
 
     return renderer;
 }
@@ -312,6 +323,33 @@ static void initBallShaderUnifs(const BallShaderUnifs* unifs, const Vec4* ballCo
     glUniform4f(unifs->color, ballColor->r, ballColor->g, ballColor->b, ballColor->a);
 }
 
+// the balls are written straight into the instance buffer, blended between their previous and current positions
+static void updateBallsRenderer(GameRenderer* renderer, const BallSoA* balls, float alpha)
+{
+    size_t ballCount = min(ballSoASize(balls), (size_t)CHAOS_MODE_BALL_COUNT);
+    const float* previousX = balls->previousPositionX.data;
+    const float* previousY = balls->previousPositionY.data;
+    const float* currentX = balls->positionX.data;
+    const float* currentY = balls->positionY.data;
+    const float* radius = balls->radius.data;
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer->ballsRenderer.instanceBuffer);
+    BallInstanceVertex* instances = glMapBufferRange(GL_ARRAY_BUFFER, 0,
+        (GLsizeiptr)(sizeof(BallInstanceVertex) * ballCount), GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+    for (size_t i = 0; i < ballCount; i++)
+    {
+        instances[i] = (BallInstanceVertex) {
+            .center = lerpVecs((Vec2){ .x = previousX[i], .y = previousY[i] },
+                (Vec2){ .x = currentX[i], .y = currentY[i] }, alpha),
+            .radius = radius[i],
+        };
+    }
+
+    glUnmapBuffer(GL_ARRAY_BUFFER);
+    renderer->drawnBallCount = ballCount;
+}
+
 void initGameRenderer(GameRenderer* renderer, const Board* board, GLuint quadIB)
 {
     renderer->shaders = createGameShaders();
@@ -326,7 +364,11 @@ void initGameRenderer(GameRenderer* renderer, const Board* board, GLuint quadIB)
 
     renderer->paddleRenderer = createPaddleRenderer(&board->paddle, quadIB);
     renderer->blocksRenderer = createBlocksRenderer(board->blocksStorage, board->initialBlockCount, quadIB);
-    renderer->ballRenderer = createBallRenderer(&board->ball, quadIB);
+    renderer->ballsRenderer = createBallsRenderer(quadIB);
+
+    // a new board isn't blended with the old one
+    renderer->previousPaddle = renderer->currentPaddle = renderer->drawnPaddle = board->paddle;
+    updateBallsRenderer(renderer, &board->balls, 1.0f);
 }
 
 static void updatePaddleRenderer(const Block* paddle, const QuadRenderer* paddleRenderer)
@@ -337,18 +379,22 @@ static void updatePaddleRenderer(const Block* paddle, const QuadRenderer* paddle
     glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(PaddleVertex) * 4, vertices);
 }
 
-static void updateBallRenderer(const Ball* ball, const QuadRenderer* ballRenderer)
+void recordGameRenderState(GameRenderer* renderer, const Board* board)
 {
-    BallVertex vertices[4];
-    getBallVertices(vertices, ball);
-    glBindBuffer(GL_ARRAY_BUFFER, ballRenderer->VB);
-    glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(BallVertex) * 4, vertices);
+    renderer->previousPaddle = renderer->currentPaddle;
+    renderer->currentPaddle = board->paddle;
 }
 
-void updateGameRenderer(GameRenderer* renderer, const Board* board)
+void updateGameRenderer(GameRenderer* renderer, const Board* board, float alpha)
 {
-    updatePaddleRenderer(&board->paddle, &renderer->paddleRenderer);
-    updateBallRenderer(&board->ball, &renderer->ballRenderer);
+    alpha = clamp(0.0f, 1.0f, alpha);
+
+    renderer->drawnPaddle = renderer->currentPaddle;
+    renderer->drawnPaddle.position = lerpVecs(renderer->previousPaddle.position,
+        renderer->currentPaddle.position, alpha);
+
+    updatePaddleRenderer(&renderer->drawnPaddle, &renderer->paddleRenderer);
+    updateBallsRenderer(renderer, &board->balls, alpha);
 }
 
 void moveBlockOutOfView(GameRenderer* renderer, size_t blockIndex)
@@ -375,21 +421,13 @@ void freeGameRenderer(const GameRenderer* renderer)
 
     freeQuadRenderer(&renderer->paddleRenderer);
     freeInstancedQuadRenderer(&renderer->blocksRenderer);
-    freeQuadRenderer(&renderer->ballRenderer);
-}
-
-static void updateBallShaderUnifs(const BallShaderUnifs* unifs, const Ball* ball)
-{
-    glUniform2f(unifs->ballCenter, normalizeCoordinate(ball->position.x),
-        normalizeCoordinate(ball->position.y));
-    glUniform1f(unifs->ballRadiusSquared, powf(normalizeLength(ball->radius), 2.0f));
+    freeInstancedQuadRenderer(&renderer->ballsRenderer);
 }
 
-static void drawBall(const Ball* ball, GLuint shader, const BallShaderUnifs* unifs, GLuint ballRendererVA)
+static void drawBalls(size_t ballCount, GLuint shader, GLuint ballsRendererVA)
 {
     glUseProgram(shader);
-    updateBallShaderUnifs(unifs, ball);
-    drawElements(ballRendererVA, 6, QUAD_IB_DATA_TYPE);
+    drawInstances(ballsRendererVA, 6, (GLsizei)ballCount, QUAD_IB_DATA_TYPE);
 }
 
 static void updatePaddleShaderUnifs(const PaddleShaderUnifs* unifs, const Block* paddle)
@@ -415,10 +453,9 @@ static void drawBlocks(size_t blockCount, GLuint shader, GLuint blocksRendererVA
 void renderGame(const GameRenderer* renderer, const Board* board)
 {
     drawBlocks(board->initialBlockCount, renderer->shaders.blockShader, renderer->blocksRenderer.VA);
-    drawPaddle(&board->paddle, renderer->shaders.paddleShader, &renderer->shaders.paddleShaderUnifs,
+    drawPaddle(&renderer->drawnPaddle, renderer->shaders.paddleShader, &renderer->shaders.paddleShaderUnifs,
         renderer->paddleRenderer.VA);
-    drawBall(&board->ball, renderer->shaders.ballShader, &renderer->shaders.ballShaderUnifs,
-        renderer->ballRenderer.VA);
+    drawBalls(renderer->drawnBallCount, renderer->shaders.ballShader, renderer->ballsRenderer.VA);
 }
 
 static HudShaders createHudShaders()
@@ -462,39 +499,113 @@ static GLuint createHudRendererFontTexture()
 }
 
 #ifdef DRAW_QUAD_TREE
-static void getQuadTreeRendererPoints(const QuadTreeNode* node, Vector* result)
+static void getRectBoundsRendererPoints(RectBounds bounds, Vector* result)
 {
     Vec2 points[8];
 
+    Vec2 topRight = { .x = bounds.bottomRight.x, .y = bounds.topLeft.y };
+    Vec2 bottomLeft = { .x = bounds.topLeft.x, .y = bounds.bottomRight.y };
+
+    points[0] = bounds.topLeft;       points[1] = topRight;
+    points[2] = topRight;             points[3] = bounds.bottomRight;
+    points[4] = bounds.bottomRight;   points[5] = bottomLeft;
+    points[6] = bottomLeft;           points[7] = bounds.topLeft;
+
+    for (size_t i = 0; i < arrLength(points); i++)
+    {
+        points[i] = normalizePoint(points[i]);
+        vectorPushBack(result, &points[i], sizeof(Vec2));
+    }
+}
+
+static void getQuadTreeRendererPoints(const QuadTree* quadTree, uint32_t nodeIndex, Vector* result)
+{
+    const QuadTreeNode* node = quadTreeGetNode(quadTree, nodeIndex);
+
     if (quadTreeNodeHasSubnodes(node))
     {
-        for (size_t i = 0; i < 4; i++)
-            getQuadTreeRendererPoints(node->nodes[i], result);
+        for (uint32_t i = 0; i < 4; i++)
+            getQuadTreeRendererPoints(quadTree, node->nodes + i, result);
 
         return;
     }
 
-    Vec2 topRight = { .x = node->bounds.bottomRight.x, .y = node->bounds.topLeft.y };
-    Vec2 bottomLeft = { .x = node->bounds.topLeft.x, .y = node->bounds.bottomRight.y };
+    getRectBoundsRendererPoints(node->bounds, result);
+}
 
-    points[0] = node->bounds.topLeft;       points[1] = topRight;
-    points[2] = topRight;                   points[3] = node->bounds.bottomRight;
-    points[4] = node->bounds.bottomRight;   points[5] = bottomLeft;
-    points[6] = bottomLeft;                 points[7] = node->bounds.topLeft;
+static void getLinearQuadTreeRendererPoints(const LinearQuadTree* quadTree, Vector* result)
+{
+    for (size_t i = 0; i < linearQuadTreeLeafCount(quadTree); i++)
+    {
+        const LinearQuadTreeLeaf* leaf = vectorGet(&quadTree->leaves, i, sizeof(LinearQuadTreeLeaf));
+        getRectBoundsRendererPoints(linearQuadTreeGetLeafBounds(quadTree, leaf), result);
+    }
+}
 
-    for (size_t i = 0; i < arrLength(points); i++)
+static void getBlockGridRendererPoints(const BlockGrid* grid, Vector* result)
+{
+    for (size_t row = 0; row < grid->rowCount; row++)
     {
-        points[i] = normalizePoint(points[i]);
-        vectorPushBack(result, &points[i], sizeof(Vec2));
+        for (size_t col = 0; col < grid->colCount; col++)
+        {
+            float left = grid->bounds.topLeft.x + (float)col * grid->cellWidth;
+            float bottom = grid->bounds.bottomRight.y + (float)row * grid->cellHeight;
+
+            getRectBoundsRendererPoints((RectBounds) {
+                .topLeft = { .x = left, .y = bottom + grid->cellHeight },
+                .bottomRight = { .x = left + grid->cellWidth, .y = bottom },
+            }, result);
+        }
+    }
+}
+
+static void getBlockBvhRendererPoints(const BlockBvh* bvh, Vector* result)
+{
+    for (size_t i = 0; i < bvh->nodeCount; i++)
+    {
+        const BlockBvhNode* node = &bvh->nodes[i];
+
+        if (node->secondChild == NO_BLOCK_BVH_NODE && node->blockCount > 0)
+            getRectBoundsRendererPoints(node->bounds, result);
+    }
+}
+
+static void getLooseQuadTreeRendererPoints(const LooseQuadTree* quadTree, Vector* result)
+{
+    size_t nodeCount = vectorSize(&quadTree->nodes, sizeof(LooseQuadTreeNode));
+
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        const LooseQuadTreeNode* node = vectorGet(&quadTree->nodes, i, sizeof(LooseQuadTreeNode));
+
+        if (node->firstBlock != NO_LOOSE_QUAD_TREE_INDEX)
+            getRectBoundsRendererPoints(looseQuadTreeGetNodeBounds(quadTree, node), result);
     }
 }
 
-static LineRenderer createQuadTreeRenderer(const QuadTree* quadTree)
+static LineRenderer createQuadTreeRenderer(const SpatialIndex* index)
 {
     Vector points = vectorCreate();
     vectorReserve(&points, 100, sizeof(Vec2));
 
-    getQuadTreeRendererPoints(quadTree->root, &points);
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        getQuadTreeRendererPoints(&index->quadTree, QUAD_TREE_ROOT_INDEX, &points);
+        break;
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        getLinearQuadTreeRendererPoints(&index->linearQuadTree, &points);
+        break;
+    case SPATIAL_INDEX_GRID:
+        getBlockGridRendererPoints(&index->grid, &points);
+        break;
+    case SPATIAL_INDEX_BVH:
+        getBlockBvhRendererPoints(&index->bvh, &points);
+        break;
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        getLooseQuadTreeRendererPoints(&index->looseQuadTree, &points);
+        break;
+    }
 
     LineRenderer renderer = createLineRenderer(points.data, vectorSize(&points, sizeof(Vec2)),
         GL_STATIC_DRAW);
@@ -562,7 +673,7 @@ void initHudRenderer(HudRenderer* renderer, const Board* board, GLuint quadIB)
         GAME_OVER_SCREEN_FONT_WIDTH, GAME_OVER_SCREEN_FONT_HEIGHT, quadIB);
 
 #ifdef DRAW_QUAD_TREE
-    renderer->quadTreeRenderer = createQuadTreeRenderer(&board->blocksQuadTree);
+    renderer->quadTreeRenderer = createQuadTreeRenderer(&board->blocksIndex);
 #else
     (void)board; // board is unused when compiling without DRAW_QUAD_TREE
 #endif
@@ -598,10 +709,10 @@ static void freeHudShaders(const HudShaders* shaders)
 }
 
 #ifdef DRAW_QUAD_TREE
-void redrawQuadTree(HudRenderer* renderer, const QuadTree* quadTree)
+void redrawQuadTree(HudRenderer* renderer, const SpatialIndex* index)
 {
     freeLineRenderer(&renderer->quadTreeRenderer);
-    renderer->quadTreeRenderer = createQuadTreeRenderer(quadTree);
+    renderer->quadTreeRenderer = createQuadTreeRenderer(index);
 }
 #endif
 
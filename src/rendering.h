@@ -18,8 +18,6 @@ typedef struct PaddleShaderUnifs
 /// @brief Struct for ball shader uniforms.
 typedef struct BallShaderUnifs
 {
-    GLint ballCenter;
-    GLint ballRadiusSquared;
     GLint color;
 } BallShaderUnifs;
 
@@ -39,7 +37,14 @@ typedef struct GameRenderer
     GameShaders shaders;
     QuadRenderer paddleRenderer;
     InstancedQuadRenderer blocksRenderer;
-    QuadRenderer ballRenderer;
+    InstancedQuadRenderer ballsRenderer; // one instance for every ball
+
+    // the paddle after the last two simulation ticks, it's drawn blended between the two, the balls keep their
+    // previous positions on their own
+    Block previousPaddle;
+    Block currentPaddle;
+    Block drawnPaddle;
+    size_t drawnBallCount;
 } GameRenderer;
 
 /// @brief Struct for HUD shaders.
@@ -83,7 +88,8 @@ void initRenderer(Renderer* renderer, const Board* board);
 /// @brief Update the renderer.
 /// @param renderer The renderer to update.
 /// @param board The game board.
-void updateRenderer(Renderer* renderer, const Board* board);
+/// @param alpha How far the frame is between the last two simulation ticks, returned by getSimulationAlpha.
+void updateRenderer(Renderer* renderer, const Board* board, float alpha);
 
 /// @brief Free the resources used by the renderer.
 /// @param renderer The renderer to free.
@@ -101,10 +107,18 @@ void render(const Renderer* renderer, const GameState* state, const Board* board
 /// @param quadIB The index buffer object for quads.
 void initGameRenderer(GameRenderer* renderer, const Board* board, GLuint quadIB);
 
-/// @brief Update the game renderer.
+/// @brief Update the game renderer. The balls and the paddle are drawn blended between their states after the
+/// last two simulation ticks, so that they move smoothly whatever the tick rate and the frame rate are.
 /// @param renderer The game renderer to update.
 /// @param board The game board.
-void updateGameRenderer(GameRenderer* renderer, const Board* board);
+/// @param alpha How far the frame is between the last two simulation ticks, from 0 to 1.
+void updateGameRenderer(GameRenderer* renderer, const Board* board, float alpha);
+
+/// @brief Store the state of the paddle after a simulation tick. The state stored before becomes the one it's
+/// blended from.
+/// @param renderer The game renderer.
+/// @param board The game board.
+void recordGameRenderState(GameRenderer* renderer, const Board* board);
 
 /// @brief Move a block out of view.
 /// @param renderer The game renderer.
@@ -137,7 +151,7 @@ void updateHudLevelText(HudRenderer* renderer, unsigned int newLevel);
 void updateHudPointsText(HudRenderer* renderer, unsigned int newPoints);
 
 #ifdef DRAW_QUAD_TREE
-void redrawQuadTree(HudRenderer* renderer, const QuadTree* quadTree);
+void redrawQuadTree(HudRenderer* renderer, const SpatialIndex* index);
 #endif
 
 /// @brief Free the resources used by the HUD renderer.
@@ -0,0 +1,220 @@
+#include "spatial_index.h"
+
+SpatialIndex spatialIndexCreate(const SpatialIndexDesc* desc, const Block* blocks, size_t blockCount)
+{
+    SpatialIndex index = { .type = desc->type };
+
+    switch (desc->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        index.quadTree = quadTreeBuild(desc->bounds, blocks, blockCount, 0);
+        break;
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        index.linearQuadTree = linearQuadTreeCreate(desc->bounds, blocks, blockCount);
+        break;
+    case SPATIAL_INDEX_GRID:
+        index.grid = blockGridCreate(desc->bounds, desc->gridColCount, desc->gridRowCount, blocks, blockCount);
+        break;
+    case SPATIAL_INDEX_BVH:
+        index.bvh = blockBvhCreate(blocks, blockCount);
+        break;
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        index.looseQuadTree = looseQuadTreeCreate(desc->bounds, blocks, blockCount);
+        break;
+    }
+
+    return index;
+}
+
+size_t spatialIndexElemCount(const SpatialIndex* index)
+{
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        return index->quadTree.elemCount;
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        return index->linearQuadTree.elemCount;
+    case SPATIAL_INDEX_GRID:
+        return index->grid.elemCount;
+    case SPATIAL_INDEX_BVH:
+        return index->bvh.elemCount;
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        return index->looseQuadTree.elemCount;
+    }
+
+    return 0;
+}
+
+bool spatialIndexRemoveBlock(SpatialIndex* index, const Block* block)
+{
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        return quadTreeRemoveBlock(&index->quadTree, block);
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        return linearQuadTreeRemoveBlock(&index->linearQuadTree, block);
+    case SPATIAL_INDEX_GRID:
+        return blockGridRemoveBlock(&index->grid, block);
+    case SPATIAL_INDEX_BVH:
+        return blockBvhRemoveBlock(&index->bvh, block);
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        return looseQuadTreeRemoveBlock(&index->looseQuadTree, block);
+    }
+
+    return false;
+}
+
+bool spatialIndexVisitByBounds(SpatialIndex* index, RectBounds bounds, BlockVisitor visitor, void* context)
+{
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        return quadTreeVisitByBounds(&index->quadTree, bounds, visitor, context);
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        return linearQuadTreeVisitByBounds(&index->linearQuadTree, bounds, visitor, context);
+    case SPATIAL_INDEX_GRID:
+        return blockGridVisitByBounds(&index->grid, bounds, visitor, context);
+    case SPATIAL_INDEX_BVH:
+        return blockBvhVisitByBounds(&index->bvh, bounds, visitor, context);
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        return looseQuadTreeVisitByBounds(&index->looseQuadTree, bounds, visitor, context);
+    }
+
+    return true;
+}
+
+void spatialIndexRetrieveAllByBounds(SpatialIndex* index, RectBounds bounds, Vector* result)
+{
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        quadTreeRetrieveAllByBounds(&index->quadTree, bounds, result);
+        break;
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        linearQuadTreeRetrieveAllByBounds(&index->linearQuadTree, bounds, result);
+        break;
+    case SPATIAL_INDEX_GRID:
+        blockGridRetrieveAllByBounds(&index->grid, bounds, result);
+        break;
+    case SPATIAL_INDEX_BVH:
+        blockBvhRetrieveAllByBounds(&index->bvh, bounds, result);
+        break;
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        looseQuadTreeRetrieveAllByBounds(&index->looseQuadTree, bounds, result);
+        break;
+    }
+}
+
+bool spatialIndexVisitBySweptCircle(SpatialIndex* index, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context)
+{
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        return quadTreeVisitBySweptCircle(&index->quadTree, start, end, radius, visitor, context);
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        return linearQuadTreeVisitBySweptCircle(&index->linearQuadTree, start, end, radius, visitor, context);
+    case SPATIAL_INDEX_GRID:
+        return blockGridVisitBySweptCircle(&index->grid, start, end, radius, visitor, context);
+    case SPATIAL_INDEX_BVH:
+        return blockBvhVisitBySweptCircle(&index->bvh, start, end, radius, visitor, context);
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        return looseQuadTreeVisitBySweptCircle(&index->looseQuadTree, start, end, radius, visitor, context);
+    }
+
+    return true;
+}
+
+void spatialIndexRetrieveAllBySweptCircle(SpatialIndex* index, Vec2 start, Vec2 end, float radius, Vector* result)
+{
+    spatialIndexVisitBySweptCircle(index, start, end, radius, pushBackBlockVisitor, result);
+}
+
+// keeps the nearest block touched by a circle cast among the blocks near its path
+typedef struct NearestCastHit
+{
+    Vec2 origin;
+    Vec2 direction;
+    float radius;
+    BlockCastHit hit;
+} NearestCastHit;
+
+static bool castCircleAtFoundBlock(const Block* block, void* context)
+{
+    NearestCastHit* cast = context;
+    RectBounds bounds = getBlockRectBounds(block);
+    float distance;
+    Vec2 normal;
+
+    if (castCircleAtBounds(cast->origin, cast->direction, cast->radius, &bounds, cast->hit.distance, &distance,
+            &normal)
+        && (cast->hit.block == NULL || distance < cast->hit.distance))
+    {
+        cast->hit = (BlockCastHit){ .block = block, .distance = distance, .normal = normal };
+    }
+
+    return true;
+}
+
+// blocks found more than once are cast at again, which doesn't change the nearest hit, so the indices don't have
+// to remember the blocks they found and stay untouched
+bool spatialIndexCircleCast(const SpatialIndex* index, Vec2 origin, Vec2 direction, float radius,
+    float maxDistance, BlockCastHit* hit)
+{
+    NearestCastHit cast = {
+        .origin = origin,
+        .direction = direction,
+        .radius = radius,
+        .hit = { .block = NULL, .distance = maxDistance, .normal = { .x = 0.0f, .y = 0.0f } },
+    };
+
+    Vec2 end = addVecs(origin, scalar(direction, maxDistance));
+
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        return quadTreeCircleCast(&index->quadTree, origin, direction, radius, maxDistance, hit);
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        linearQuadTreeVisitBySweptCircleReadOnly(&index->linearQuadTree, origin, end, radius,
+            castCircleAtFoundBlock, &cast);
+        break;
+    case SPATIAL_INDEX_GRID:
+        blockGridVisitBySweptCircleReadOnly(&index->grid, origin, end, radius, castCircleAtFoundBlock, &cast);
+        break;
+    case SPATIAL_INDEX_BVH:
+        blockBvhVisitBySweptCircle(&index->bvh, origin, end, radius, castCircleAtFoundBlock, &cast);
+        break;
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        looseQuadTreeVisitBySweptCircle(&index->looseQuadTree, origin, end, radius, castCircleAtFoundBlock,
+            &cast);
+        break;
+    }
+
+    if (cast.hit.block == NULL)
+        return false;
+
+    *hit = cast.hit;
+    return true;
+}
+
+void spatialIndexFree(SpatialIndex* index)
+{
+    switch (index->type)
+    {
+    case SPATIAL_INDEX_QUAD_TREE:
+        quadTreeFree(&index->quadTree);
+        break;
+    case SPATIAL_INDEX_LINEAR_QUAD_TREE:
+        linearQuadTreeFree(&index->linearQuadTree);
+        break;
+    case SPATIAL_INDEX_GRID:
+        blockGridFree(&index->grid);
+        break;
+    case SPATIAL_INDEX_BVH:
+        blockBvhFree(&index->bvh);
+        break;
+    case SPATIAL_INDEX_LOOSE_QUAD_TREE:
+        looseQuadTreeFree(&index->looseQuadTree);
+        break;
+    }
+}
@@ -0,0 +1,113 @@
+/// @file spatial_index.h
+/// @brief A common interface over the structures which can be used to find blocks on the board.
+
+#pragma once
+
+#include "block_visitor.h"
+#include "entities.h"
+#include "quad_tree.h"
+#include "linear_quad_tree.h"
+#include "block_grid.h"
+#include "block_bvh.h"
+#include "loose_quad_tree.h"
+#include "vector.h"
+
+/// @brief Enumeration of the available spatial index backends.
+typedef enum SpatialIndexType
+{
+    SPATIAL_INDEX_QUAD_TREE,
+    SPATIAL_INDEX_LINEAR_QUAD_TREE,
+    SPATIAL_INDEX_GRID,
+    SPATIAL_INDEX_BVH,
+    SPATIAL_INDEX_LOOSE_QUAD_TREE,
+} SpatialIndexType;
+
+/// @brief Parameters of a spatial index.
+typedef struct SpatialIndexDesc
+{
+    SpatialIndexType type;
+    RectBounds bounds;
+    size_t gridColCount; // layout of the grid the blocks were placed in, used by SPATIAL_INDEX_GRID
+    size_t gridRowCount;
+} SpatialIndexDesc;
+
+/// @brief Spatial index which stores blocks of the board in one of the backends. Like the backends, it doesn't
+/// manage the blocks on its own.
+typedef struct SpatialIndex
+{
+    SpatialIndexType type;
+
+    union
+    {
+        QuadTree quadTree;
+        LinearQuadTree linearQuadTree;
+        BlockGrid grid;
+        BlockBvh bvh;
+        LooseQuadTree looseQuadTree;
+    };
+} SpatialIndex;
+
+/// @brief Creates a spatial index and inserts all of the blocks into it.
+/// @param desc Pointer to the parameters of the spatial index.
+/// @param blocks Array of blocks which will be inserted into the spatial index.
+/// @param blockCount Number of blocks in the array.
+/// @return Created spatial index.
+SpatialIndex spatialIndexCreate(const SpatialIndexDesc* desc, const Block* blocks, size_t blockCount);
+/// @brief Returns the number of blocks stored in a spatial index.
+/// @param index Pointer to the spatial index.
+/// @return Number of stored blocks.
+size_t spatialIndexElemCount(const SpatialIndex* index);
+/// @brief Removes a block from the spatial index.
+/// @param index Pointer to the spatial index.
+/// @param block Pointer to the block.
+/// @return True if the block was stored in the spatial index, false otherwise.
+bool spatialIndexRemoveBlock(SpatialIndex* index, const Block* block);
+/// @brief Calls a visitor for all the blocks which at least partially cover a certain area, without allocating
+/// any memory. Every block is visited at most once.
+/// @param index Pointer to the spatial index.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param visitor Function called for every found block. It must not modify the spatial index.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool spatialIndexVisitByBounds(SpatialIndex* index, RectBounds bounds, BlockVisitor visitor, void* context);
+/// @brief Retrieves all the blocks which at least partially cover a certain area. Every block is retrieved
+/// at most once.
+/// @param index Pointer to the spatial index.
+/// @param bounds The area which will be searched for blocks that cover it at least partially.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void spatialIndexRetrieveAllByBounds(SpatialIndex* index, RectBounds bounds, Vector* result);
+/// @brief Calls a visitor for all the blocks which a circle moving along a straight path can touch, without
+/// allocating any memory. Every block is visited at most once.
+/// @param index Pointer to the spatial index.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param visitor Function called for every found block. It must not modify the spatial index.
+/// @param context Pointer passed to the visitor.
+/// @return False if the visitor stopped the query, true otherwise.
+bool spatialIndexVisitBySweptCircle(SpatialIndex* index, Vec2 start, Vec2 end, float radius,
+    BlockVisitor visitor, void* context);
+/// @brief Retrieves all the blocks which a circle moving along a straight path can touch in a single traversal.
+/// Every block is retrieved at most once.
+/// @param index Pointer to the spatial index.
+/// @param start Center of the circle at the beginning of the path.
+/// @param end Center of the circle at the end of the path.
+/// @param radius Radius of the circle.
+/// @param result Pointer to a vector which will be filled with pointers to the retrieved blocks.
+void spatialIndexRetrieveAllBySweptCircle(SpatialIndex* index, Vec2 start, Vec2 end, float radius, Vector* result);
+/// @brief Finds the first block which a circle moving along a straight line touches. Quad trees visit their nodes
+/// in the order in which the circle reaches them and stop at the first hit, the other backends test every block
+/// near the line. The index isn't changed, so many threads can cast at once while no blocks are removed from it.
+/// @param index Pointer to the spatial index.
+/// @param origin Center of the circle at the start of the cast.
+/// @param direction Normalized direction in which the circle moves.
+/// @param radius Radius of the circle, 0 for a ray.
+/// @param maxDistance Largest distance which the circle travels.
+/// @param hit Pointer to the hit which is filled if a block was touched. Blocks which the circle already overlaps
+/// at the origin aren't touched.
+/// @return True if the circle touched a block, false otherwise.
+bool spatialIndexCircleCast(const SpatialIndex* index, Vec2 origin, Vec2 direction, float radius,
+    float maxDistance, BlockCastHit* hit);
+/// @brief Frees a spatial index object.
+/// @param index Pointer to the spatial index.
+void spatialIndexFree(SpatialIndex* index);
@@ -0,0 +1,213 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include "thread.h"
+
+#include "helpers.h"
+#include "memory.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+static DWORD WINAPI runThread(LPVOID arg)
+{
+    Thread* thread = arg;
+    thread->func(thread->arg);
+    return 0;
+}
+
+bool threadStart(Thread* thread, ThreadFunc func, void* arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+    thread->handle = CreateThread(NULL, 0, runThread, thread, 0, NULL);
+
+    return thread->handle != NULL;
+}
+
+void threadJoin(Thread* thread)
+{
+    WaitForSingleObject(thread->handle, INFINITE);
+    CloseHandle(thread->handle);
+}
+
+size_t getHardwareThreadCount(void)
+{
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return info.dwNumberOfProcessors > 0 ? info.dwNumberOfProcessors : 1;
+}
+
+typedef CRITICAL_SECTION Mutex;
+typedef CONDITION_VARIABLE Condition;
+
+static void mutexInit(Mutex* mutex) { InitializeCriticalSection(mutex); }
+static void mutexDestroy(Mutex* mutex) { DeleteCriticalSection(mutex); }
+static void mutexLock(Mutex* mutex) { EnterCriticalSection(mutex); }
+static void mutexUnlock(Mutex* mutex) { LeaveCriticalSection(mutex); }
+static void conditionInit(Condition* condition) { InitializeConditionVariable(condition); }
+static void conditionDestroy(Condition* UNUSED(condition)) { }
+static void conditionWait(Condition* condition, Mutex* mutex)
+{
+    SleepConditionVariableCS(condition, mutex, INFINITE);
+}
+static void conditionSignal(Condition* condition) { WakeConditionVariable(condition); }
+static void conditionBroadcast(Condition* condition) { WakeAllConditionVariable(condition); }
+#else
+static void* runThread(void* arg)
+{
+    Thread* thread = arg;
+    thread->func(thread->arg);
+    return NULL;
+}
+
+bool threadStart(Thread* thread, ThreadFunc func, void* arg)
+{
+    thread->func = func;
+    thread->arg = arg;
+
+    return pthread_create(&thread->handle, NULL, runThread, thread) == 0;
+}
+
+void threadJoin(Thread* thread)
+{
+    pthread_join(thread->handle, NULL);
+}
+
+size_t getHardwareThreadCount(void)
+{
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (size_t)count : 1;
+}
+
+typedef pthread_mutex_t Mutex;
+typedef pthread_cond_t Condition;
+
+static void mutexInit(Mutex* mutex) { pthread_mutex_init(mutex, NULL); }
+static void mutexDestroy(Mutex* mutex) { pthread_mutex_destroy(mutex); }
+static void mutexLock(Mutex* mutex) { pthread_mutex_lock(mutex); }
+static void mutexUnlock(Mutex* mutex) { pthread_mutex_unlock(mutex); }
+static void conditionInit(Condition* condition) { pthread_cond_init(condition, NULL); }
+static void conditionDestroy(Condition* condition) { pthread_cond_destroy(condition); }
+static void conditionWait(Condition* condition, Mutex* mutex) { pthread_cond_wait(condition, mutex); }
+static void conditionSignal(Condition* condition) { pthread_cond_signal(condition); }
+static void conditionBroadcast(Condition* condition) { pthread_cond_broadcast(condition); }
+#endif
+
+struct ThreadPoolState
+{
+    Mutex mutex;
+    Condition jobsReady; // signaled when jobs are added or the threads have to stop
+    Condition jobsFinished; // signaled when the last job finishes
+    Thread* threads;
+    size_t threadCount; // threads which were started
+    ThreadFunc func;
+    char* args;
+    size_t argSize;
+    size_t jobCount;
+    size_t nextJob;
+    size_t finishedJobCount;
+    bool stopping;
+};
+
+// takes the jobs which weren't taken yet one by one, the mutex has to be locked, and it's locked again on return
+static void runThreadPoolJobs(ThreadPoolState* state)
+{
+    while (state->nextJob < state->jobCount)
+    {
+        void* arg = state->args + state->argSize * state->nextJob++;
+        mutexUnlock(&state->mutex);
+
+        state->func(arg);
+
+        mutexLock(&state->mutex);
+
+        if (++state->finishedJobCount == state->jobCount)
+            conditionSignal(&state->jobsFinished);
+    }
+}
+
+static void runThreadPoolThread(void* arg)
+{
+    ThreadPoolState* state = arg;
+    mutexLock(&state->mutex);
+
+    while (!state->stopping)
+    {
+        runThreadPoolJobs(state);
+
+        if (!state->stopping)
+            conditionWait(&state->jobsReady, &state->mutex);
+    }
+
+    mutexUnlock(&state->mutex);
+}
+
+ThreadPool threadPoolCreate(size_t threadCount)
+{
+    ThreadPoolState* state = checkedCalloc(1, sizeof(ThreadPoolState));
+    mutexInit(&state->mutex);
+    conditionInit(&state->jobsReady);
+    conditionInit(&state->jobsFinished);
+
+    // the calling thread is one of them, it runs jobs too while it waits
+    size_t startedCount = threadCount > 1 ? threadCount - 1 : 0;
+    state->threads = checkedMalloc(sizeof(Thread) * (startedCount > 0 ? startedCount : 1));
+
+    for (size_t i = 0; i < startedCount; i++)
+    {
+        if (threadStart(&state->threads[state->threadCount], runThreadPoolThread, state))
+            state->threadCount++;
+    }
+
+    return (ThreadPool){ .state = state };
+}
+
+void threadPoolRun(ThreadPool* pool, ThreadFunc func, void* args, size_t argSize, size_t jobCount)
+{
+    ThreadPoolState* state = pool->state;
+    mutexLock(&state->mutex);
+
+    state->func = func;
+    state->args = args;
+    state->argSize = argSize;
+    state->jobCount = jobCount;
+    state->nextJob = 0;
+    state->finishedJobCount = 0;
+
+    // a single job is run by the calling thread right away, so the others aren't woken up for nothing
+    if (state->threadCount > 0 && jobCount > 1)
+        conditionBroadcast(&state->jobsReady);
+
+    runThreadPoolJobs(state);
+
+    while (state->finishedJobCount < state->jobCount)
+        conditionWait(&state->jobsFinished, &state->mutex);
+
+    mutexUnlock(&state->mutex);
+}
+
+void threadPoolFree(ThreadPool* pool)
+{
+    ThreadPoolState* state = pool->state;
+
+    mutexLock(&state->mutex);
+    state->stopping = true;
+    conditionBroadcast(&state->jobsReady);
+    mutexUnlock(&state->mutex);
+
+    for (size_t i = 0; i < state->threadCount; i++)
+        threadJoin(&state->threads[i]);
+
+    conditionDestroy(&state->jobsFinished);
+    conditionDestroy(&state->jobsReady);
+    mutexDestroy(&state->mutex);
+    free(state->threads);
+    free(state);
+}
@@ -0,0 +1,67 @@
+/// @file thread.h
+/// @brief A thin wrapper over the native threads of the platform, used to spread work over the CPU cores.
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef _WIN32
+typedef void* ThreadHandle;
+#else
+#include <pthread.h>
+typedef pthread_t ThreadHandle;
+#endif
+
+/// @brief Function run by a thread.
+/// @param arg Pointer passed to threadStart.
+typedef void (*ThreadFunc)(void* arg);
+
+/// @brief A running thread. It has to be joined with threadJoin.
+typedef struct Thread
+{
+    // PRIVATE
+    ThreadHandle handle;
+    ThreadFunc func;
+    void* arg;
+} Thread;
+
+/// @brief Starts a thread. The thread object must stay at the same address until the thread is joined.
+/// @param thread Pointer to the thread object.
+/// @param func Function run by the thread.
+/// @param arg Pointer passed to the function.
+/// @return True if the thread was started, false otherwise.
+bool threadStart(Thread* thread, ThreadFunc func, void* arg);
+/// @brief Waits until a thread finishes.
+/// @param thread Pointer to a started thread.
+void threadJoin(Thread* thread);
+/// @brief Returns the number of threads which the CPU can run at the same time.
+/// @return Number of hardware threads, at least 1.
+size_t getHardwareThreadCount(void);
+
+/// @brief Forward declaration of the state shared by the threads of a pool.
+typedef struct ThreadPoolState ThreadPoolState;
+
+/// @brief Threads which are started once and then wait for jobs, so that work can be spread over them many times a
+/// second without paying for starting and joining threads every time.
+typedef struct ThreadPool
+{
+    // PRIVATE
+    ThreadPoolState* state;
+} ThreadPool;
+
+/// @brief Creates a thread pool. Threads which fail to start are left out, their share of the jobs is run by the
+/// others.
+/// @param threadCount Number of threads running the jobs, counting the thread which calls threadPoolRun.
+/// @return The created thread pool.
+ThreadPool threadPoolCreate(size_t threadCount);
+/// @brief Runs jobs on the threads of the pool and on the calling thread, and waits until all of them finish.
+/// @param pool Pointer to the thread pool.
+/// @param func Function run by every job.
+/// @param args Array of the arguments of the jobs, the function is passed a pointer to one of them.
+/// @param argSize Size of an argument in bytes.
+/// @param jobCount Number of jobs.
+void threadPoolRun(ThreadPool* pool, ThreadFunc func, void* args, size_t argSize, size_t jobCount);
+/// @brief Stops the threads of a pool and frees its resources.
+/// @param pool Pointer to the thread pool.
+void threadPoolFree(ThreadPool* pool);
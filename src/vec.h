@@ -60,6 +60,11 @@ static inline Vec2 negate(Vec2 vec)
     return (Vec2){ .x = -vec.x, .y = -vec.y };
 }
 
+static inline Vec2 lerpVecs(Vec2 a, Vec2 b, float t)
+{
+    return addVecs(a, scalar(subVecs(b, a), t));
+}
+
 static inline Vec2 reflect(Vec2 vec, Vec2 normal)
 {
     Vec2 tmp = scalar(normal, 2.0f * dot(vec, normal));
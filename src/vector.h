@@ -59,6 +59,46 @@ static inline void* vectorPushBack(Vector* vector, const void* elem, size_t elem
     return newElemPtr;
 }
 
+static inline void* vectorInsert(Vector* vector, size_t index, const void* elem, size_t elemSize)
+{
+    if (vector->size + elemSize > vector->allocatedSize)
+        vectorRealloc(vector, vector->allocatedSize * 2 + elemSize);
+
+    char* newElemPtr = vectorGet(vector, index, elemSize);
+    memmove(newElemPtr + elemSize, newElemPtr, vector->size - index * elemSize);
+    memcpy(newElemPtr, elem, elemSize);
+    vector->size += elemSize;
+
+    return newElemPtr;
+}
+
+static inline void vectorErase(Vector* vector, size_t index, size_t elemSize)
+{
+    char* elemPtr = vectorGet(vector, index, elemSize);
+    memmove(elemPtr, elemPtr + elemSize, vector->size - (index + 1) * elemSize);
+    vector->size -= elemSize;
+}
+
+static inline void vectorResize(Vector* vector, size_t newElemCount, size_t elemSize)
+{
+    vectorReserve(vector, newElemCount, elemSize);
+    vector->size = newElemCount * elemSize;
+}
+
+static inline Vector vectorCopy(const Vector* vector)
+{
+    Vector copy = vectorCreate();
+
+    if (vector->size > 0)
+    {
+        vectorRealloc(&copy, vector->size);
+        memcpy(copy.data, vector->data, vector->size);
+        copy.size = vector->size;
+    }
+
+    return copy;
+}
+
 static inline void vectorClear(Vector* vector)
 {
     vector->size = 0;
@@ -0,0 +1,150 @@
+// Checks the blocks which the board caches around the first ball. Built with CHECK_BROADPHASE_CACHE, the board
+// casts the ball through the spatial index as well every time it casts it at the cached blocks, and counts the
+// casts on which the two disagree. The ball is thrown around every level at speeds at which it stays in the cached
+// area for many ticks, leaves it every few ticks or crosses it within a single tick, destroying blocks on the way,
+// and none of the casts may disagree while the cache is both hit and missed. Then blocks are taken out of the
+// spatial index behind the back of the board, which the counter has to notice.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "board.h"
+#include "game_state.h"
+#include "rendering.h"
+#include "test_utils.h"
+
+#ifndef CHECK_BROADPHASE_CACHE
+#error "The test reads the counters which CHECK_BROADPHASE_CACHE turns on"
+#endif
+
+#define CACHE_TEST_LAST_LEVEL 5
+#define CACHE_TEST_TICKS 1500
+#define CACHE_TEST_GHOST_TICKS SIMULATION_TICK_RATE
+
+static const float speedFactors[] = { 1.0f, 4.0f, 40.0f };
+
+typedef struct CacheTestCounts
+{
+    BroadphaseCacheStats stats;
+    size_t recacheCount;
+    size_t destroyedCount;
+} CacheTestCounts;
+
+static void throwBall(Board* board, GameState* state, Vec2 position, float angle, float speed)
+{
+    Ball ball = ballSoAGet(&board->balls, 0);
+    ball.position = position;
+    ball.direction = vecFromAngle(angle * (float)RADIANS_IN_DEG);
+    ball.speed = speed;
+    ballSoASet(&board->balls, 0, &ball);
+    state->ballLaunched = true;
+}
+
+static void runLevel(unsigned int level, float speed, uint32_t* random, Renderer* renderer,
+    CacheTestCounts* counts, size_t* failures)
+{
+    GameState state;
+    initGameState(&state, level);
+
+    Board board;
+    initBoard(&board, level);
+
+    Vec2 start = { .x = (float)COORDINATE_SPACE / 2.0f, .y = BALL_START_POS_Y + BALL_RADIUS * 4.0f };
+    throwBall(&board, &state, start, testRandomFloat(random, 30.0f, 150.0f), speed);
+    Vec2 cacheCenter = board.cacheCenter;
+
+    for (size_t tick = 0; tick < CACHE_TEST_TICKS && !state.boardCleared; tick++)
+    {
+        simulateBoard(&state, &board, renderer, SIMULATION_TICK_TIME);
+
+        counts->recacheCount += board.cacheCenter.x != cacheCenter.x || board.cacheCenter.y != cacheCenter.y;
+        cacheCenter = board.cacheCenter;
+
+        // a ball which got past the paddle is thrown up again
+        Ball ball = ballSoAGet(&board.balls, 0);
+
+        if (ball.position.y < board.paddle.position.y)
+            throwBall(&board, &state, start, testRandomFloat(random, 30.0f, 150.0f), speed);
+    }
+
+    TEST_CHECK(board.cacheStats.mismatchCount == 0, failures);
+
+    counts->stats.hitCount += board.cacheStats.hitCount;
+    counts->stats.missCount += board.cacheStats.missCount;
+    counts->stats.mismatchCount += board.cacheStats.mismatchCount;
+    counts->destroyedCount += board.initialBlockCount - spatialIndexElemCount(&board.blocksIndex);
+
+    freeBoard(&board);
+}
+
+// the cache is filled around the lowest block, then its blocks are removed from the spatial index only, and the
+// ball heads for the block, which the cache still has
+static void checkGhostBlocks(Renderer* renderer, size_t* failures)
+{
+    GameState state;
+    initGameState(&state, 1);
+
+    Board board;
+    initBoard(&board, 1);
+
+    const Block* lowest = &board.blocksStorage[0];
+
+    for (size_t i = 1; i < board.initialBlockCount; i++)
+    {
+        if (board.blocksStorage[i].position.y < lowest->position.y)
+            lowest = &board.blocksStorage[i];
+    }
+
+    Vec2 position = {
+        .x = lowest->position.x + lowest->width / 2.0f,
+        .y = lowest->position.y - lowest->height - BALL_RADIUS * 1.5f,
+    };
+    throwBall(&board, &state, position, 270.0f, BALL_LAUNCH_SPEED / 10.0f);
+    simulateBoard(&state, &board, renderer, SIMULATION_TICK_TIME);
+
+    const Block** cachedBlocks = board.cachedBlocks.data;
+    size_t cachedCount = vectorSize(&board.cachedBlocks, sizeof(const Block*));
+    TEST_CHECK(cachedCount > 0, failures);
+
+    for (size_t i = 0; i < cachedCount; i++)
+        spatialIndexRemoveBlock(&board.blocksIndex, cachedBlocks[i]);
+
+    Ball ball = ballSoAGet(&board.balls, 0);
+    throwBall(&board, &state, ball.position, 90.0f, BALL_LAUNCH_SPEED / 10.0f);
+
+    for (size_t tick = 0; tick < CACHE_TEST_GHOST_TICKS && board.cacheStats.mismatchCount == 0; tick++)
+        simulateBoard(&state, &board, renderer, SIMULATION_TICK_TIME);
+
+    TEST_CHECK(board.cacheStats.mismatchCount > 0, failures);
+    freeBoard(&board);
+}
+
+int main(void)
+{
+    uint32_t random = 16;
+    size_t failureCount = 0;
+    Renderer renderer = { 0 };
+    CacheTestCounts counts = { 0 };
+
+    for (unsigned int level = 1; level <= CACHE_TEST_LAST_LEVEL; level++)
+    {
+        for (size_t i = 0; i < arrLength(speedFactors); i++)
+            runLevel(level, BALL_LAUNCH_SPEED * speedFactors[i], &random, &renderer, &counts, &failureCount);
+    }
+
+    // the cache has to be used, left and moved, and blocks have to be destroyed for the casts to be worth anything
+    TEST_CHECK(counts.stats.hitCount > 0, &failureCount);
+    TEST_CHECK(counts.stats.missCount > 0, &failureCount);
+    TEST_CHECK(counts.recacheCount > 0, &failureCount);
+    TEST_CHECK(counts.destroyedCount > 0, &failureCount);
+
+    checkGhostBlocks(&renderer, &failureCount);
+
+    printf("%zu cached casts, %zu spatial index casts, %zu disagreeing, %zu cache moves, %zu destroyed blocks, "
+           "%zu failed checks\n",
+        counts.stats.hitCount, counts.stats.missCount, counts.stats.mismatchCount, counts.recacheCount,
+        counts.destroyedCount, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,82 @@
+// Measures the path prediction on the levels of the game, for balls launched from random points below the blocks
+// in random directions up the board, and how many predictions fit into the time of a frame at 60 frames per
+// second.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "board.h"
+#include "test_utils.h"
+
+#define PREDICTION_BENCHMARK_LAST_LEVEL 5
+#define PREDICTION_BENCHMARK_MIN_SECONDS 0.2
+#define PREDICTION_BENCHMARK_BALL_COUNT 1024
+#define PREDICTION_BENCHMARK_MAX_DISTANCE (4.0f * (float)COORDINATE_SPACE)
+#define PREDICTION_BENCHMARK_FRAME_SECONDS (1.0 / 60.0)
+#define PREDICTION_BENCHMARK_MAX_BOUNCES 16
+
+static const size_t maxBounceCounts[] = { 1, 4, PREDICTION_BENCHMARK_MAX_BOUNCES };
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static void benchmarkPredictions(unsigned int level, uint32_t* random)
+{
+    Board board;
+    initBoard(&board, level);
+
+    Ball ball = ballSoAGet(&board.balls, 0);
+    ball.speed = BALL_LAUNCH_SPEED;
+    Ball* balls = checkedMalloc(sizeof(Ball) * PREDICTION_BENCHMARK_BALL_COUNT);
+    float minY = PADDLE_START_POS_Y + BALL_RADIUS;
+    float maxY = board.blocksBounds.bottomRight.y - BALL_RADIUS;
+
+    for (size_t i = 0; i < PREDICTION_BENCHMARK_BALL_COUNT; i++)
+    {
+        balls[i] = ball;
+        balls[i].position = (Vec2){
+            .x = testRandomFloat(random, BALL_RADIUS, (float)COORDINATE_SPACE - BALL_RADIUS),
+            .y = testRandomFloat(random, minY, max(minY, maxY)),
+        };
+        balls[i].direction = vecFromAngle(testRandomFloat(random, 20.0f, 160.0f) * (float)RADIANS_IN_DEG);
+    }
+
+    Vec2 points[PREDICTION_BENCHMARK_MAX_BOUNCES + 2];
+
+    for (size_t i = 0; i < arrLength(maxBounceCounts); i++)
+    {
+        size_t predictionCount = 0;
+        size_t pointCount = 0;
+        clock_t start = clock();
+
+        do
+        {
+            ballSoASet(&board.balls, 0, &balls[predictionCount % PREDICTION_BENCHMARK_BALL_COUNT]);
+            pointCount += predictBallTrajectory(&board, maxBounceCounts[i], PREDICTION_BENCHMARK_MAX_DISTANCE,
+                points);
+            predictionCount++;
+        } while (predictionCount % PREDICTION_BENCHMARK_BALL_COUNT != 0
+            || getSeconds(start) < PREDICTION_BENCHMARK_MIN_SECONDS);
+
+        double seconds = getSeconds(start) / (double)predictionCount;
+
+        printf("%5u %6zu %8zu %8.2f %13.2f %12.0f\n", level, board.initialBlockCount, maxBounceCounts[i],
+            (double)pointCount / (double)predictionCount, seconds * 1e6,
+            PREDICTION_BENCHMARK_FRAME_SECONDS / seconds);
+    }
+
+    free(balls);
+    freeBoard(&board);
+}
+
+int main(void)
+{
+    uint32_t random = 18;
+    printf("level blocks  bounces   points  prediction us  per frame\n");
+
+    for (unsigned int level = STARTING_LEVEL; level <= PREDICTION_BENCHMARK_LAST_LEVEL; level++)
+        benchmarkPredictions(level, &random);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,188 @@
+// Checks the path predicted for the ball. On the first level, a ball bounces off the right wall, the bottom of the
+// lowest row of blocks and the paddle at points worked out by hand, and misses the paddle once the paddle runs
+// away from it. Then balls are launched on every level with the paddle standing still or running towards either
+// wall, and the board is simulated along the predicted path, which the ball has to follow tick by tick until the
+// end of the prediction.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "board.h"
+#include "game_state.h"
+#include "rendering.h"
+#include "test_utils.h"
+
+#define PREDICTION_LAST_LEVEL 5
+#define PREDICTION_MAX_BOUNCES 8
+#define PREDICTION_MAX_DISTANCE (8.0f * (float)COORDINATE_SPACE)
+#define PREDICTION_MAX_ERROR (0.01f * COORDINATE_SCALING)
+#define PREDICTION_MAX_RELATIVE_ERROR 0.01f
+
+static const float launchAngles[] = { 35.0f, 62.0f, 88.0f, 104.0f, 141.0f };
+static const float paddleVelocities[] = { 0.0f, PADDLE_SPEED, -PADDLE_SPEED };
+
+static void placeBall(Board* board, Vec2 position, Vec2 direction)
+{
+    Ball ball = ballSoAGet(&board->balls, 0);
+    ball.position = position;
+    ball.direction = normalize(direction);
+    ball.speed = BALL_LAUNCH_SPEED;
+    ballSoASet(&board->balls, 0, &ball);
+}
+
+static bool pointsEqual(Vec2 a, Vec2 b) { return vecLength(subVecs(a, b)) < PREDICTION_MAX_ERROR; }
+
+// the position at some distance along a predicted path, or its end if the path is shorter
+static Vec2 getPathPoint(const Vec2* points, size_t pointCount, float distance)
+{
+    for (size_t i = 1; i < pointCount; i++)
+    {
+        Vec2 segment = subVecs(points[i], points[i - 1]);
+        float length = vecLength(segment);
+
+        if (distance <= length)
+            return length > 0.0f ? addVecs(points[i - 1], scalar(segment, distance / length)) : points[i];
+
+        distance -= length;
+    }
+
+    return points[pointCount - 1];
+}
+
+static float getPathLength(const Vec2* points, size_t pointCount)
+{
+    float length = 0.0f;
+
+    for (size_t i = 1; i < pointCount; i++)
+        length += vecLength(subVecs(points[i], points[i - 1]));
+
+    return length;
+}
+
+// a ball at 45 degrees next to the right wall of the first level, whose lowest row of blocks is full, bounces up
+// into the wall, into the bottom of the eighth block of the row, and down to the middle of the board, where the
+// paddle either catches it or not
+static void checkKnownPath(size_t* failures)
+{
+    Board board;
+    initBoard(&board, 1);
+
+    float cellSize = (float)COORDINATE_SPACE / 10.0f;
+    float wallX = (float)COORDINATE_SPACE - BALL_RADIUS;
+    float blockY = 5.0f * cellSize + BLOCK_VERTICAL_PADDING - BALL_RADIUS;
+    float paddleY = PADDLE_START_POS_Y + BALL_RADIUS;
+
+    Vec2 start = { .x = wallX - 100.0f, .y = 300.0f };
+    Vec2 wallHit = { .x = wallX, .y = start.y + 100.0f };
+    Vec2 blockHit = { .x = wallX - (blockY - wallHit.y), .y = blockY };
+    Vec2 paddleHit = { .x = blockHit.x - (blockY - paddleY), .y = paddleY };
+    Vec2 fallPoint = { .x = blockHit.x - (blockY + BALL_RADIUS), .y = -BALL_RADIUS };
+    Vec2 points[PREDICTION_MAX_BOUNCES + 2];
+
+    // the ball waits on the paddle until it's launched
+    TEST_CHECK(predictBallTrajectory(&board, 2, PREDICTION_MAX_DISTANCE, points) == 1, failures);
+
+    // the paddle stands still right below the point where the ball comes down
+    placeBall(&board, start, (Vec2){ .x = 1.0f, .y = 1.0f });
+    board.paddle.position.x = paddleHit.x - board.paddle.width / 2.0f;
+
+    size_t pointCount = predictBallTrajectory(&board, 2, PREDICTION_MAX_DISTANCE, points);
+    TEST_CHECK(pointCount == 4, failures);
+    TEST_CHECK(pointsEqual(points[0], start), failures);
+    TEST_CHECK(pointsEqual(points[1], wallHit), failures);
+    TEST_CHECK(pointsEqual(points[2], blockHit), failures);
+    TEST_CHECK(pointsEqual(points[3], paddleHit), failures);
+
+    // the paddle comes from the right and is below the ball when it comes down
+    float fallTime = getPathLength(points, pointCount) / BALL_LAUNCH_SPEED;
+    board.paddleVelocity = -PADDLE_SPEED / 4.0f;
+    board.paddle.position.x = paddleHit.x - board.paddle.width / 2.0f - board.paddleVelocity * fallTime;
+
+    pointCount = predictBallTrajectory(&board, 3, PREDICTION_MAX_DISTANCE, points);
+    TEST_CHECK(pointCount == 5, failures);
+    TEST_CHECK(pointsEqual(points[3], paddleHit), failures);
+    TEST_CHECK(pointCount == 5 && points[4].y > points[3].y, failures);
+
+    // the paddle runs to the right wall, so the ball falls out of the board
+    board.paddleVelocity = PADDLE_SPEED;
+    board.paddle.position.x = PADDLE_START_POS_X;
+
+    pointCount = predictBallTrajectory(&board, 2, PREDICTION_MAX_DISTANCE, points);
+    TEST_CHECK(pointCount == 4, failures);
+    TEST_CHECK(pointsEqual(points[2], blockHit), failures);
+    TEST_CHECK(pointsEqual(points[3], fallPoint), failures);
+
+    // the path ends where its length runs out
+    pointCount = predictBallTrajectory(&board, 2, 50.0f, points);
+    TEST_CHECK(pointCount == 2, failures);
+    TEST_CHECK(pointsEqual(points[1], addVecs(start, scalar(normalize((Vec2){ .x = 1.0f, .y = 1.0f }), 50.0f))),
+        failures);
+
+    freeBoard(&board);
+}
+
+// the ball is simulated with the same paddle velocity for as long as the predicted path is, blocks destroyed on
+// the way aren't hit again within it, since every bounce off a block sends the ball away from it. The game adds
+// up the moves of every tick, whose rounding errors grow with the distance and are made larger by every bounce
+// off a corner or the paddle, so the error is measured relative to the distance the ball moved.
+static float compareWithSimulation(unsigned int level, float launchAngle, float paddleVelocity,
+    Renderer* renderer, size_t* failures)
+{
+    GameState state;
+    initGameState(&state, level);
+    state.ballLaunched = true;
+
+    Board board;
+    initBoard(&board, level);
+    placeBall(&board, ballSoAGet(&board.balls, 0).position, vecFromAngle(launchAngle * (float)RADIANS_IN_DEG));
+    board.paddleVelocity = paddleVelocity;
+
+    Vec2 points[PREDICTION_MAX_BOUNCES + 2];
+    size_t pointCount = predictBallTrajectory(&board, PREDICTION_MAX_BOUNCES, PREDICTION_MAX_DISTANCE, points);
+    float pathLength = getPathLength(points, pointCount);
+    float maxError = 0.0f;
+
+    for (size_t tick = 1; (float)tick * SIMULATION_TICK_TIME * BALL_LAUNCH_SPEED < pathLength; tick++)
+    {
+        simulateBoard(&state, &board, renderer, SIMULATION_TICK_TIME);
+
+        Ball ball = ballSoAGet(&board.balls, 0);
+        float distance = (float)tick * SIMULATION_TICK_TIME * BALL_LAUNCH_SPEED;
+        Vec2 expected = getPathPoint(points, pointCount, distance);
+        maxError = max(maxError, vecLength(subVecs(ball.position, expected)) / distance);
+    }
+
+    TEST_CHECK(maxError < PREDICTION_MAX_RELATIVE_ERROR, failures);
+
+    freeBoard(&board);
+    return maxError;
+}
+
+int main(void)
+{
+    // the board only passes the renderer on to the functions of the headless renderer, which draw nothing
+    Renderer renderer = { 0 };
+    size_t failureCount = 0;
+    float maxError = 0.0f;
+
+    checkKnownPath(&failureCount);
+
+    for (unsigned int level = 1; level <= PREDICTION_LAST_LEVEL; level++)
+    {
+        for (size_t i = 0; i < arrLength(launchAngles); i++)
+        {
+            for (size_t j = 0; j < arrLength(paddleVelocities); j++)
+            {
+                float error = compareWithSimulation(level, launchAngles[i], paddleVelocities[j], &renderer,
+                    &failureCount);
+                maxError = max(maxError, error);
+            }
+        }
+    }
+
+    printf("max relative error %.5f, %zu failed checks\n", (double)maxError, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
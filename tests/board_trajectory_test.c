@@ -0,0 +1,482 @@
+// Checks the ball moved contact to contact by the board. Its path is compared with a reference which moves it in
+// many tiny substeps, the way the board moved it before it cast the ball, but in double and bouncing it at the
+// exact moments of the contacts. Every bounce amplifies the differences a little, so the reference starts over
+// from the board every quarter of a second. Then the ball is thrown around every level at speeds at which it
+// crosses the board many times in a tick, checking that it never ends a tick inside a wall, the paddle or a block.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "board.h"
+#include "game_state.h"
+#include "rendering.h"
+#include "test_utils.h"
+
+#define TRAJECTORY_LAST_LEVEL 5
+#define TRAJECTORY_REFERENCE_SUBSTEPS 1024
+#define TRAJECTORY_CONTACT_BISECTIONS 40
+#define TRAJECTORY_COMPARED_TICKS 2400
+#define TRAJECTORY_RESYNC_TICKS (SIMULATION_TICK_RATE / 4)
+#define TRAJECTORY_MAX_ERROR (0.01f * COORDINATE_SCALING)
+#define TRAJECTORY_STRESS_TICKS 1500
+#define TRAJECTORY_OVERLAP_TOLERANCE (1e-3f * COORDINATE_SCALING)
+
+// a ball launched off the paddle at an angle, the paddle chases it like a player would
+typedef struct TrajectoryScenario
+{
+    unsigned int level;
+    float launchAngle; // in degrees
+    float speed;
+} TrajectoryScenario;
+
+static const TrajectoryScenario scenarios[] = {
+    { 1, 88.0f, BALL_LAUNCH_SPEED },
+    { 1, 60.0f, BALL_LAUNCH_SPEED * 2.0f },
+    { 2, 75.0f, BALL_LAUNCH_SPEED },
+    { 3, 115.0f, BALL_LAUNCH_SPEED * 1.5f },
+    { 4, 50.0f, BALL_LAUNCH_SPEED },
+    { 5, 130.0f, BALL_LAUNCH_SPEED * 2.0f },
+};
+
+// the board as the reference sees it, the blocks are the ones stored by the board, but they're tracked separately
+typedef struct ReferenceBoard
+{
+    double ballX;
+    double ballY;
+    double directionX;
+    double directionY;
+    double speed;
+    double radius;
+    double paddleX;
+    const Block* paddle; // everything but the position
+    const Block* blocks;
+    bool* alive;
+    size_t blockCount;
+    const Block** nearBlocks; // blocks which the ball can reach within the current tick
+} ReferenceBoard;
+
+typedef struct DoubleVec2
+{
+    double x;
+    double y;
+} DoubleVec2;
+
+static double clampDouble(double value, double minValue, double maxValue)
+{
+    return value < minValue ? minValue : (value > maxValue ? maxValue : value);
+}
+
+// vector from the point of the box closest to the ball to its center
+static DoubleVec2 getBoxDifference(const ReferenceBoard* board, double left, double top, double width,
+    double height)
+{
+    return (DoubleVec2){
+        .x = board->ballX - clampDouble(board->ballX, left, left + width),
+        .y = board->ballY - clampDouble(board->ballY, top - height, top),
+    };
+}
+
+static bool ballOverlapsBox(DoubleVec2 difference, double radius)
+{
+    return difference.x * difference.x + difference.y * difference.y < radius * radius;
+}
+
+typedef enum ReferenceContact
+{
+    REFERENCE_CONTACT_WALL = 1 << 0,
+    REFERENCE_CONTACT_PADDLE = 1 << 1,
+    REFERENCE_CONTACT_BLOCK = 1 << 2,
+} ReferenceContact;
+
+// returns the things which a ball of the given radius touches while it's heading into them, and bounces it off
+// the kinds of them it's asked to
+static uint32_t collideReferenceBall(ReferenceBoard* board, size_t nearCount, double paddleVelocity, double radius,
+    uint32_t bounced)
+{
+    double spaceSize = (double)COORDINATE_SPACE;
+    uint32_t contacts = 0;
+
+    if (board->ballY + radius > spaceSize && board->directionY > 0.0)
+    {
+        contacts |= REFERENCE_CONTACT_WALL;
+
+        if (bounced & REFERENCE_CONTACT_WALL)
+            board->directionY = -board->directionY;
+    }
+
+    if ((board->ballX - radius < 0.0 && board->directionX < 0.0)
+        || (board->ballX + radius > spaceSize && board->directionX > 0.0))
+    {
+        contacts |= REFERENCE_CONTACT_WALL;
+
+        if (bounced & REFERENCE_CONTACT_WALL)
+            board->directionX = -board->directionX;
+    }
+
+    const Block* paddle = board->paddle;
+    DoubleVec2 difference = getBoxDifference(board, board->paddleX, (double)paddle->position.y,
+        (double)paddle->width, (double)paddle->height);
+    double relativeX = board->directionX * board->speed - paddleVelocity;
+    double relativeY = board->directionY * board->speed;
+
+    // the same angles as getPaddleBounceAngle in board.c
+    if (ballOverlapsBox(difference, radius) && difference.x * relativeX + difference.y * relativeY < 0.0)
+    {
+        contacts |= REFERENCE_CONTACT_PADDLE;
+
+        if (bounced & REFERENCE_CONTACT_PADDLE)
+        {
+            double multiplier = (board->paddleX + (double)paddle->width - (board->ballX - difference.x))
+                / (double)paddle->width;
+            double minAngle = MIN_BALL_BOUNCE_ANGLE_OFF_PADDLE;
+            double angle = clampDouble(MATH_PI * multiplier, minAngle, MATH_PI - minAngle);
+            board->directionX = cos(angle);
+            board->directionY = sin(angle);
+        }
+    }
+
+    for (size_t i = 0; i < nearCount; i++)
+    {
+        const Block* block = board->nearBlocks[i];
+        size_t blockIndex = (size_t)(block - board->blocks);
+
+        if (!board->alive[blockIndex])
+            continue;
+
+        difference = getBoxDifference(board, (double)block->position.x, (double)block->position.y,
+            (double)block->width, (double)block->height);
+
+        if (!ballOverlapsBox(difference, radius)
+            || difference.x * board->directionX + difference.y * board->directionY >= 0.0)
+        {
+            continue;
+        }
+
+        contacts |= REFERENCE_CONTACT_BLOCK;
+
+        if (!(bounced & REFERENCE_CONTACT_BLOCK))
+            continue;
+
+        double length = sqrt(difference.x * difference.x + difference.y * difference.y);
+        double normalX = difference.x / length;
+        double normalY = difference.y / length;
+        double projection = board->directionX * normalX + board->directionY * normalY;
+        double directionX = board->directionX - 2.0 * projection * normalX;
+        double directionY = board->directionY - 2.0 * projection * normalY;
+        length = sqrt(directionX * directionX + directionY * directionY);
+
+        board->directionX = directionX / length;
+        board->directionY = directionY / length;
+        board->alive[blockIndex] = false;
+    }
+
+    return contacts;
+}
+
+static void moveReferenceBall(ReferenceBoard* board, double paddleVelocity, double time)
+{
+    double maxPaddleX = (double)COORDINATE_SPACE - (double)board->paddle->width;
+    board->paddleX = clampDouble(board->paddleX + paddleVelocity * time, 0.0, maxPaddleX);
+    board->ballX += board->directionX * board->speed * time;
+    board->ballY += board->directionY * board->speed * time;
+}
+
+// the substeps only find the contacts, the moment at which the ball touches is then found by bisection, and the
+// ball bounces BALL_CONTACT_SKIN short of it, like on the board, rather than somewhere within the substep
+static void simulateReferenceBoard(ReferenceBoard* board, double paddleVelocity, double deltaTime)
+{
+    double travel = board->speed * deltaTime;
+    size_t nearCount = 0;
+
+    for (size_t i = 0; i < board->blockCount; i++)
+    {
+        const Block* block = &board->blocks[i];
+        double reach = board->radius + travel + 1.0;
+
+        if (board->alive[i] && board->ballX + reach > (double)block->position.x
+            && board->ballX - reach < (double)(block->position.x + block->width)
+            && board->ballY + reach > (double)(block->position.y - block->height)
+            && board->ballY - reach < (double)block->position.y)
+        {
+            board->nearBlocks[nearCount++] = block;
+        }
+    }
+
+    double maxPaddleX = (double)COORDINATE_SPACE - (double)board->paddle->width;
+    double skin = (double)BALL_CONTACT_SKIN;
+
+    for (size_t i = 0; i < TRAJECTORY_REFERENCE_SUBSTEPS; i++)
+    {
+        // the paddle stops at the walls
+        if ((board->paddleX <= 0.0 && paddleVelocity < 0.0)
+            || (board->paddleX >= maxPaddleX && paddleVelocity > 0.0))
+        {
+            paddleVelocity = 0.0;
+        }
+
+        double remainingTime = deltaTime / TRAJECTORY_REFERENCE_SUBSTEPS;
+
+        for (size_t contactCount = 0; contactCount < MAX_BALL_CONTACTS_PER_STEP; contactCount++)
+        {
+            ReferenceBoard start = *board;
+            moveReferenceBall(board, paddleVelocity, remainingTime);
+
+            if (!collideReferenceBall(board, nearCount, paddleVelocity, board->radius, 0))
+                break;
+
+            double minTime = 0.0;
+            double maxTime = remainingTime;
+
+            for (size_t j = 0; j < TRAJECTORY_CONTACT_BISECTIONS; j++)
+            {
+                double time = (minTime + maxTime) / 2.0;
+                *board = start;
+                moveReferenceBall(board, paddleVelocity, time);
+
+                if (collideReferenceBall(board, nearCount, paddleVelocity, board->radius, 0))
+                    maxTime = time;
+                else
+                    minTime = time;
+            }
+
+            // the walls and the blocks bounce the ball the way they face at the touching point, like the casts
+            *board = start;
+            moveReferenceBall(board, paddleVelocity, maxTime);
+            ReferenceBoard touching = *board;
+            uint32_t contacts = collideReferenceBall(&touching, nearCount, paddleVelocity, board->radius,
+                REFERENCE_CONTACT_WALL | REFERENCE_CONTACT_BLOCK);
+
+            // the paddle is approached with the difference of the velocities
+            double contactSpeed = board->speed;
+
+            if (contacts & REFERENCE_CONTACT_PADDLE)
+            {
+                contactSpeed = hypot(board->directionX * board->speed - paddleVelocity,
+                    board->directionY * board->speed);
+            }
+
+            // every bounce happens a skin short of the touching point, like on the board, and the paddle bounces
+            // the ball by where it is then
+            double bounceTime = max(maxTime - skin / contactSpeed, 0.0);
+            *board = start;
+            moveReferenceBall(board, paddleVelocity, bounceTime);
+            board->directionX = touching.directionX;
+            board->directionY = touching.directionY;
+
+            if (contacts & REFERENCE_CONTACT_PADDLE)
+            {
+                collideReferenceBall(board, nearCount, paddleVelocity, board->radius + skin * 2.0,
+                    REFERENCE_CONTACT_PADDLE);
+            }
+
+            remainingTime -= bounceTime;
+        }
+    }
+}
+
+static void launchBall(Board* board, GameState* state, float angle, float speed)
+{
+    Ball ball = ballSoAGet(&board->balls, 0);
+    ball.position = (Vec2){ .x = board->paddle.position.x + board->paddle.width / 2.0f, .y = BALL_START_POS_Y };
+    ball.direction = vecFromAngle(angle * (float)RADIANS_IN_DEG);
+    ball.speed = speed;
+    ballSoASet(&board->balls, 0, &ball);
+    state->ballLaunched = true;
+}
+
+static float getChasingPaddleVelocity(const Board* board)
+{
+    Ball ball = ballSoAGet(&board->balls, 0);
+    float offset = ball.position.x - (board->paddle.position.x + board->paddle.width / 2.0f);
+
+    if (fabsf(offset) < board->paddle.width / 4.0f)
+        return 0.0f;
+
+    return offset < 0.0f ? -PADDLE_SPEED : PADDLE_SPEED;
+}
+
+typedef struct BlockSearch
+{
+    const Block* block;
+    bool found;
+} BlockSearch;
+
+static bool findBlock(const Block* block, void* context)
+{
+    BlockSearch* search = context;
+    search->found |= block == search->block;
+    return !search->found;
+}
+
+// the reference starts over from the board every now and then, so that the tiny differences in the bounces aren't
+// amplified by the ones after them until the paths have nothing in common
+static void syncReferenceBoard(ReferenceBoard* reference, Board* board)
+{
+    Ball ball = ballSoAGet(&board->balls, 0);
+    reference->ballX = (double)ball.position.x;
+    reference->ballY = (double)ball.position.y;
+    reference->directionX = (double)ball.direction.x;
+    reference->directionY = (double)ball.direction.y;
+    reference->paddleX = (double)board->paddle.position.x;
+
+    for (size_t i = 0; i < reference->blockCount; i++)
+    {
+        BlockSearch search = { .block = &reference->blocks[i], .found = false };
+        spatialIndexVisitByBounds(&board->blocksIndex, getBlockRectBounds(search.block), findBlock, &search);
+        reference->alive[i] = search.found;
+    }
+}
+
+static float compareTrajectory(const TrajectoryScenario* scenario, Renderer* renderer, size_t* failures)
+{
+    GameState state;
+    initGameState(&state, scenario->level);
+
+    Board board;
+    initBoard(&board, scenario->level);
+    launchBall(&board, &state, scenario->launchAngle, scenario->speed);
+
+    Ball ball = ballSoAGet(&board.balls, 0);
+    ReferenceBoard reference = {
+        .speed = (double)ball.speed,
+        .radius = (double)ball.radius,
+        .paddle = &board.paddle,
+        .blocks = board.blocksStorage,
+        .alive = checkedMalloc(sizeof(bool) * board.initialBlockCount),
+        .blockCount = board.initialBlockCount,
+        .nearBlocks = checkedMalloc(sizeof(const Block*) * board.initialBlockCount),
+    };
+
+    float maxError = 0.0f;
+
+    for (size_t tick = 0; tick < TRAJECTORY_COMPARED_TICKS && !state.boardCleared; tick++)
+    {
+        if (tick % TRAJECTORY_RESYNC_TICKS == 0)
+            syncReferenceBoard(&reference, &board);
+
+        board.paddleVelocity = getChasingPaddleVelocity(&board);
+        simulateReferenceBoard(&reference, (double)board.paddleVelocity, (double)SIMULATION_TICK_TIME);
+        simulateBoard(&state, &board, renderer, SIMULATION_TICK_TIME);
+
+        ball = ballSoAGet(&board.balls, 0);
+        float error = (float)hypot((double)ball.position.x - reference.ballX,
+            (double)ball.position.y - reference.ballY);
+        maxError = max(maxError, error);
+
+        // the paddle can pinch a ball which fell below its top against a wall, and the ball is lost anyway
+        if (ball.position.y < board.paddle.position.y)
+            break;
+    }
+
+    TEST_CHECK(maxError < TRAJECTORY_MAX_ERROR, failures);
+
+    free(reference.nearBlocks);
+    free(reference.alive);
+    freeBoard(&board);
+    return maxError;
+}
+
+typedef struct OverlapCheck
+{
+    const Ball* ball;
+    size_t overlapCount;
+} OverlapCheck;
+
+static bool ballOverlapsBlock(const Ball* ball, const Block* block)
+{
+    Vec2 difference = subVecs(ball->position, getClosestPointOnBlock(ball, block));
+    float depth = ball->radius - TRAJECTORY_OVERLAP_TOLERANCE;
+    return dot(difference, difference) < depth * depth;
+}
+
+static bool countOverlappedBlock(const Block* block, void* context)
+{
+    OverlapCheck* check = context;
+    check->overlapCount += ballOverlapsBlock(check->ball, block);
+    return true;
+}
+
+// a ball which the paddle pushes against a side wall has nowhere to go, so it ends up in the paddle, the same as
+// when the ball was moved in substeps
+static bool ballPinchedByPaddle(const Board* board, const Ball* ball)
+{
+    return ballOverlapsBlock(ball, &board->paddle)
+        && (ball->position.x - ball->radius < BALL_CONTACT_SKIN * 2.0f
+            || ball->position.x + ball->radius > (float)COORDINATE_SPACE - BALL_CONTACT_SKIN * 2.0f);
+}
+
+static void checkBallPlacement(Board* board, const Ball* ball, size_t* failures)
+{
+    float space = (float)COORDINATE_SPACE;
+
+    TEST_CHECK(ball->position.x - ball->radius > -TRAJECTORY_OVERLAP_TOLERANCE, failures);
+    TEST_CHECK(ball->position.x + ball->radius < space + TRAJECTORY_OVERLAP_TOLERANCE, failures);
+    TEST_CHECK(ball->position.y + ball->radius < space + TRAJECTORY_OVERLAP_TOLERANCE, failures);
+    TEST_CHECK(!ballOverlapsBlock(ball, &board->paddle), failures);
+
+    OverlapCheck check = { .ball = ball, .overlapCount = 0 };
+    spatialIndexVisitByBounds(&board->blocksIndex, getBallRectBounds(ball), countOverlappedBlock, &check);
+    TEST_CHECK(check.overlapCount == 0, failures);
+}
+
+// the ball is launched again whenever it falls out of the board or gets pinched, until every block is destroyed,
+// the paddle turns around every few ticks, so that it bounces the ball at many angles
+static void stressLevel(unsigned int level, float speed, float deltaTime, Renderer* renderer, size_t* failures)
+{
+    GameState state;
+    initGameState(&state, level);
+
+    Board board;
+    initBoard(&board, level);
+
+    uint32_t random = level * 31u + (uint32_t)speed;
+    launchBall(&board, &state, testRandomFloat(&random, 20.0f, 160.0f), speed);
+
+    for (size_t tick = 0; tick < TRAJECTORY_STRESS_TICKS && !state.boardCleared; tick++)
+    {
+        board.paddleVelocity = (tick / 30) % 2 == 0 ? PADDLE_SPEED : -PADDLE_SPEED;
+        simulateBoard(&state, &board, renderer, deltaTime);
+
+        Ball ball = ballSoAGet(&board.balls, 0);
+
+        if (ballOutOfBounds(&ball) || ballPinchedByPaddle(&board, &ball))
+            launchBall(&board, &state, testRandomFloat(&random, 20.0f, 160.0f), speed);
+        else
+            checkBallPlacement(&board, &ball, failures);
+    }
+
+    freeBoard(&board);
+}
+
+int main(void)
+{
+    // the board only passes the renderer on to the functions of the headless renderer, which draw nothing
+    Renderer renderer = { 0 };
+    size_t failureCount = 0;
+
+    for (size_t i = 0; i < arrLength(scenarios); i++)
+    {
+        float maxError = compareTrajectory(&scenarios[i], &renderer, &failureCount);
+        printf("level %u, launched at %.0f deg: max error %.5f\n", scenarios[i].level,
+            (double)scenarios[i].launchAngle, (double)maxError);
+    }
+
+    float speeds[] = { BALL_LAUNCH_SPEED, 5000.0f * COORDINATE_SCALING, 30000.0f * COORDINATE_SCALING,
+        200000.0f * COORDINATE_SCALING };
+    float deltaTimes[] = { SIMULATION_TICK_TIME, 0.035f };
+
+    for (unsigned int level = 1; level <= TRAJECTORY_LAST_LEVEL; level++)
+    {
+        for (size_t i = 0; i < arrLength(speeds); i++)
+        {
+            for (size_t j = 0; j < arrLength(deltaTimes); j++)
+                stressLevel(level, speeds[i], deltaTimes[j], &renderer, &failureCount);
+        }
+    }
+
+    printf("%zu failed checks\n", failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,216 @@
+// Measures testing a ball against lists of candidate blocks of a few lengths with the hit masks of bounds_soa.h,
+// against testing the closest point of every block one by one, the way the narrowphase did before the bounds were
+// kept as a structure of arrays. The candidates are runs of blocks of a fully packed 100x100 level, and the ball
+// is put near the middle of the run so that a part of them is hit. Both ways have to hit the same blocks. The
+// second table does the same for whole queries, quadTreeVisitByCircle against a bounds query with the closest
+// point test in the visitor.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "bounds_soa.h"
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define SOA_BENCHMARK_MIN_SECONDS 0.2
+#define SOA_BENCHMARK_BALL_COUNT 256
+#define SOA_BENCHMARK_GRID_SIZE 100
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t candidateCounts[] = { 5, 16, 64, 1000 };
+
+typedef struct SoABenchmarkHits
+{
+    Vec2 center;
+    float radius;
+    size_t hitCount;
+} SoABenchmarkHits;
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static bool ballHitsBlock(Vec2 center, float radius, const Block* block)
+{
+    RectBounds bounds = getBlockRectBounds(block);
+    Vec2 difference = {
+        .x = center.x - clamp(bounds.topLeft.x, bounds.bottomRight.x, center.x),
+        .y = center.y - clamp(bounds.bottomRight.y, bounds.topLeft.y, center.y),
+    };
+
+    return dot(difference, difference) < radius * radius;
+}
+
+static size_t countHitsScalar(const Block** candidates, size_t candidateCount, Vec2 center)
+{
+    size_t hitCount = 0;
+
+    for (size_t i = 0; i < candidateCount; i++)
+        hitCount += ballHitsBlock(center, BALL_RADIUS, candidates[i]);
+
+    return hitCount;
+}
+
+static size_t countHitsSoA(const BoundsSoA* bounds, Vec2 center)
+{
+    size_t hitCount = 0;
+
+    for (size_t i = 0; i < boundsSoASize(bounds); i += MAX_BOUNDS_PER_HIT_MASK)
+    {
+        size_t count = min(MAX_BOUNDS_PER_HIT_MASK, boundsSoASize(bounds) - i);
+        uint32_t hits = getBoundsSoACircleHitMask(bounds, i, count, center, BALL_RADIUS);
+
+        for (; hits; hits &= hits - 1)
+            hitCount++;
+    }
+
+    return hitCount;
+}
+
+// returns nanoseconds per candidate
+static double measureCandidates(const Block** candidates, const BoundsSoA* bounds, size_t candidateCount,
+    const Vec2* centers, bool soa, size_t* hitCount)
+{
+    size_t roundCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        *hitCount = 0;
+
+        for (size_t i = 0; i < SOA_BENCHMARK_BALL_COUNT; i++)
+        {
+            *hitCount += soa ? countHitsSoA(bounds, centers[i])
+                             : countHitsScalar(candidates, candidateCount, centers[i]);
+        }
+
+        roundCount++;
+    } while (getSeconds(start) < SOA_BENCHMARK_MIN_SECONDS);
+
+    return getSeconds(start) / (double)(roundCount * SOA_BENCHMARK_BALL_COUNT * candidateCount) * 1e9;
+}
+
+static bool countHitVisitor(const Block* block, void* context)
+{
+    SoABenchmarkHits* hits = context;
+    hits->hitCount += ballHitsBlock(hits->center, hits->radius, block);
+
+    return true;
+}
+
+static bool countBlockVisitor(const Block* block, void* context)
+{
+    (void)block;
+    ((SoABenchmarkHits*)context)->hitCount++;
+
+    return true;
+}
+
+// returns nanoseconds per query
+static double measureQueries(QuadTree* quadTree, const Vec2* centers, bool soa, size_t* hitCount)
+{
+    size_t roundCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        SoABenchmarkHits hits = { .radius = BALL_RADIUS, .hitCount = 0 };
+
+        for (size_t i = 0; i < SOA_BENCHMARK_BALL_COUNT; i++)
+        {
+            hits.center = centers[i];
+
+            if (soa)
+            {
+                quadTreeVisitByCircle(quadTree, centers[i], BALL_RADIUS, countBlockVisitor, &hits);
+                continue;
+            }
+
+            Ball ball = { .position = centers[i], .radius = BALL_RADIUS };
+            quadTreeVisitByBounds(quadTree, getBallRectBounds(&ball), countHitVisitor, &hits);
+        }
+
+        *hitCount = hits.hitCount;
+        roundCount++;
+    } while (getSeconds(start) < SOA_BENCHMARK_MIN_SECONDS);
+
+    return getSeconds(start) / (double)(roundCount * SOA_BENCHMARK_BALL_COUNT) * 1e9;
+}
+
+int main(void)
+{
+    uint32_t random = 10;
+    size_t blockCount;
+    Block* blocks = testCreateGridBlocks(SOA_BENCHMARK_GRID_SIZE, SOA_BENCHMARK_GRID_SIZE, 100, &random,
+        &blockCount);
+    const Block** candidates = checkedMalloc(sizeof(const Block*) * blockCount);
+    Vec2 centers[SOA_BENCHMARK_BALL_COUNT];
+    size_t mismatchCount = 0;
+
+    printf("candidates   scalar ns/candidate   soa ns/candidate   speedup      hits\n");
+
+    for (size_t i = 0; i < arrLength(candidateCounts); i++)
+    {
+        size_t candidateCount = candidateCounts[i];
+        size_t first = (blockCount - candidateCount) / 2;
+        BoundsSoA bounds = boundsSoACreate();
+
+        for (size_t j = 0; j < candidateCount; j++)
+        {
+            candidates[j] = &blocks[first + j];
+            boundsSoAPushBack(&bounds, getBlockRectBounds(candidates[j]));
+        }
+
+        for (size_t j = 0; j < SOA_BENCHMARK_BALL_COUNT; j++)
+        {
+            const Block* middle = &blocks[first + candidateCount / 2];
+
+            centers[j] = (Vec2){
+                .x = middle->position.x + testRandomFloat(&random, -BALL_RADIUS, middle->width + BALL_RADIUS),
+                .y = middle->position.y + testRandomFloat(&random, -middle->height - BALL_RADIUS, BALL_RADIUS),
+            };
+        }
+
+        size_t scalarHits;
+        size_t soaHits;
+        double scalarNanoseconds = measureCandidates(candidates, &bounds, candidateCount, centers, false,
+            &scalarHits);
+        double soaNanoseconds = measureCandidates(candidates, &bounds, candidateCount, centers, true, &soaHits);
+        mismatchCount += scalarHits != soaHits;
+
+        printf("%10zu %21.2f %18.2f %8.1fx %9zu%s\n", candidateCount, scalarNanoseconds, soaNanoseconds,
+            scalarNanoseconds / soaNanoseconds, soaHits, scalarHits == soaHits ? "" : " (hits differ)");
+
+        boundsSoAFree(&bounds);
+    }
+
+    QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+
+    for (size_t i = 0; i < SOA_BENCHMARK_BALL_COUNT; i++)
+    {
+        centers[i] = (Vec2){
+            .x = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+            .y = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+        };
+    }
+
+    size_t boundsHits;
+    size_t circleHits;
+    double boundsNanoseconds = measureQueries(&quadTree, centers, false, &boundsHits);
+    double circleNanoseconds = measureQueries(&quadTree, centers, true, &circleHits);
+    mismatchCount += boundsHits != circleHits;
+
+    printf("\nquery                        ns/query   hits\n");
+    printf("bounds and closest point %12.1f %6zu\n", boundsNanoseconds, boundsHits);
+    printf("quadTreeVisitByCircle    %12.1f %6zu\n", circleNanoseconds, circleHits);
+
+    quadTreeFree(&quadTree);
+    free(candidates);
+    free(blocks);
+
+    return mismatchCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,8 @@
+// Stands in for the parts of the renderer which the board updates while it's simulated, so that the board can
+// be simulated without a window. Nothing is drawn.
+
+#include "rendering.h"
+
+void moveBlockOutOfView(GameRenderer* UNUSED(renderer), size_t UNUSED(blockIndex)) {}
+
+void updateHudPointsText(HudRenderer* UNUSED(renderer), unsigned int UNUSED(newPoints)) {}
@@ -0,0 +1,154 @@
+// Measures the batched bounds query against a loop of single bounds queries which find the same pairs, for 10,
+// 100 and 1000 balls scattered over the board or clustered in a corner of it.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define BATCH_BENCHMARK_MIN_SECONDS 0.2
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+// the pairs of a single query, found the same way as the batched query does
+typedef struct SingleQuery
+{
+    const Block* blocks;
+    const RectBounds* bounds;
+    uint32_t query;
+    Vector* pairs;
+} SingleQuery;
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static bool pushPairVisitor(const Block* block, void* context)
+{
+    SingleQuery* query = context;
+    RectBounds blockBounds = getBlockRectBounds(block);
+    const RectBounds* bounds = &query->bounds[query->query];
+
+    if (blockBounds.topLeft.x < bounds->bottomRight.x && blockBounds.bottomRight.x > bounds->topLeft.x
+        && blockBounds.bottomRight.y < bounds->topLeft.y && blockBounds.topLeft.y > bounds->bottomRight.y)
+    {
+        QuadTreeQueryPair pair = { .query = query->query, .block = (uint32_t)(block - query->blocks) };
+        vectorPushBack(query->pairs, &pair, sizeof(QuadTreeQueryPair));
+    }
+
+    return true;
+}
+
+static double measureQueries(QuadTree* quadTree, const Block* blocks, const RectBounds* bounds, size_t ballCount,
+    bool batched, size_t* pairCount)
+{
+    Vector pairs = vectorCreate();
+    size_t batchCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        vectorClear(&pairs);
+
+        if (batched)
+        {
+            quadTreeRetrieveAllPairsByBounds(quadTree, bounds, ballCount, &pairs);
+        }
+        else
+        {
+            SingleQuery query = { .blocks = blocks, .bounds = bounds, .query = 0, .pairs = &pairs };
+
+            for (; query.query < ballCount; query.query++)
+                quadTreeVisitByBounds(quadTree, bounds[query.query], pushPairVisitor, &query);
+        }
+
+        batchCount++;
+    } while (getSeconds(start) < BATCH_BENCHMARK_MIN_SECONDS);
+
+    double seconds = getSeconds(start);
+    *pairCount = vectorSize(&pairs, sizeof(QuadTreeQueryPair));
+    vectorFree(&pairs);
+
+    return seconds / (double)batchCount * 1e6;
+}
+
+static void benchmarkBatches(const char* name, const Block* blocks, size_t blockCount, uint32_t* random)
+{
+    QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+    size_t ballCounts[] = { 10, 100, 1000 };
+    RectBounds* bounds = checkedMalloc(sizeof(RectBounds) * ballCounts[arrLength(ballCounts) - 1]);
+
+    // clustered balls share most of the path down the tree, scattered ones only its top
+    for (size_t clustered = 0; clustered < 2; clustered++)
+    {
+        float areaSize = clustered ? (float)COORDINATE_SPACE / 8.0f : (float)COORDINATE_SPACE;
+
+        for (size_t i = 0; i < arrLength(ballCounts); i++)
+        {
+            for (size_t j = 0; j < ballCounts[i]; j++)
+            {
+                Vec2 center = {
+                    .x = testRandomFloat(random, BALL_RADIUS, areaSize - BALL_RADIUS),
+                    .y = testRandomFloat(random, BALL_RADIUS, areaSize - BALL_RADIUS),
+                };
+                bounds[j] = getBallRectBounds(&(Ball){ .position = center, .radius = BALL_RADIUS });
+            }
+
+            size_t loopPairs;
+            size_t batchPairs;
+            double loopMicroseconds = measureQueries(&quadTree, blocks, bounds, ballCounts[i], false, &loopPairs);
+            double batchMicroseconds = measureQueries(&quadTree, blocks, bounds, ballCounts[i], true, &batchPairs);
+
+            printf("%-8s %-10s %6zu %10.2f %10.2f %8.2fx %8zu%s\n", name, clustered ? "clustered" : "scattered",
+                ballCounts[i], loopMicroseconds, batchMicroseconds, loopMicroseconds / batchMicroseconds,
+                batchPairs, loopPairs == batchPairs ? "" : " (pair counts differ)");
+        }
+    }
+
+    free(bounds);
+    quadTreeFree(&quadTree);
+}
+
+int main(void)
+{
+    uint32_t random = 19;
+    printf("board    balls       count    loop us   batch us  speedup    pairs\n");
+
+    // a level grid of 40x40 cells, nine in ten of them holding a block
+    size_t gridBlockCount = 0;
+    Block* blocks = checkedMalloc(sizeof(Block) * 40 * 40);
+    float cellSize = (float)COORDINATE_SPACE / 40.0f;
+
+    for (size_t row = 0; row < 40; row++)
+    {
+        for (size_t col = 0; col < 40; col++)
+        {
+            if (testRandom(&random) % 10 == 0)
+                continue;
+
+            blocks[gridBlockCount++] = (Block) {
+                .position = { .x = (float)col * cellSize + 1.0f, .y = (float)(40 - row) * cellSize - 1.0f },
+                .width = cellSize - 2.0f,
+                .height = cellSize - 2.0f,
+            };
+        }
+    }
+
+    benchmarkBatches("grid", blocks, gridBlockCount, &random);
+    free(blocks);
+
+    size_t randomBlockCount = 10000;
+    blocks = checkedMalloc(sizeof(Block) * randomBlockCount);
+
+    for (size_t i = 0; i < randomBlockCount; i++)
+        blocks[i] = testRandomBlock(&random, boardBounds, 2.0f, 10.0f);
+
+    benchmarkBatches("random", blocks, randomBlockCount, &random);
+    free(blocks);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,208 @@
+// Checks the batched bounds query against a quadTreeRetrieveAllByBounds for every one of its areas, on boards of
+// random blocks of which a third was removed. The areas are scattered over the board, clustered in a corner, or
+// lined up with the edges of the blocks, and batches both smaller and larger than QUAD_TREE_MIN_BATCH_QUERIES are
+// checked.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define BATCH_TEST_BOARD_COUNT 6
+#define BATCH_TEST_ROUND_COUNT 4
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t batchSizes[] = {
+    0, 1, 5, QUAD_TREE_MIN_BATCH_QUERIES - 1, QUAD_TREE_MIN_BATCH_QUERIES, 100, 1000,
+};
+
+typedef enum BatchLayout
+{
+    BATCH_LAYOUT_SCATTERED,
+    BATCH_LAYOUT_CLUSTERED,
+    BATCH_LAYOUT_BLOCK_EDGES,
+} BatchLayout;
+
+// bounds which only touch each other don't form a pair
+static bool boundsOverlapStrictly(const RectBounds* a, const RectBounds* b)
+{
+    return a->topLeft.x < b->bottomRight.x && a->bottomRight.x > b->topLeft.x
+        && a->bottomRight.y < b->topLeft.y && a->topLeft.y > b->bottomRight.y;
+}
+
+static int comparePairs(const void* lhs, const void* rhs)
+{
+    const QuadTreeQueryPair* a = lhs;
+    const QuadTreeQueryPair* b = rhs;
+
+    if (a->query != b->query)
+        return (a->query > b->query) - (a->query < b->query);
+
+    return (a->block > b->block) - (a->block < b->block);
+}
+
+static RectBounds getRandomBounds(uint32_t* random, RectBounds area, float maxSize)
+{
+    float halfWidth = testRandomFloat(random, 0.5f, maxSize / 2.0f);
+    float halfHeight = testRandomFloat(random, 0.5f, maxSize / 2.0f);
+    Vec2 center = {
+        .x = testRandomFloat(random, area.topLeft.x, area.bottomRight.x),
+        .y = testRandomFloat(random, area.bottomRight.y, area.topLeft.y),
+    };
+
+    return (RectBounds) {
+        .topLeft = { .x = center.x - halfWidth, .y = center.y + halfHeight },
+        .bottomRight = { .x = center.x + halfWidth, .y = center.y - halfHeight },
+    };
+}
+
+// the bounds of a block, either as they are or moved so that they touch it or overlap it by half
+static RectBounds getBlockEdgeBounds(uint32_t* random, const Block* blocks, size_t blockCount)
+{
+    RectBounds bounds = getBlockRectBounds(&blocks[testRandom(random) % blockCount]);
+    float width = bounds.bottomRight.x - bounds.topLeft.x;
+    float offset = (float)(testRandom(random) % 3) * width / 2.0f;
+
+    bounds.topLeft.x += offset;
+    bounds.bottomRight.x += offset;
+    return bounds;
+}
+
+static RectBounds getQueryBounds(uint32_t* random, BatchLayout layout, const Block* blocks, size_t blockCount)
+{
+    RectBounds corner = {
+        .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE / 8.0f },
+        .bottomRight = { .x = (float)COORDINATE_SPACE / 8.0f, .y = 0.0f },
+    };
+
+    switch (layout)
+    {
+    case BATCH_LAYOUT_SCATTERED:
+        return getRandomBounds(random, boardBounds, 80.0f);
+    case BATCH_LAYOUT_CLUSTERED:
+        return getRandomBounds(random, corner, 30.0f);
+    case BATCH_LAYOUT_BLOCK_EDGES:
+        return getBlockEdgeBounds(random, blocks, blockCount);
+    }
+
+    return boardBounds;
+}
+
+// the pairs every single query finds among the blocks of the leaves it reaches
+static void getSingleQueryPairs(QuadTree* quadTree, const Block* blocks, const RectBounds* bounds,
+    size_t boundsCount, Vector* found, Vector* pairs)
+{
+    for (uint32_t i = 0; i < boundsCount; i++)
+    {
+        vectorClear(found);
+        quadTreeRetrieveAllByBounds(quadTree, bounds[i], found);
+
+        const Block** foundBlocks = found->data;
+
+        for (size_t j = 0; j < vectorSize(found, sizeof(const Block*)); j++)
+        {
+            RectBounds blockBounds = getBlockRectBounds(foundBlocks[j]);
+
+            if (boundsOverlapStrictly(&blockBounds, &bounds[i]))
+            {
+                QuadTreeQueryPair pair = { .query = i, .block = (uint32_t)(foundBlocks[j] - blocks) };
+                vectorPushBack(pairs, &pair, sizeof(QuadTreeQueryPair));
+            }
+        }
+    }
+}
+
+static void checkBatch(QuadTree* quadTree, const Block* blocks, const bool* inserted, const RectBounds* bounds,
+    size_t boundsCount, size_t* failures)
+{
+    Vector batchPairs = vectorCreate();
+    Vector singlePairs = vectorCreate();
+    Vector found = vectorCreate();
+
+    quadTreeRetrieveAllPairsByBounds(quadTree, bounds, boundsCount, &batchPairs);
+    getSingleQueryPairs(quadTree, blocks, bounds, boundsCount, &found, &singlePairs);
+
+    size_t batchCount = vectorSize(&batchPairs, sizeof(QuadTreeQueryPair));
+    size_t singleCount = vectorSize(&singlePairs, sizeof(QuadTreeQueryPair));
+    QuadTreeQueryPair* batch = batchPairs.data;
+    QuadTreeQueryPair* single = singlePairs.data;
+    TEST_CHECK(batchCount == singleCount, failures);
+
+    // the vectors have no data until something is pushed into them
+    if (batch && single)
+    {
+        qsort(batch, batchCount, sizeof(QuadTreeQueryPair), comparePairs);
+        qsort(single, singleCount, sizeof(QuadTreeQueryPair), comparePairs);
+
+        for (size_t i = 0; i < min(batchCount, singleCount); i++)
+        {
+            TEST_CHECK(batch[i].query == single[i].query && batch[i].block == single[i].block, failures);
+            TEST_CHECK(inserted[batch[i].block], failures);
+        }
+    }
+
+    vectorFree(&found);
+    vectorFree(&singlePairs);
+    vectorFree(&batchPairs);
+}
+
+static void checkBatchedQueries(size_t boardIndex, uint32_t* random, size_t* failures)
+{
+    size_t blockCount = 60 + boardIndex * boardIndex * 250;
+    Block* blocks = checkedMalloc(sizeof(Block) * blockCount);
+    bool* inserted = checkedMalloc(sizeof(bool) * blockCount);
+    float maxSize = 80.0f / (float)(boardIndex + 1);
+
+    for (size_t i = 0; i < blockCount; i++)
+        blocks[i] = testRandomBlock(random, boardBounds, 2.0f, maxSize);
+
+    QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        inserted[i] = testRandom(random) % 3 != 0;
+
+        if (!inserted[i])
+            quadTreeRemoveBlock(&quadTree, &blocks[i]);
+    }
+
+    RectBounds* bounds = checkedMalloc(sizeof(RectBounds) * batchSizes[arrLength(batchSizes) - 1]);
+
+    for (size_t round = 0; round < BATCH_TEST_ROUND_COUNT; round++)
+    {
+        for (BatchLayout layout = BATCH_LAYOUT_SCATTERED; layout <= BATCH_LAYOUT_BLOCK_EDGES; layout++)
+        {
+            for (size_t i = 0; i < arrLength(batchSizes); i++)
+            {
+                for (size_t j = 0; j < batchSizes[i]; j++)
+                    bounds[j] = getQueryBounds(random, layout, blocks, blockCount);
+
+                checkBatch(&quadTree, blocks, inserted, bounds, batchSizes[i], failures);
+            }
+        }
+    }
+
+    free(bounds);
+    quadTreeFree(&quadTree);
+    free(inserted);
+    free(blocks);
+}
+
+int main(void)
+{
+    uint32_t random = 17;
+    size_t failureCount = 0;
+
+    for (size_t i = 0; i < BATCH_TEST_BOARD_COUNT; i++)
+        checkBatchedQueries(i, &random, &failureCount);
+
+    printf("%d boards, %zu failed checks\n", BATCH_TEST_BOARD_COUNT, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
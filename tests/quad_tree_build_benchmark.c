@@ -0,0 +1,92 @@
+// Measures how long loading a board of 10k, 100k and 1M blocks takes, inserting the blocks one by one with
+// quadTreeInsert against building the tree at once with quadTreeBuild on 1 to 8 threads. The blocks are scattered
+// over the whole board and get smaller as there are more of them. The threads run at the same time, so the time
+// is measured on the wall clock rather than as processor time.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "quad_tree.h"
+#include "thread.h"
+#include "test_utils.h"
+
+#define BUILD_BENCHMARK_MIN_SECONDS 0.5
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t blockCounts[] = { 10000, 100000, 1000000 };
+static const size_t threadCounts[] = { 1, 2, 4, 8 };
+
+static double getWallSeconds(void)
+{
+    struct timespec time;
+    timespec_get(&time, TIME_UTC);
+
+    return (double)time.tv_sec + (double)time.tv_nsec * 1e-9;
+}
+
+// threadCount 0 inserts the blocks one by one
+static double measureLoad(const Block* blocks, size_t blockCount, size_t threadCount)
+{
+    size_t loadCount = 0;
+    double start = getWallSeconds();
+
+    do
+    {
+        QuadTree quadTree;
+
+        if (threadCount == 0)
+        {
+            quadTree = quadTreeCreate(boardBounds, blocks, blockCount);
+
+            for (size_t i = 0; i < blockCount; i++)
+                quadTreeInsert(&quadTree, &blocks[i]);
+        }
+        else
+        {
+            quadTree = quadTreeBuild(boardBounds, blocks, blockCount, threadCount);
+        }
+
+        quadTreeFree(&quadTree);
+        loadCount++;
+    } while (getWallSeconds() - start < BUILD_BENCHMARK_MIN_SECONDS);
+
+    return (getWallSeconds() - start) / (double)loadCount * 1e3;
+}
+
+int main(void)
+{
+    uint32_t random = 15;
+    printf("%zu hardware threads\n", getHardwareThreadCount());
+    printf("  blocks  insert ms");
+
+    for (size_t i = 0; i < arrLength(threadCounts); i++)
+        printf("  build/%zu ms", threadCounts[i]);
+
+    printf("\n");
+
+    for (size_t i = 0; i < arrLength(blockCounts); i++)
+    {
+        Block* blocks = checkedMalloc(sizeof(Block) * blockCounts[i]);
+        float maxSize = 800.0f / sqrtf((float)blockCounts[i]);
+
+        for (size_t j = 0; j < blockCounts[i]; j++)
+            blocks[j] = testRandomBlock(&random, boardBounds, maxSize / 4.0f, maxSize);
+
+        printf("%8zu %10.1f", blockCounts[i], measureLoad(blocks, blockCounts[i], 0));
+
+        for (size_t j = 0; j < arrLength(threadCounts); j++)
+            printf(" %11.1f", measureLoad(blocks, blockCounts[i], threadCounts[j]));
+
+        printf("\n");
+        free(blocks);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+// Checks that quadTreeBuild on several threads builds the same tree as inserting the blocks one by one with
+// quadTreeInsert. The boards are big enough for the parallel build, the blocks either are scattered, tile the
+// board so that they lie on the edges of the nodes, or are piled up until the leaves overflow at the depth limit.
+// Both trees need the same nodes with the same blocks in the same order, so that every block is stored in the same
+// leaves, and the same query results, also after a third of the blocks is removed from both of them, which
+// follows the leaf references the build links after merging the subtrees.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define BUILD_TEST_QUERY_COUNT 500
+#define BUILD_TEST_TILES_PER_SIDE 80
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t threadCounts[] = { 2, 3, 4, 8 };
+
+typedef enum BuildTestLayout
+{
+    BUILD_TEST_LAYOUT_SCATTERED,
+    BUILD_TEST_LAYOUT_TILES,
+    BUILD_TEST_LAYOUT_PILE,
+} BuildTestLayout;
+
+static bool boundsEqual(const RectBounds* a, const RectBounds* b)
+{
+    return a->topLeft.x == b->topLeft.x && a->topLeft.y == b->topLeft.y && a->bottomRight.x == b->bottomRight.x
+        && a->bottomRight.y == b->bottomRight.y;
+}
+
+static Block* createBlocks(BuildTestLayout layout, uint32_t* random, size_t* blockCount)
+{
+    RectBounds pileBounds = {
+        .topLeft = { .x = 500.0f, .y = 534.0f },
+        .bottomRight = { .x = 514.0f, .y = 520.0f },
+    };
+    float tileSize = (float)COORDINATE_SPACE / (float)BUILD_TEST_TILES_PER_SIDE;
+
+    *blockCount = layout == BUILD_TEST_LAYOUT_TILES ? BUILD_TEST_TILES_PER_SIDE * BUILD_TEST_TILES_PER_SIDE
+                                                    : QUAD_TREE_PARALLEL_BUILD_MIN_BLOCKS + 1000;
+    Block* blocks = checkedMalloc(sizeof(Block) * *blockCount);
+
+    for (size_t i = 0; i < *blockCount; i++)
+    {
+        switch (layout)
+        {
+        case BUILD_TEST_LAYOUT_SCATTERED:
+            blocks[i] = testRandomBlock(random, boardBounds, 1.0f, 20.0f);
+            break;
+        case BUILD_TEST_LAYOUT_TILES:
+            blocks[i] = (Block){
+                .position = {
+                    .x = (float)(i % BUILD_TEST_TILES_PER_SIDE) * tileSize,
+                    .y = (float)(i / BUILD_TEST_TILES_PER_SIDE + 1) * tileSize,
+                },
+                .width = tileSize,
+                .height = tileSize,
+            };
+            break;
+        case BUILD_TEST_LAYOUT_PILE:
+            blocks[i] = testRandomBlock(random, pileBounds, 4.0f, 4.0f);
+            break;
+        }
+    }
+
+    return blocks;
+}
+
+// the blocks of a leaf and its overflow leaves have to be the same, in the same order and with the same bounds
+static void compareLeaves(const QuadTree* expected, uint32_t expectedLeaf, const QuadTree* actual,
+    uint32_t actualLeaf, size_t* failures)
+{
+    while (expectedLeaf != NO_QUAD_TREE_INDEX && actualLeaf != NO_QUAD_TREE_INDEX)
+    {
+        const QuadTreeNode* expectedNode = quadTreeGetNode(expected, expectedLeaf);
+        const QuadTreeNode* actualNode = quadTreeGetNode(actual, actualLeaf);
+
+        TEST_CHECK(memcmp(expectedNode->blocks, actualNode->blocks, sizeof(expectedNode->blocks)) == 0, failures);
+        TEST_CHECK(memcmp(expectedNode->blockMinX, actualNode->blockMinX, sizeof(expectedNode->blockMinX)) == 0
+                && memcmp(expectedNode->blockMinY, actualNode->blockMinY, sizeof(expectedNode->blockMinY)) == 0
+                && memcmp(expectedNode->blockMaxX, actualNode->blockMaxX, sizeof(expectedNode->blockMaxX)) == 0
+                && memcmp(expectedNode->blockMaxY, actualNode->blockMaxY, sizeof(expectedNode->blockMaxY)) == 0,
+            failures);
+
+        expectedLeaf = expectedNode->overflow;
+        actualLeaf = actualNode->overflow;
+    }
+
+    TEST_CHECK(expectedLeaf == NO_QUAD_TREE_INDEX && actualLeaf == NO_QUAD_TREE_INDEX, failures);
+}
+
+// the node arrays are laid out differently, so the trees are walked side by side from their roots
+static void compareNodes(const QuadTree* expected, uint32_t expectedIndex, const QuadTree* actual,
+    uint32_t actualIndex, size_t* failures)
+{
+    const QuadTreeNode* expectedNode = quadTreeGetNode(expected, expectedIndex);
+    const QuadTreeNode* actualNode = quadTreeGetNode(actual, actualIndex);
+
+    TEST_CHECK(boundsEqual(&expectedNode->bounds, &actualNode->bounds), failures);
+
+    if (quadTreeNodeHasSubnodes(expectedNode) != quadTreeNodeHasSubnodes(actualNode))
+    {
+        TEST_CHECK(!"the node is split in only one of the trees", failures);
+        return;
+    }
+
+    if (!quadTreeNodeHasSubnodes(expectedNode))
+    {
+        compareLeaves(expected, expectedIndex, actual, actualIndex, failures);
+        return;
+    }
+
+    uint32_t expectedSubnodes = expectedNode->nodes;
+    uint32_t actualSubnodes = actualNode->nodes;
+
+    for (uint32_t i = 0; i < 4; i++)
+    {
+        TEST_CHECK(quadTreeGetNode(actual, actualSubnodes + i)->parent == actualIndex, failures);
+        compareNodes(expected, expectedSubnodes + i, actual, actualSubnodes + i, failures);
+    }
+}
+
+static int compareBlockPointers(const void* lhs, const void* rhs)
+{
+    const Block* a = *(const Block* const*)lhs;
+    const Block* b = *(const Block* const*)rhs;
+
+    return (a > b) - (a < b);
+}
+
+static void compareQueries(QuadTree* expected, QuadTree* actual, uint32_t* random, size_t* failures)
+{
+    Vector expectedFound = vectorCreate();
+    Vector actualFound = vectorCreate();
+
+    for (size_t i = 0; i < BUILD_TEST_QUERY_COUNT; i++)
+    {
+        RectBounds bounds = getBlockRectBounds(&(Block){
+            .position = {
+                .x = testRandomFloat(random, -20.0f, (float)COORDINATE_SPACE),
+                .y = testRandomFloat(random, 0.0f, (float)COORDINATE_SPACE + 20.0f),
+            },
+            .width = testRandomFloat(random, 1.0f, 60.0f),
+            .height = testRandomFloat(random, 1.0f, 60.0f),
+        });
+
+        vectorClear(&expectedFound);
+        vectorClear(&actualFound);
+        quadTreeRetrieveAllByBounds(expected, bounds, &expectedFound);
+        quadTreeRetrieveAllByBounds(actual, bounds, &actualFound);
+
+        size_t expectedCount = vectorSize(&expectedFound, sizeof(const Block*));
+        size_t actualCount = vectorSize(&actualFound, sizeof(const Block*));
+        TEST_CHECK(expectedCount == actualCount, failures);
+
+        // the vectors have no data until something is pushed into them
+        if (expectedCount == actualCount && expectedFound.data && actualFound.data)
+        {
+            qsort(expectedFound.data, expectedCount, sizeof(const Block*), compareBlockPointers);
+            qsort(actualFound.data, actualCount, sizeof(const Block*), compareBlockPointers);
+            TEST_CHECK(memcmp(expectedFound.data, actualFound.data, sizeof(const Block*) * expectedCount) == 0,
+                failures);
+        }
+    }
+
+    vectorFree(&actualFound);
+    vectorFree(&expectedFound);
+}
+
+static void compareTrees(QuadTree* expected, QuadTree* actual, uint32_t* random, size_t* failures)
+{
+    TEST_CHECK(expected->elemCount == actual->elemCount, failures);
+    compareNodes(expected, QUAD_TREE_ROOT_INDEX, actual, QUAD_TREE_ROOT_INDEX, failures);
+
+    QuadTreeStats expectedStats = quadTreeGetStats(expected);
+    QuadTreeStats actualStats = quadTreeGetStats(actual);
+    TEST_CHECK(expectedStats.nodeCount == actualStats.nodeCount, failures);
+    TEST_CHECK(expectedStats.blockReferenceCount == actualStats.blockReferenceCount, failures);
+    TEST_CHECK(expectedStats.duplicatedBlockCount == actualStats.duplicatedBlockCount, failures);
+
+    compareQueries(expected, actual, random, failures);
+}
+
+static void checkBuild(BuildTestLayout layout, uint32_t* random, size_t* failures)
+{
+    size_t blockCount;
+    Block* blocks = createBlocks(layout, random, &blockCount);
+
+    QuadTree expected = quadTreeCreate(boardBounds, blocks, blockCount);
+
+    for (size_t i = 0; i < blockCount; i++)
+        quadTreeInsert(&expected, &blocks[i]);
+
+    for (size_t i = 0; i < arrLength(threadCounts); i++)
+    {
+        QuadTree actual = quadTreeBuild(boardBounds, blocks, blockCount, threadCounts[i]);
+        compareTrees(&expected, &actual, random, failures);
+
+        QuadTree removedExpected = quadTreeCreate(boardBounds, blocks, blockCount);
+
+        for (size_t j = 0; j < blockCount; j++)
+            quadTreeInsert(&removedExpected, &blocks[j]);
+
+        for (size_t j = 0; j < blockCount; j += 3)
+        {
+            TEST_CHECK(quadTreeRemoveBlock(&removedExpected, &blocks[j]), failures);
+            TEST_CHECK(quadTreeRemoveBlock(&actual, &blocks[j]), failures);
+        }
+
+        compareTrees(&removedExpected, &actual, random, failures);
+
+        quadTreeFree(&removedExpected);
+        quadTreeFree(&actual);
+    }
+
+    quadTreeFree(&expected);
+    free(blocks);
+}
+
+int main(void)
+{
+    uint32_t random = 15;
+    size_t failureCount = 0;
+
+    for (BuildTestLayout layout = BUILD_TEST_LAYOUT_SCATTERED; layout <= BUILD_TEST_LAYOUT_PILE; layout++)
+        checkBuild(layout, &random, &failureCount);
+
+    printf("3 boards, %zu thread counts, %zu failed checks\n", arrLength(threadCounts), failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
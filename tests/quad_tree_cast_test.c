@@ -0,0 +1,265 @@
+// Checks the circle and ray casts of the quad tree against a brute-force scan which casts at every inserted block.
+// Casts start both inside and outside of the board and run in every direction, so many of them miss, and every
+// cast which hits is repeated up to a little past the hit and up to a little before it. On a board of tiles
+// sharing their edges, some casts run along the edges and reach a few tiles at the same distance, where the tie
+// may be broken either way.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define CAST_TEST_BOARD_COUNT 6
+#define CAST_TEST_CAST_COUNT 2000
+#define CAST_TEST_TILES_PER_SIDE 32
+#define CAST_TEST_MAX_DISTANCE (2.0f * (float)COORDINATE_SPACE)
+#define CAST_TEST_DISTANCE_TOLERANCE 1e-3f
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+typedef struct CastTestBoard
+{
+    Block* blocks;
+    size_t blockCount;
+    bool* inserted;
+    QuadTree quadTree;
+    float tileSize; // zero unless the blocks are tiles
+} CastTestBoard;
+
+// how many of the casts ended up in each of the cases the test is after
+typedef struct CastCoverage
+{
+    size_t missCount;
+    size_t tieCount;
+    size_t cutoffCount;
+} CastCoverage;
+
+// later boards hold more and smaller blocks, the last one is tiled, and a third of the blocks is removed again
+static CastTestBoard createCastTestBoard(size_t boardIndex, uint32_t* random)
+{
+    CastTestBoard board = { .tileSize = 0.0f };
+
+    if (boardIndex == CAST_TEST_BOARD_COUNT - 1)
+    {
+        board.tileSize = (float)COORDINATE_SPACE / (float)CAST_TEST_TILES_PER_SIDE;
+        board.blockCount = CAST_TEST_TILES_PER_SIDE * CAST_TEST_TILES_PER_SIDE;
+    }
+    else
+    {
+        board.blockCount = 60 + boardIndex * boardIndex * 150;
+    }
+
+    board.blocks = checkedMalloc(sizeof(Block) * board.blockCount);
+    board.inserted = checkedMalloc(sizeof(bool) * board.blockCount);
+
+    float maxSize = 80.0f / (float)(boardIndex + 1);
+
+    for (size_t i = 0; i < board.blockCount; i++)
+    {
+        if (board.tileSize == 0.0f)
+        {
+            board.blocks[i] = testRandomBlock(random, boardBounds, 2.0f, maxSize);
+            continue;
+        }
+
+        board.blocks[i] = (Block){
+            .position = {
+                .x = (float)(i % CAST_TEST_TILES_PER_SIDE) * board.tileSize,
+                .y = (float)(i / CAST_TEST_TILES_PER_SIDE + 1) * board.tileSize,
+            },
+            .width = board.tileSize,
+            .height = board.tileSize,
+        };
+    }
+
+    board.quadTree = quadTreeBuild(boardBounds, board.blocks, board.blockCount, 1);
+
+    for (size_t i = 0; i < board.blockCount; i++)
+    {
+        board.inserted[i] = testRandom(random) % 3 != 0;
+
+        if (!board.inserted[i])
+            quadTreeRemoveBlock(&board.quadTree, &board.blocks[i]);
+    }
+
+    return board;
+}
+
+static void freeCastTestBoard(CastTestBoard* board)
+{
+    quadTreeFree(&board->quadTree);
+    free(board->inserted);
+    free(board->blocks);
+}
+
+static bool distancesEqual(float a, float b)
+{
+    return fabsf(a - b) <= CAST_TEST_DISTANCE_TOLERANCE * (1.0f + fabsf(b));
+}
+
+// the nearest hit among the inserted blocks, found the same way as the quad tree tests the blocks of its leaves
+static bool castAtAllBlocks(const CastTestBoard* board, Vec2 origin, Vec2 direction, float radius,
+    float maxDistance, BlockCastHit* hit)
+{
+    *hit = (BlockCastHit){ .block = NULL, .distance = maxDistance, .normal = { .x = 0.0f, .y = 0.0f } };
+
+    for (size_t i = 0; i < board->blockCount; i++)
+    {
+        RectBounds bounds = getBlockRectBounds(&board->blocks[i]);
+        float distance;
+        Vec2 normal;
+
+        if (board->inserted[i]
+            && castCircleAtBounds(origin, direction, radius, &bounds, hit->distance, &distance, &normal)
+            && (hit->block == NULL || distance < hit->distance))
+        {
+            *hit = (BlockCastHit){ .block = &board->blocks[i], .distance = distance, .normal = normal };
+        }
+    }
+
+    return hit->block != NULL;
+}
+
+// other inserted blocks hit at the same distance as the nearest one
+static bool isTie(const CastTestBoard* board, Vec2 origin, Vec2 direction, float radius, const BlockCastHit* hit)
+{
+    for (size_t i = 0; i < board->blockCount; i++)
+    {
+        RectBounds bounds = getBlockRectBounds(&board->blocks[i]);
+        float distance;
+        Vec2 normal;
+
+        if (board->inserted[i] && &board->blocks[i] != hit->block
+            && castCircleAtBounds(origin, direction, radius, &bounds, hit->distance, &distance, &normal)
+            && distance == hit->distance)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// returns the distance of the nearest hit, or the length of the cast if nothing was hit
+static float checkCast(const CastTestBoard* board, Vec2 origin, Vec2 direction, float radius, float maxDistance,
+    CastCoverage* coverage, size_t* failures)
+{
+    BlockCastHit expected;
+    BlockCastHit hit;
+
+    bool expectedFound = castAtAllBlocks(board, origin, direction, radius, maxDistance, &expected);
+    bool found = radius == 0.0f
+        ? quadTreeRaycast(&board->quadTree, origin, direction, maxDistance, &hit)
+        : quadTreeCircleCast(&board->quadTree, origin, direction, radius, maxDistance, &hit);
+    TEST_CHECK(found == expectedFound, failures);
+
+    if (!expectedFound)
+        coverage->missCount++;
+
+    if (!found || !expectedFound)
+        return maxDistance;
+
+    size_t block = (size_t)(hit.block - board->blocks);
+    TEST_CHECK(board->inserted[block], failures);
+    TEST_CHECK(distancesEqual(hit.distance, expected.distance), failures);
+
+    // among tied blocks any can be hit, but it has to be hit at the nearest distance and with its own normal
+    RectBounds bounds = getBlockRectBounds(hit.block);
+    float distance;
+    Vec2 normal;
+
+    bool blockHit = castCircleAtBounds(origin, direction, radius, &bounds, maxDistance, &distance, &normal);
+    TEST_CHECK(blockHit && distancesEqual(distance, hit.distance), failures);
+    TEST_CHECK(blockHit && fabsf(normal.x - hit.normal.x) < 1e-3f && fabsf(normal.y - hit.normal.y) < 1e-3f,
+        failures);
+
+    if (isTie(board, origin, direction, radius, &expected))
+        coverage->tieCount++;
+
+    return expected.distance;
+}
+
+// on the tiled board, half of the casts run along the edges of the tiles
+static void getRandomCast(const CastTestBoard* board, uint32_t* random, Vec2* origin, Vec2* direction)
+{
+    *origin = (Vec2){
+        .x = testRandomFloat(random, -50.0f, (float)COORDINATE_SPACE + 50.0f),
+        .y = testRandomFloat(random, -50.0f, (float)COORDINATE_SPACE + 50.0f),
+    };
+    *direction = vecFromAngle(testRandomFloat(random, 0.0f, 2.0f * (float)MATH_PI));
+
+    if (board->tileSize == 0.0f || testRandom(random) % 2 == 0)
+        return;
+
+    float edge = (float)(testRandom(random) % (CAST_TEST_TILES_PER_SIDE + 1)) * board->tileSize;
+    float sign = testRandom(random) % 2 == 0 ? 1.0f : -1.0f;
+
+    if (testRandom(random) % 2 == 0)
+    {
+        origin->x = edge;
+        *direction = (Vec2){ .x = 0.0f, .y = sign };
+    }
+    else
+    {
+        origin->y = edge;
+        *direction = (Vec2){ .x = sign, .y = 0.0f };
+    }
+}
+
+static void checkCasts(const CastTestBoard* board, uint32_t* random, CastCoverage* coverage, size_t* failures)
+{
+    for (size_t i = 0; i < CAST_TEST_CAST_COUNT; i++)
+    {
+        Vec2 origin;
+        Vec2 direction;
+        getRandomCast(board, random, &origin, &direction);
+
+        // half of the casts are rays
+        float radius = testRandom(random) % 2 == 0 ? 0.0f : testRandomFloat(random, 0.5f, 40.0f);
+        float distance = checkCast(board, origin, direction, radius, CAST_TEST_MAX_DISTANCE, coverage, failures);
+
+        if (distance == CAST_TEST_MAX_DISTANCE)
+            continue;
+
+        // the hit is found by a cast which ends a little past it, and not by one which ends a little before it,
+        // casts ending right at it may go either way, since the quad tree doesn't round its distances the same way
+        float tolerance = CAST_TEST_DISTANCE_TOLERANCE * (1.0f + distance);
+        checkCast(board, origin, direction, radius, distance + tolerance, coverage, failures);
+
+        if (distance > tolerance
+            && checkCast(board, origin, direction, radius, distance - tolerance, coverage, failures)
+                == distance - tolerance)
+        {
+            coverage->cutoffCount++;
+        }
+    }
+}
+
+int main(void)
+{
+    uint32_t random = 5;
+    size_t failureCount = 0;
+    CastCoverage coverage = { .missCount = 0, .tieCount = 0, .cutoffCount = 0 };
+
+    for (size_t i = 0; i < CAST_TEST_BOARD_COUNT; i++)
+    {
+        CastTestBoard board = createCastTestBoard(i, &random);
+        checkCasts(&board, &random, &coverage, &failureCount);
+        freeCastTestBoard(&board);
+    }
+
+    TEST_CHECK(coverage.missCount > 0, &failureCount);
+    TEST_CHECK(coverage.tieCount > 0, &failureCount);
+    TEST_CHECK(coverage.cutoffCount > 0, &failureCount);
+
+    printf("%d boards, %zu misses, %zu ties, %zu cut off casts, %zu failed checks\n", CAST_TEST_BOARD_COUNT,
+        coverage.missCount, coverage.tieCount, coverage.cutoffCount, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
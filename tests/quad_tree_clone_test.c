@@ -0,0 +1,155 @@
+// Checks that a quad tree copied with quadTreeClone works on its own once the blocks are moved to another array.
+// The original tree keeps changing after the copy and is freed along with the old block array, which is wiped
+// first, so anything the copy still shared with them shows up as wrong results. The copy is then queried against
+// a brute-force scan of the moved blocks, changed by removing and inserting blocks, and queried again.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define CLONE_TEST_BOARD_COUNT 4
+#define CLONE_TEST_QUERY_COUNT 300
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+// blocks which only touch the query may or may not be found, blocks which overlap it have to be
+static bool boundsOverlapStrictly(const RectBounds* a, const RectBounds* b)
+{
+    return a->topLeft.x < b->bottomRight.x && a->bottomRight.x > b->topLeft.x
+        && a->bottomRight.y < b->topLeft.y && a->topLeft.y > b->bottomRight.y;
+}
+
+static void checkQueries(QuadTree* quadTree, const Block* blocks, size_t blockCount, const bool* inserted,
+    uint32_t* random, size_t* failures)
+{
+    Vector result = vectorCreate();
+    bool* found = checkedMalloc(sizeof(bool) * blockCount);
+
+    for (size_t i = 0; i < CLONE_TEST_QUERY_COUNT; i++)
+    {
+        RectBounds query = getBlockRectBounds(&(Block){
+            .position = {
+                .x = testRandomFloat(random, -20.0f, (float)COORDINATE_SPACE),
+                .y = testRandomFloat(random, 0.0f, (float)COORDINATE_SPACE + 20.0f),
+            },
+            .width = testRandomFloat(random, 1.0f, 80.0f),
+            .height = testRandomFloat(random, 1.0f, 80.0f),
+        });
+
+        vectorClear(&result);
+        quadTreeRetrieveAllByBounds(quadTree, query, &result);
+        memset(found, 0, sizeof(bool) * blockCount);
+
+        const Block** foundBlocks = result.data;
+
+        for (size_t j = 0; j < vectorSize(&result, sizeof(const Block*)); j++)
+        {
+            // the blocks are found in the array the tree was pointed at
+            bool inArray = foundBlocks[j] >= blocks && foundBlocks[j] < blocks + blockCount;
+            TEST_CHECK(inArray, failures);
+
+            if (!inArray)
+                continue;
+
+            size_t block = (size_t)(foundBlocks[j] - blocks);
+            TEST_CHECK(inserted[block] && !found[block], failures);
+            found[block] = true;
+        }
+
+        for (size_t j = 0; j < blockCount; j++)
+        {
+            RectBounds bounds = getBlockRectBounds(&blocks[j]);
+
+            if (inserted[j] && boundsOverlapStrictly(&bounds, &query))
+                TEST_CHECK(found[j], failures);
+        }
+    }
+
+    free(found);
+    vectorFree(&result);
+}
+
+static void checkClone(size_t boardIndex, uint32_t* random, size_t* failures)
+{
+    size_t blockCount = 100 + boardIndex * boardIndex * 400;
+    float maxSize = 80.0f / (float)(boardIndex + 1);
+    Block* blocks = checkedMalloc(sizeof(Block) * blockCount);
+    bool* inserted = checkedMalloc(sizeof(bool) * blockCount);
+
+    for (size_t i = 0; i < blockCount; i++)
+        blocks[i] = testRandomBlock(random, boardBounds, 2.0f, maxSize);
+
+    QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        inserted[i] = testRandom(random) % 3 != 0;
+
+        if (!inserted[i])
+            quadTreeRemoveBlock(&quadTree, &blocks[i]);
+    }
+
+    // the blocks are moved to a new array, which the copy is pointed at
+    Block* movedBlocks = checkedMalloc(sizeof(Block) * blockCount);
+    memcpy(movedBlocks, blocks, sizeof(Block) * blockCount);
+    QuadTree clone = quadTreeClone(&quadTree, movedBlocks);
+
+    TEST_CHECK(clone.elemCount == quadTree.elemCount, failures);
+    TEST_CHECK(clone.queryStats.queryCount == 0, failures);
+
+    // the original is emptied and freed, and its blocks are wiped, none of which may reach the copy
+    for (size_t i = 0; i < blockCount; i++)
+        quadTreeRemoveBlock(&quadTree, &blocks[i]);
+
+    quadTreeFree(&quadTree);
+    memset(blocks, 0xff, sizeof(Block) * blockCount);
+    free(blocks);
+
+    checkQueries(&clone, movedBlocks, blockCount, inserted, random, failures);
+
+    // the copy can be changed like any other tree
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        if (testRandom(random) % 2 != 0)
+            continue;
+
+        if (inserted[i])
+            TEST_CHECK(quadTreeRemoveBlock(&clone, &movedBlocks[i]), failures);
+        else
+            TEST_CHECK(quadTreeInsert(&clone, &movedBlocks[i]), failures);
+
+        inserted[i] = !inserted[i];
+    }
+
+    size_t insertedCount = 0;
+
+    for (size_t i = 0; i < blockCount; i++)
+        insertedCount += inserted[i];
+
+    TEST_CHECK(clone.elemCount == insertedCount, failures);
+    checkQueries(&clone, movedBlocks, blockCount, inserted, random, failures);
+
+    quadTreeFree(&clone);
+    free(movedBlocks);
+    free(inserted);
+}
+
+int main(void)
+{
+    uint32_t random = 14;
+    size_t failureCount = 0;
+
+    for (size_t i = 0; i < CLONE_TEST_BOARD_COUNT; i++)
+        checkClone(i, &random, &failureCount);
+
+    printf("%d boards, %zu failed checks\n", CLONE_TEST_BOARD_COUNT, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,157 @@
+// Measures quadTreeRetrieveAllByBounds, which drops the blocks stored in many leaves by stamping them, against
+// the same walk down the tree dropping them by scanning the blocks found so far, the way it did before the stamps.
+// The levels are grids of a few sizes with nine in ten cells holding a block, queried with squares of a few sizes,
+// so that the results grow from a few blocks to thousands of them.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define DEDUP_BENCHMARK_MIN_SECONDS 0.2
+#define DEDUP_BENCHMARK_QUERY_COUNT 16
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t gridSizes[][2] = { { 10, 20 }, { 100, 100 }, { 300, 300 } };
+static const float queryHalfSizes[] = { 25.0f, 100.0f, 300.0f };
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+// the same nodes as the quadrants quadTreeVisitByBounds goes down into, which only touching the query leaves out
+static bool boundsOverlapStrictly(const RectBounds* a, const RectBounds* b)
+{
+    return a->topLeft.x < b->bottomRight.x && a->bottomRight.x > b->topLeft.x
+        && a->bottomRight.y < b->topLeft.y && a->topLeft.y > b->bottomRight.y;
+}
+
+// the blocks of the leaves which the bounds reach, each found block is looked for among the ones found before
+static void retrieveAllByBoundsScanning(const QuadTree* quadTree, const Block* blocks, RectBounds bounds,
+    Vector* result)
+{
+    uint32_t stack[QUAD_TREE_VISIT_STACK_CAPACITY];
+    size_t stackSize = 0;
+    stack[stackSize++] = QUAD_TREE_ROOT_INDEX;
+
+    while (stackSize > 0)
+    {
+        const QuadTreeNode* node = quadTreeGetNode(quadTree, stack[--stackSize]);
+
+        if (!boundsOverlapStrictly(&node->bounds, &bounds))
+            continue;
+
+        if (quadTreeNodeHasSubnodes(node))
+        {
+            for (uint32_t i = 0; i < 4; i++)
+                stack[stackSize++] = node->nodes + i;
+
+            continue;
+        }
+
+        for (uint32_t leaf = stack[stackSize]; leaf != NO_QUAD_TREE_INDEX; leaf = node->overflow)
+        {
+            node = quadTreeGetNode(quadTree, leaf);
+
+            for (size_t i = 0; i < quadTreeNodeBlockCount(node); i++)
+            {
+                const Block* block = &blocks[node->blocks[i]];
+                const Block** found = result->data;
+                bool duplicate = false;
+
+                for (size_t j = 0; j < vectorSize(result, sizeof(const Block*)) && !duplicate; j++)
+                    duplicate = found[j] == block;
+
+                if (!duplicate)
+                    vectorPushBack(result, &block, sizeof(const Block*));
+            }
+        }
+    }
+}
+
+// every round runs the same queries, so both ways find the same number of blocks
+static double measureQueries(QuadTree* quadTree, const Block* blocks, float halfSize, bool scanning,
+    size_t* foundCount)
+{
+    uint32_t random = 99;
+    RectBounds queries[DEDUP_BENCHMARK_QUERY_COUNT];
+
+    for (size_t i = 0; i < DEDUP_BENCHMARK_QUERY_COUNT; i++)
+    {
+        Vec2 center = {
+            .x = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+            .y = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+        };
+
+        queries[i] = (RectBounds){
+            .topLeft = { .x = center.x - halfSize, .y = center.y + halfSize },
+            .bottomRight = { .x = center.x + halfSize, .y = center.y - halfSize },
+        };
+    }
+
+    Vector result = vectorCreate();
+    size_t roundCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        *foundCount = 0;
+
+        for (size_t i = 0; i < DEDUP_BENCHMARK_QUERY_COUNT; i++)
+        {
+            vectorClear(&result);
+
+            if (scanning)
+                retrieveAllByBoundsScanning(quadTree, blocks, queries[i], &result);
+            else
+                quadTreeRetrieveAllByBounds(quadTree, queries[i], &result);
+
+            *foundCount += vectorSize(&result, sizeof(const Block*));
+        }
+
+        roundCount++;
+    } while (getSeconds(start) < DEDUP_BENCHMARK_MIN_SECONDS);
+
+    double seconds = getSeconds(start) / (double)(roundCount * DEDUP_BENCHMARK_QUERY_COUNT);
+    *foundCount /= DEDUP_BENCHMARK_QUERY_COUNT;
+    vectorFree(&result);
+
+    return seconds * 1e6;
+}
+
+int main(void)
+{
+    uint32_t random = 1;
+    printf("grid       blocks  half size   found   scanning us   stamps us   speedup\n");
+
+    for (size_t i = 0; i < arrLength(gridSizes); i++)
+    {
+        size_t blockCount;
+        Block* blocks = testCreateGridBlocks(gridSizes[i][0], gridSizes[i][1], 90, &random, &blockCount);
+        QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+
+        for (size_t j = 0; j < arrLength(queryHalfSizes); j++)
+        {
+            size_t scanningFound;
+            size_t stampsFound;
+            double scanningMicroseconds = measureQueries(&quadTree, blocks, queryHalfSizes[j], true,
+                &scanningFound);
+            double stampsMicroseconds = measureQueries(&quadTree, blocks, queryHalfSizes[j], false, &stampsFound);
+
+            printf("%4zux%-4zu %7zu %10.0f %7zu %13.2f %11.2f %8.1fx%s\n", gridSizes[i][0], gridSizes[i][1],
+                blockCount, (double)queryHalfSizes[j], stampsFound, scanningMicroseconds, stampsMicroseconds,
+                scanningMicroseconds / stampsMicroseconds,
+                scanningFound == stampsFound ? "" : " (found counts differ)");
+        }
+
+        quadTreeFree(&quadTree);
+        free(blocks);
+    }
+
+    return EXIT_SUCCESS;
+}
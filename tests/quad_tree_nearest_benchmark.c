@@ -0,0 +1,182 @@
+// Measures the nearest block and radius queries of the quad tree against scans of all of the blocks, on boards of
+// random blocks of which a third was removed.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define NEAREST_BENCHMARK_MIN_SECONDS 0.2
+#define NEAREST_BENCHMARK_RADIUS 50.0f
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+typedef enum NearestQueryType
+{
+    NEAREST_QUERY_FIRST,
+    NEAREST_QUERY_FIRST_8,
+    NEAREST_QUERY_RADIUS,
+} NearestQueryType;
+
+typedef struct NearestBenchmark
+{
+    QuadTree quadTree;
+    const Block* blocks;
+    const bool* inserted;
+    size_t blockCount;
+    const Block** result;
+    Vector resultVector;
+    float* distances;
+} NearestBenchmark;
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static float getBlockDistanceSquared(const Block* block, Vec2 point)
+{
+    RectBounds bounds = getBlockRectBounds(block);
+    return getPointBoundsDistanceSquared(point, &bounds);
+}
+
+static size_t queryQuadTree(NearestBenchmark* benchmark, NearestQueryType type, Vec2 point)
+{
+    switch (type)
+    {
+    case NEAREST_QUERY_FIRST:
+        return quadTreeFindNearest(&benchmark->quadTree, point, 1, benchmark->result);
+    case NEAREST_QUERY_FIRST_8:
+        return quadTreeFindNearest(&benchmark->quadTree, point, 8, benchmark->result);
+    case NEAREST_QUERY_RADIUS:
+        vectorClear(&benchmark->resultVector);
+        quadTreeRetrieveAllInRadius(&benchmark->quadTree, point, NEAREST_BENCHMARK_RADIUS,
+            &benchmark->resultVector);
+        return vectorSize(&benchmark->resultVector, sizeof(const Block*));
+    }
+
+    return 0;
+}
+
+// the scan picks the nearest blocks by selection, which beats sorting all of them for a few blocks
+static size_t queryScan(NearestBenchmark* benchmark, NearestQueryType type, Vec2 point)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < benchmark->blockCount; i++)
+    {
+        if (benchmark->inserted[i])
+            benchmark->distances[count++] = getBlockDistanceSquared(&benchmark->blocks[i], point);
+    }
+
+    if (type == NEAREST_QUERY_RADIUS)
+    {
+        size_t found = 0;
+
+        for (size_t i = 0; i < count; i++)
+            found += benchmark->distances[i] <= NEAREST_BENCHMARK_RADIUS * NEAREST_BENCHMARK_RADIUS;
+
+        return found;
+    }
+
+    size_t wanted = min(type == NEAREST_QUERY_FIRST ? (size_t)1 : (size_t)8, count);
+
+    for (size_t i = 0; i < wanted; i++)
+    {
+        size_t nearest = i;
+
+        for (size_t j = i + 1; j < count; j++)
+        {
+            if (benchmark->distances[j] < benchmark->distances[nearest])
+                nearest = j;
+        }
+
+        float distance = benchmark->distances[i];
+        benchmark->distances[i] = benchmark->distances[nearest];
+        benchmark->distances[nearest] = distance;
+    }
+
+    return wanted;
+}
+
+static double measureQueries(NearestBenchmark* benchmark, NearestQueryType type, bool scan)
+{
+    uint32_t random = 3;
+    size_t queryCount = 0;
+    size_t foundCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        for (size_t i = 0; i < 16; i++, queryCount++)
+        {
+            Vec2 point = { .x = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+                .y = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE) };
+            foundCount += scan ? queryScan(benchmark, type, point) : queryQuadTree(benchmark, type, point);
+        }
+    } while (getSeconds(start) < NEAREST_BENCHMARK_MIN_SECONDS);
+
+    // keeps the queries from being optimized out
+    if (foundCount == SIZE_MAX)
+        printf("\n");
+
+    return getSeconds(start) / (double)queryCount * 1e6;
+}
+
+static void runNearestBenchmark(size_t blockCount, uint32_t* random)
+{
+    Block* blocks = checkedMalloc(sizeof(Block) * blockCount);
+    bool* inserted = checkedMalloc(sizeof(bool) * blockCount);
+    float blockSize = (float)COORDINATE_SPACE / sqrtf((float)blockCount) * 0.8f;
+
+    for (size_t i = 0; i < blockCount; i++)
+        blocks[i] = testRandomBlock(random, boardBounds, blockSize * 0.5f, blockSize);
+
+    NearestBenchmark benchmark = {
+        .quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1),
+        .blocks = blocks,
+        .inserted = inserted,
+        .blockCount = blockCount,
+        .result = checkedMalloc(sizeof(const Block*) * 8),
+        .resultVector = vectorCreate(),
+        .distances = checkedMalloc(sizeof(float) * blockCount),
+    };
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        inserted[i] = i % 3 != 0;
+
+        if (!inserted[i])
+            quadTreeRemoveBlock(&benchmark.quadTree, &blocks[i]);
+    }
+
+    printf("%7zu", blockCount);
+
+    for (NearestQueryType type = NEAREST_QUERY_FIRST; type <= NEAREST_QUERY_RADIUS; type++)
+        printf(" %10.2f %10.2f", measureQueries(&benchmark, type, false), measureQueries(&benchmark, type, true));
+
+    printf("\n");
+
+    quadTreeFree(&benchmark.quadTree);
+    vectorFree(&benchmark.resultVector);
+    free(benchmark.distances);
+    free(benchmark.result);
+    free(inserted);
+    free(blocks);
+}
+
+int main(void)
+{
+    uint32_t random = 11;
+    size_t blockCounts[] = { 1000, 10000, 100000 };
+
+    printf(" blocks    k=1 us   (scan)    k=8 us   (scan)   r=50 us   (scan)\n");
+
+    for (size_t i = 0; i < arrLength(blockCounts); i++)
+        runNearestBenchmark(blockCounts[i], &random);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,113 @@
+// Measures loading a level into a quad tree, querying it and freeing it, on level grids of a few sizes, seven in
+// ten cells holding a block. The nodes come from the pool of the tree, so the last column allocates and frees the
+// same number of nodes one by one, the way the tree did before it had the pool, for comparison with the first and
+// the third column.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define POOL_BENCHMARK_MIN_SECONDS 0.2
+#define POOL_BENCHMARK_QUERY_COUNT 1000
+#define POOL_BENCHMARK_QUERY_SIZE 50.0f
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t gridSizes[][2] = { { 10, 20 }, { 100, 100 }, { 300, 300 } };
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static void benchmarkGrid(size_t colCount, size_t rowCount, uint32_t* random)
+{
+    size_t blockCount;
+    Block* blocks = testCreateGridBlocks(colCount, rowCount, 70, random, &blockCount);
+    Vector result = vectorCreate();
+    double buildSeconds = 0.0;
+    double querySeconds = 0.0;
+    double freeSeconds = 0.0;
+    size_t foundCount = 0;
+    size_t nodeCount = 0;
+    size_t roundCount = 0;
+
+    do
+    {
+        clock_t start = clock();
+        QuadTree quadTree = quadTreeCreate(boardBounds, blocks, blockCount);
+
+        for (size_t i = 0; i < blockCount; i++)
+            quadTreeInsert(&quadTree, &blocks[i]);
+
+        buildSeconds += getSeconds(start);
+        start = clock();
+
+        for (size_t i = 0; i < POOL_BENCHMARK_QUERY_COUNT; i++)
+        {
+            RectBounds query = getBlockRectBounds(&(Block){
+                .position = {
+                    .x = testRandomFloat(random, 0.0f, (float)COORDINATE_SPACE - POOL_BENCHMARK_QUERY_SIZE),
+                    .y = testRandomFloat(random, POOL_BENCHMARK_QUERY_SIZE, (float)COORDINATE_SPACE),
+                },
+                .width = POOL_BENCHMARK_QUERY_SIZE,
+                .height = POOL_BENCHMARK_QUERY_SIZE,
+            });
+
+            vectorClear(&result);
+            quadTreeRetrieveAllByBounds(&quadTree, query, &result);
+            foundCount += vectorSize(&result, sizeof(const Block*));
+        }
+
+        querySeconds += getSeconds(start);
+        nodeCount = quadTreeGetStats(&quadTree).nodeCount;
+
+        start = clock();
+        quadTreeFree(&quadTree);
+        freeSeconds += getSeconds(start);
+
+        roundCount++;
+    } while (buildSeconds + querySeconds + freeSeconds < POOL_BENCHMARK_MIN_SECONDS);
+
+    // every node on its own, freed in the order it was allocated in
+    QuadTreeNode** nodes = checkedMalloc(sizeof(QuadTreeNode*) * nodeCount);
+    size_t mallocCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        for (size_t i = 0; i < nodeCount; i++)
+            nodes[i] = checkedMalloc(sizeof(QuadTreeNode));
+
+        for (size_t i = 0; i < nodeCount; i++)
+            free(nodes[i]);
+
+        mallocCount++;
+    } while (getSeconds(start) < POOL_BENCHMARK_MIN_SECONDS);
+
+    double mallocSeconds = getSeconds(start) / (double)mallocCount;
+    free(nodes);
+
+    printf("%4zux%-4zu %7zu %7zu %11.1f %13.1f %9.1f %14.1f %8zu\n", colCount, rowCount, blockCount, nodeCount,
+        buildSeconds / (double)roundCount * 1e6, querySeconds / (double)roundCount * 1e6,
+        freeSeconds / (double)roundCount * 1e6, mallocSeconds * 1e6,
+        foundCount / (roundCount * POOL_BENCHMARK_QUERY_COUNT));
+
+    vectorFree(&result);
+    free(blocks);
+}
+
+int main(void)
+{
+    uint32_t random = 1;
+    printf("grid       blocks   nodes    build us  1000 query us   free us  node malloc us    found\n");
+
+    for (size_t i = 0; i < arrLength(gridSizes); i++)
+        benchmarkGrid(gridSizes[i][0], gridSizes[i][1], &random);
+
+    return EXIT_SUCCESS;
+}
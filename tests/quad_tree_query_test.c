@@ -0,0 +1,249 @@
+// Checks the quad tree queries which test the blocks themselves, rather than just gathering the blocks of the
+// leaves they reach, against brute-force scans of the blocks. Blocks lying within a rounding error of the edge of
+// a query may or may not be found.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define QUERY_TEST_BOARD_COUNT 8
+#define QUERY_TEST_QUERY_COUNT 500
+#define QUERY_TEST_NEAREST_QUERY_COUNT 200
+#define QUERY_TEST_EDGE_TOLERANCE 1e-3f
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+typedef struct QueryTestBoard
+{
+    Block* blocks;
+    size_t blockCount;
+    bool* inserted;
+    QuadTree quadTree;
+} QueryTestBoard;
+
+// later boards hold more and smaller blocks, and a third of the blocks is removed again
+static QueryTestBoard createQueryTestBoard(size_t boardIndex, uint32_t* random)
+{
+    QueryTestBoard board;
+    board.blockCount = 60 + boardIndex * boardIndex * 150;
+    board.blocks = checkedMalloc(sizeof(Block) * board.blockCount);
+    board.inserted = checkedMalloc(sizeof(bool) * board.blockCount);
+
+    float maxSize = 80.0f / (float)(boardIndex + 1);
+
+    for (size_t i = 0; i < board.blockCount; i++)
+        board.blocks[i] = testRandomBlock(random, boardBounds, 2.0f, maxSize);
+
+    board.quadTree = quadTreeBuild(boardBounds, board.blocks, board.blockCount, 1);
+
+    for (size_t i = 0; i < board.blockCount; i++)
+    {
+        board.inserted[i] = testRandom(random) % 3 != 0;
+
+        if (!board.inserted[i])
+            quadTreeRemoveBlock(&board.quadTree, &board.blocks[i]);
+    }
+
+    return board;
+}
+
+static void freeQueryTestBoard(QueryTestBoard* board)
+{
+    quadTreeFree(&board->quadTree);
+    free(board->inserted);
+    free(board->blocks);
+}
+
+static float getBlockDistanceSquared(const Block* block, Vec2 point)
+{
+    RectBounds bounds = getBlockRectBounds(block);
+    return getPointBoundsDistanceSquared(point, &bounds);
+}
+
+static int compareFloats(const void* a, const void* b)
+{
+    float first = *(const float*)a;
+    float second = *(const float*)b;
+    return (first > second) - (first < second);
+}
+
+// squared distances from the point to all of the inserted blocks, nearest first
+static size_t getSortedBlockDistances(const QueryTestBoard* board, Vec2 point, float* distances)
+{
+    size_t count = 0;
+
+    for (size_t i = 0; i < board->blockCount; i++)
+    {
+        if (board->inserted[i])
+            distances[count++] = getBlockDistanceSquared(&board->blocks[i], point);
+    }
+
+    qsort(distances, count, sizeof(float), compareFloats);
+    return count;
+}
+
+static bool distancesEqual(float a, float b)
+{
+    return a - b <= QUERY_TEST_EDGE_TOLERANCE * (1.0f + b) && b - a <= QUERY_TEST_EDGE_TOLERANCE * (1.0f + a);
+}
+
+static Vec2 getRandomPoint(uint32_t* random)
+{
+    return (Vec2){ .x = testRandomFloat(random, -50.0f, (float)COORDINATE_SPACE + 50.0f),
+        .y = testRandomFloat(random, -50.0f, (float)COORDINATE_SPACE + 50.0f) };
+}
+
+typedef struct FoundBlocks
+{
+    const Block* blocks;
+    bool* found;
+    size_t duplicateCount;
+} FoundBlocks;
+
+static bool markFoundBlock(const Block* block, void* context)
+{
+    FoundBlocks* foundBlocks = context;
+    size_t index = (size_t)(block - foundBlocks->blocks);
+
+    if (foundBlocks->found[index])
+        foundBlocks->duplicateCount++;
+
+    foundBlocks->found[index] = true;
+    return true;
+}
+
+static void checkCircleQueries(QueryTestBoard* board, uint32_t* random, size_t* failures)
+{
+    bool* found = checkedMalloc(sizeof(bool) * board->blockCount);
+
+    for (size_t i = 0; i < QUERY_TEST_QUERY_COUNT; i++)
+    {
+        Vec2 center = getRandomPoint(random);
+        float radius = testRandomFloat(random, 1.0f, 120.0f);
+        float radiusSquared = radius * radius;
+
+        memset(found, 0, sizeof(bool) * board->blockCount);
+        FoundBlocks foundBlocks = { .blocks = board->blocks, .found = found, .duplicateCount = 0 };
+
+        bool finished = quadTreeVisitByCircle(&board->quadTree, center, radius, markFoundBlock, &foundBlocks);
+        TEST_CHECK(finished, failures);
+        TEST_CHECK(foundBlocks.duplicateCount == 0, failures);
+
+        for (size_t j = 0; j < board->blockCount; j++)
+        {
+            float distanceSquared = getBlockDistanceSquared(&board->blocks[j], center);
+
+            if (found[j])
+            {
+                TEST_CHECK(board->inserted[j], failures);
+                TEST_CHECK(distanceSquared < radiusSquared * (1.0f + QUERY_TEST_EDGE_TOLERANCE), failures);
+            }
+            else if (board->inserted[j])
+            {
+                TEST_CHECK(distanceSquared >= radiusSquared * (1.0f - QUERY_TEST_EDGE_TOLERANCE), failures);
+            }
+        }
+    }
+
+    free(found);
+}
+
+// the blocks found for every count have to be the inserted ones at the same distances as the nearest blocks found
+// by the scan, ties can be broken either way
+static void checkNearestQueries(QueryTestBoard* board, uint32_t* random, size_t* failures)
+{
+    float* distances = checkedMalloc(sizeof(float) * board->blockCount);
+    const Block** result = checkedMalloc(sizeof(const Block*) * (board->blockCount + 1));
+
+    for (size_t i = 0; i < QUERY_TEST_NEAREST_QUERY_COUNT; i++)
+    {
+        Vec2 point = getRandomPoint(random);
+        size_t insertedCount = getSortedBlockDistances(board, point, distances);
+        size_t counts[] = { 1, 8, 32, insertedCount + 1 };
+
+        for (size_t j = 0; j < arrLength(counts); j++)
+        {
+            size_t foundCount = quadTreeFindNearest(&board->quadTree, point, counts[j], result);
+            TEST_CHECK(foundCount == min(counts[j], insertedCount), failures);
+
+            for (size_t k = 0; k < min(foundCount, insertedCount); k++)
+            {
+                TEST_CHECK(board->inserted[result[k] - board->blocks], failures);
+                TEST_CHECK(distancesEqual(getBlockDistanceSquared(result[k], point), distances[k]), failures);
+            }
+        }
+    }
+
+    free(result);
+    free(distances);
+}
+
+static void checkRadiusQueries(QueryTestBoard* board, uint32_t* random, size_t* failures)
+{
+    bool* found = checkedMalloc(sizeof(bool) * board->blockCount);
+    Vector result = vectorCreate();
+
+    for (size_t i = 0; i < QUERY_TEST_QUERY_COUNT; i++)
+    {
+        Vec2 point = getRandomPoint(random);
+        float radius = testRandomFloat(random, 0.0f, 200.0f);
+        float radiusSquared = radius * radius;
+
+        vectorClear(&result);
+        quadTreeRetrieveAllInRadius(&board->quadTree, point, radius, &result);
+        memset(found, 0, sizeof(bool) * board->blockCount);
+
+        const Block** foundBlocks = result.data;
+        float lastDistanceSquared = 0.0f;
+
+        for (size_t j = 0; j < vectorSize(&result, sizeof(const Block*)); j++)
+        {
+            size_t block = (size_t)(foundBlocks[j] - board->blocks);
+            float distanceSquared = getBlockDistanceSquared(foundBlocks[j], point);
+
+            TEST_CHECK(board->inserted[block], failures);
+            TEST_CHECK(!found[block], failures);
+            TEST_CHECK(distanceSquared <= radiusSquared * (1.0f + QUERY_TEST_EDGE_TOLERANCE), failures);
+            TEST_CHECK(distanceSquared >= lastDistanceSquared * (1.0f - QUERY_TEST_EDGE_TOLERANCE), failures);
+
+            found[block] = true;
+            lastDistanceSquared = distanceSquared;
+        }
+
+        for (size_t j = 0; j < board->blockCount; j++)
+        {
+            float distanceSquared = getBlockDistanceSquared(&board->blocks[j], point);
+
+            if (board->inserted[j] && distanceSquared < radiusSquared * (1.0f - QUERY_TEST_EDGE_TOLERANCE))
+                TEST_CHECK(found[j], failures);
+        }
+    }
+
+    vectorFree(&result);
+    free(found);
+}
+
+int main(void)
+{
+    uint32_t random = 1;
+    size_t failureCount = 0;
+
+    for (size_t i = 0; i < QUERY_TEST_BOARD_COUNT; i++)
+    {
+        QueryTestBoard board = createQueryTestBoard(i, &random);
+        checkCircleQueries(&board, &random, &failureCount);
+        checkNearestQueries(&board, &random, &failureCount);
+        checkRadiusQueries(&board, &random, &failureCount);
+        freeQueryTestBoard(&board);
+    }
+
+    printf("%d boards, %zu failed checks\n", QUERY_TEST_BOARD_COUNT, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
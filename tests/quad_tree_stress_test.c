@@ -0,0 +1,158 @@
+// Builds and mutates many quad trees on several threads at once, checking every query against a brute-force scan
+// of the blocks. The trees share nothing, so any state left outside of them shows up as wrong results.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "quad_tree.h"
+#include "thread.h"
+#include "test_utils.h"
+
+#define STRESS_TREE_COUNT 256
+#define STRESS_THREAD_COUNT 8
+#define STRESS_OPERATION_COUNT 2000
+#define STRESS_MIN_BLOCKS 50
+#define STRESS_MAX_BLOCKS 450
+
+typedef struct StressWorker
+{
+    Thread thread;
+    size_t index;
+    size_t failureCount;
+} StressWorker;
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+// blocks which only touch the query may or may not be found, blocks which overlap it have to be
+static bool boundsOverlapStrictly(const RectBounds* a, const RectBounds* b)
+{
+    return a->topLeft.x < b->bottomRight.x && a->bottomRight.x > b->topLeft.x
+        && a->bottomRight.y < b->topLeft.y && a->topLeft.y > b->bottomRight.y;
+}
+
+static void checkQuery(QuadTree* quadTree, const Block* blocks, size_t blockCount, const bool* inserted,
+    RectBounds query, Vector* result, bool* found, size_t* failures)
+{
+    vectorClear(result);
+    quadTreeRetrieveAllByBounds(quadTree, query, result);
+    memset(found, 0, blockCount * sizeof(bool));
+
+    const Block** foundBlocks = result->data;
+
+    for (size_t i = 0; i < vectorSize(result, sizeof(const Block*)); i++)
+    {
+        size_t block = (size_t)(foundBlocks[i] - blocks);
+
+        // the query returns every block of the leaves it reaches, so only the blocks it has to find are checked
+        TEST_CHECK(inserted[block], failures);
+        TEST_CHECK(!found[block], failures);
+        found[block] = true;
+    }
+
+    size_t insertedCount = 0;
+
+    for (size_t i = 0; i < blockCount; i++)
+    {
+        RectBounds bounds = getBlockRectBounds(&blocks[i]);
+
+        if (inserted[i])
+            insertedCount++;
+
+        if (inserted[i] && boundsOverlapStrictly(&bounds, &query))
+            TEST_CHECK(found[i], failures);
+    }
+
+    TEST_CHECK(quadTree->elemCount == insertedCount, failures);
+}
+
+static void stressQuadTree(size_t treeIndex, size_t* failures)
+{
+    uint32_t random = (uint32_t)treeIndex * 7919u + 1u;
+    size_t blockCount = STRESS_MIN_BLOCKS + testRandom(&random) % (STRESS_MAX_BLOCKS - STRESS_MIN_BLOCKS);
+
+    Block* blocks = checkedMalloc(sizeof(Block) * blockCount);
+    bool* inserted = checkedCalloc(blockCount, sizeof(bool));
+    bool* found = checkedCalloc(blockCount, sizeof(bool));
+
+    for (size_t i = 0; i < blockCount; i++)
+        blocks[i] = testRandomBlock(&random, boardBounds, 5.0f, 70.0f);
+
+    QuadTree quadTree = quadTreeCreate(boardBounds, blocks, blockCount);
+    Vector result = vectorCreate();
+
+    for (size_t i = 0; i < STRESS_OPERATION_COUNT; i++)
+    {
+        size_t block = testRandom(&random) % blockCount;
+
+        // removing a block twice must fail the second time without changing the tree
+        if (inserted[block])
+        {
+            TEST_CHECK(quadTreeRemoveBlock(&quadTree, &blocks[block]), failures);
+            TEST_CHECK(!quadTreeRemoveBlock(&quadTree, &blocks[block]), failures);
+        }
+        else
+        {
+            TEST_CHECK(quadTreeInsert(&quadTree, &blocks[block]), failures);
+        }
+
+        inserted[block] = !inserted[block];
+
+        Vec2 center = { .x = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+            .y = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE) };
+        float halfSize = testRandomFloat(&random, 5.0f, 80.0f);
+
+        RectBounds query = {
+            .topLeft = { .x = center.x - halfSize, .y = center.y + halfSize },
+            .bottomRight = { .x = center.x + halfSize, .y = center.y - halfSize },
+        };
+
+        checkQuery(&quadTree, blocks, blockCount, inserted, query, &result, found, failures);
+    }
+
+    quadTreeFree(&quadTree);
+    vectorFree(&result);
+    free(found);
+    free(inserted);
+    free(blocks);
+}
+
+static void runStressWorker(void* arg)
+{
+    StressWorker* worker = arg;
+
+    for (size_t i = worker->index; i < STRESS_TREE_COUNT; i += STRESS_THREAD_COUNT)
+        stressQuadTree(i, &worker->failureCount);
+}
+
+int main(void)
+{
+    StressWorker workers[STRESS_THREAD_COUNT];
+    bool started[STRESS_THREAD_COUNT];
+
+    for (size_t i = 0; i < STRESS_THREAD_COUNT; i++)
+    {
+        workers[i] = (StressWorker){ .index = i, .failureCount = 0 };
+        started[i] = threadStart(&workers[i].thread, runStressWorker, &workers[i]);
+    }
+
+    size_t failureCount = 0;
+
+    for (size_t i = 0; i < STRESS_THREAD_COUNT; i++)
+    {
+        // the trees of workers which failed to start are still checked, just not in parallel
+        if (started[i])
+            threadJoin(&workers[i].thread);
+        else
+            runStressWorker(&workers[i]);
+
+        failureCount += workers[i].failureCount;
+    }
+
+    printf("%d trees on %d threads, %zu failed checks\n", STRESS_TREE_COUNT, STRESS_THREAD_COUNT, failureCount);
+    return failureCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
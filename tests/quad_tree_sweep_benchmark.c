@@ -0,0 +1,133 @@
+// Measures the cost of building and querying a quad tree, and the memory it takes, for the levels of the game and
+// for a few synthetic boards. The capacity of the leaves and the depth limit are compiled in, so the
+// quad_tree_sweep target builds this benchmark once for every pair of them and runs all of the builds.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "board.h"
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define SWEEP_LAST_LEVEL 5
+#define SWEEP_MIN_SECONDS 0.2
+#define SWEEP_QUERY_RADIUS BALL_RADIUS
+#define SWEEP_QUERY_LENGTH 20.0f
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+// blocks piled up in a small area, which keep splitting the leaves until the depth limit
+static Block* createPileBlocks(size_t blockCount, uint32_t* random)
+{
+    Block* blocks = checkedMalloc(sizeof(Block) * blockCount);
+    RectBounds pileBounds = {
+        .topLeft = { .x = 500.0f, .y = 534.0f },
+        .bottomRight = { .x = 514.0f, .y = 520.0f },
+    };
+
+    for (size_t i = 0; i < blockCount; i++)
+        blocks[i] = testRandomBlock(random, pileBounds, 4.0f, 4.0f);
+
+    return blocks;
+}
+
+static bool countBlock(const Block* UNUSED(block), void* context)
+{
+    (*(size_t*)context)++;
+    return true;
+}
+
+static void benchmarkQuadTree(const char* name, const Block* blocks, size_t blockCount)
+{
+    size_t buildCount = 1;
+    clock_t start = clock();
+    QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+
+    while (getSeconds(start) < SWEEP_MIN_SECONDS)
+    {
+        quadTreeFree(&quadTree);
+        quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+        buildCount++;
+    }
+
+    double buildSeconds = getSeconds(start) / (double)buildCount;
+
+    // half of the queries start at the blocks, so that piles are queried as often as they'd be hit, the rest are
+    // spread over the whole board
+    uint32_t random = 7;
+    size_t queryCount = 0;
+    size_t foundCount = 0;
+    start = clock();
+
+    do
+    {
+        for (size_t i = 0; i < 64; i++, queryCount++)
+        {
+            Vec2 queryStart = blocks[testRandom(&random) % blockCount].position;
+
+            if (queryCount % 2 == 0)
+            {
+                queryStart = (Vec2){ .x = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE),
+                    .y = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE) };
+            }
+
+            Vec2 queryEnd = addVecs(queryStart, scalar(vecFromAngle(testRandomFloat(&random, 0.0f, 6.28f)),
+                SWEEP_QUERY_LENGTH));
+            quadTreeVisitBySweptCircle(&quadTree, queryStart, queryEnd, SWEEP_QUERY_RADIUS, countBlock,
+                &foundCount);
+        }
+    } while (getSeconds(start) < SWEEP_MIN_SECONDS);
+
+    double querySeconds = getSeconds(start) / (double)queryCount;
+    QuadTreeStats stats = quadTreeGetStats(&quadTree);
+
+    printf("%-3d %-3d %-9s %6zu %11.1f %10.0f %11.1f %6zu %6zu %6zu %8.1f\n", MAX_QUAD_TREE_NODE_BLOCKS,
+        QUAD_TREE_MAX_DEPTH, name, blockCount, buildSeconds * 1e6, querySeconds * 1e9,
+        (double)foundCount / (double)queryCount, stats.nodeCount, stats.overflowLeafCount, stats.depth,
+        (double)stats.memoryBytes / 1024.0);
+
+    quadTreeFree(&quadTree);
+}
+
+int main(void)
+{
+    printf("cap dep board     blocks    build us   query ns  candidates  nodes  overf  depth   mem KB\n");
+
+    // the levels are loaded by the board, so the blocks are laid out exactly as in the game, and the blocks are
+    // read straight from its storage
+    for (unsigned int level = STARTING_LEVEL; level <= SWEEP_LAST_LEVEL; level++)
+    {
+        Board board;
+        initBoard(&board, level);
+
+        char name[16];
+        snprintf(name, sizeof(name), "level%u", level);
+        benchmarkQuadTree(name, board.blocksStorage, board.initialBlockCount);
+
+        freeBoard(&board);
+    }
+
+    uint32_t random = 5;
+    size_t blockCount;
+
+    Block* blocks = testCreateGridBlocks(100, 100, 100, &random, &blockCount);
+    benchmarkQuadTree("100x100", blocks, blockCount);
+    free(blocks);
+
+    blocks = testCreateGridBlocks(250, 200, 80, &random, &blockCount);
+    benchmarkQuadTree("250x200", blocks, blockCount);
+    free(blocks);
+
+    blocks = createPileBlocks(2000, &random);
+    benchmarkQuadTree("pile", blocks, 2000);
+    free(blocks);
+
+    return EXIT_SUCCESS;
+}
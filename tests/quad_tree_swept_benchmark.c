@@ -0,0 +1,197 @@
+// Measures finding the blocks a ball can touch during a frame with a single quadTreeRetrieveAllBySweptCircle query
+// along its path, against querying the bounds of the ball after each of the 16 sub steps of the frame, the way
+// the board did before the swept query. The levels are grids of a few sizes with seven in ten cells holding a
+// block, and the balls move at the launch speed and at four times of it. Every block which a ball overlaps after
+// any of the sub steps has to be among the blocks of the swept query, so that both find the same collisions.
+
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "quad_tree.h"
+#include "test_utils.h"
+
+#define SWEPT_BENCHMARK_MIN_SECONDS 0.2
+#define SWEPT_BENCHMARK_FRAME_COUNT 1000
+#define SWEPT_BENCHMARK_SUB_STEPS 16
+#define SWEPT_BENCHMARK_FRAME_TIME (1.0f / 60.0f)
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t gridSizes[][2] = { { 10, 20 }, { 40, 40 }, { 100, 100 } };
+static const float speedFactors[] = { 1.0f, 4.0f };
+
+typedef struct SweptBenchmarkFrame
+{
+    Vec2 start;
+    Vec2 end;
+} SweptBenchmarkFrame;
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static Ball getSubStepBall(const SweptBenchmarkFrame* frame, size_t subStep)
+{
+    float t = (float)(subStep + 1) / (float)SWEPT_BENCHMARK_SUB_STEPS;
+
+    return (Ball){
+        .position = {
+            .x = frame->start.x + (frame->end.x - frame->start.x) * t,
+            .y = frame->start.y + (frame->end.y - frame->start.y) * t,
+        },
+        .radius = BALL_RADIUS,
+    };
+}
+
+// returns the number of blocks found over all of the frames
+static size_t runFrames(QuadTree* quadTree, const SweptBenchmarkFrame* frames, bool swept, Vector* result)
+{
+    size_t foundCount = 0;
+
+    for (size_t i = 0; i < SWEPT_BENCHMARK_FRAME_COUNT; i++)
+    {
+        if (swept)
+        {
+            vectorClear(result);
+            quadTreeRetrieveAllBySweptCircle(quadTree, frames[i].start, frames[i].end, BALL_RADIUS, result);
+            foundCount += vectorSize(result, sizeof(const Block*));
+            continue;
+        }
+
+        for (size_t j = 0; j < SWEPT_BENCHMARK_SUB_STEPS; j++)
+        {
+            Ball ball = getSubStepBall(&frames[i], j);
+
+            vectorClear(result);
+            quadTreeRetrieveAllByBounds(quadTree, getBallRectBounds(&ball), result);
+            foundCount += vectorSize(result, sizeof(const Block*));
+        }
+    }
+
+    return foundCount;
+}
+
+static double measureFrames(QuadTree* quadTree, const SweptBenchmarkFrame* frames, bool swept, size_t* foundCount)
+{
+    Vector result = vectorCreate();
+    size_t roundCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        *foundCount = runFrames(quadTree, frames, swept, &result);
+        roundCount++;
+    } while (getSeconds(start) < SWEPT_BENCHMARK_MIN_SECONDS);
+
+    vectorFree(&result);
+    return getSeconds(start) / (double)(roundCount * SWEPT_BENCHMARK_FRAME_COUNT) * 1e6;
+}
+
+// returns the number of blocks a ball overlaps after a sub step which the swept query of its frame misses
+static size_t countMissedBlocks(QuadTree* quadTree, const SweptBenchmarkFrame* frames)
+{
+    Vector swept = vectorCreate();
+    Vector subStep = vectorCreate();
+    size_t missedCount = 0;
+
+    for (size_t i = 0; i < SWEPT_BENCHMARK_FRAME_COUNT; i++)
+    {
+        vectorClear(&swept);
+        quadTreeRetrieveAllBySweptCircle(quadTree, frames[i].start, frames[i].end, BALL_RADIUS, &swept);
+
+        const Block** sweptBlocks = swept.data;
+        size_t sweptCount = vectorSize(&swept, sizeof(const Block*));
+
+        for (size_t j = 0; j < SWEPT_BENCHMARK_SUB_STEPS; j++)
+        {
+            Ball ball = getSubStepBall(&frames[i], j);
+
+            vectorClear(&subStep);
+            quadTreeRetrieveAllByBounds(quadTree, getBallRectBounds(&ball), &subStep);
+
+            const Block** subStepBlocks = subStep.data;
+
+            for (size_t k = 0; k < vectorSize(&subStep, sizeof(const Block*)); k++)
+            {
+                RectBounds bounds = getBlockRectBounds(subStepBlocks[k]);
+
+                if (getPointBoundsDistanceSquared(ball.position, &bounds) > ball.radius * ball.radius)
+                    continue;
+
+                bool found = false;
+
+                for (size_t l = 0; l < sweptCount && !found; l++)
+                    found = sweptBlocks[l] == subStepBlocks[k];
+
+                missedCount += !found;
+            }
+        }
+    }
+
+    vectorFree(&subStep);
+    vectorFree(&swept);
+
+    return missedCount;
+}
+
+int main(void)
+{
+    uint32_t random = 8;
+    SweptBenchmarkFrame* frames = checkedMalloc(sizeof(SweptBenchmarkFrame) * SWEPT_BENCHMARK_FRAME_COUNT);
+    size_t missedCount = 0;
+
+    printf("grid       blocks  speed   substeps us   swept us   speedup    calls");
+    printf("   substeps found   swept found\n");
+
+    for (size_t i = 0; i < arrLength(gridSizes); i++)
+    {
+        size_t blockCount;
+        Block* blocks = testCreateGridBlocks(gridSizes[i][0], gridSizes[i][1], 70, &random, &blockCount);
+        QuadTree quadTree = quadTreeBuild(boardBounds, blocks, blockCount, 1);
+
+        for (size_t j = 0; j < arrLength(speedFactors); j++)
+        {
+            float distance = BALL_LAUNCH_SPEED * speedFactors[j] * SWEPT_BENCHMARK_FRAME_TIME;
+
+            for (size_t k = 0; k < SWEPT_BENCHMARK_FRAME_COUNT; k++)
+            {
+                float angle = testRandomFloat(&random, 0.0f, (float)(2.0 * MATH_PI));
+
+                frames[k].start = (Vec2){
+                    .x = testRandomFloat(&random, BALL_RADIUS, (float)COORDINATE_SPACE - BALL_RADIUS),
+                    .y = testRandomFloat(&random, BALL_RADIUS, (float)COORDINATE_SPACE - BALL_RADIUS),
+                };
+                frames[k].end = (Vec2){
+                    .x = frames[k].start.x + cosf(angle) * distance,
+                    .y = frames[k].start.y + sinf(angle) * distance,
+                };
+            }
+
+            size_t subStepFound;
+            size_t sweptFound;
+            double subStepMicroseconds = measureFrames(&quadTree, frames, false, &subStepFound);
+            double sweptMicroseconds = measureFrames(&quadTree, frames, true, &sweptFound);
+            missedCount += countMissedBlocks(&quadTree, frames);
+
+            // the calls and the found blocks are counted over a whole frame
+            printf("%4zux%-4zu %7zu %5.0fx %13.3f %10.3f %8.1fx %3d -> 1 %16.1f %13.1f\n", gridSizes[i][0],
+                gridSizes[i][1], blockCount, (double)speedFactors[j], subStepMicroseconds, sweptMicroseconds,
+                subStepMicroseconds / sweptMicroseconds, SWEPT_BENCHMARK_SUB_STEPS,
+                (double)subStepFound / SWEPT_BENCHMARK_FRAME_COUNT,
+                (double)sweptFound / SWEPT_BENCHMARK_FRAME_COUNT);
+        }
+
+        quadTreeFree(&quadTree);
+        free(blocks);
+    }
+
+    printf("%zu overlapped blocks missed by the swept queries\n", missedCount);
+    free(frames);
+
+    return missedCount == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
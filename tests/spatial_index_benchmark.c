@@ -0,0 +1,126 @@
+// Measures building every spatial index backend and querying it with squares about the size of the area a ball
+// can reach in a frame. The levels are grids of a few sizes with seven in ten cells holding a block, laid out like
+// the levels loaded by the board, so that the grid can map the queries straight to its cells.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "spatial_index.h"
+#include "test_utils.h"
+
+#define INDEX_BENCHMARK_MIN_SECONDS 0.2
+#define INDEX_BENCHMARK_QUERY_COUNT 1000
+#define INDEX_BENCHMARK_QUERY_SIZE 50.0f
+
+static const RectBounds boardBounds = {
+    .topLeft = { .x = 0.0f, .y = (float)COORDINATE_SPACE },
+    .bottomRight = { .x = (float)COORDINATE_SPACE, .y = 0.0f },
+};
+
+static const size_t gridSizes[][2] = { { 10, 20 }, { 40, 40 }, { 100, 100 }, { 300, 300 } };
+
+static const struct
+{
+    SpatialIndexType type;
+    const char* name;
+} indexTypes[] = {
+    { SPATIAL_INDEX_QUAD_TREE, "quad tree" },
+    { SPATIAL_INDEX_LINEAR_QUAD_TREE, "linear quad tree" },
+    { SPATIAL_INDEX_GRID, "grid" },
+    { SPATIAL_INDEX_BVH, "bvh" },
+    { SPATIAL_INDEX_LOOSE_QUAD_TREE, "loose quad tree" },
+};
+
+static double getSeconds(clock_t start) { return (double)(clock() - start) / (double)CLOCKS_PER_SEC; }
+
+static double measureBuild(const SpatialIndexDesc* desc, const Block* blocks, size_t blockCount)
+{
+    size_t buildCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        SpatialIndex index = spatialIndexCreate(desc, blocks, blockCount);
+        spatialIndexFree(&index);
+        buildCount++;
+    } while (getSeconds(start) < INDEX_BENCHMARK_MIN_SECONDS);
+
+    return getSeconds(start) / (double)buildCount * 1e6;
+}
+
+// every backend runs the same queries, the found column tells how close each of them gets to the blocks which the
+// queries overlap, since the quad trees return all the blocks of the leaves they reach and the grid of the cells
+static double measureQueries(SpatialIndex* index, const RectBounds* queries, size_t* foundCount)
+{
+    Vector result = vectorCreate();
+    size_t roundCount = 0;
+    clock_t start = clock();
+
+    do
+    {
+        *foundCount = 0;
+
+        for (size_t i = 0; i < INDEX_BENCHMARK_QUERY_COUNT; i++)
+        {
+            vectorClear(&result);
+            spatialIndexRetrieveAllByBounds(index, queries[i], &result);
+            *foundCount += vectorSize(&result, sizeof(const Block*));
+        }
+
+        roundCount++;
+    } while (getSeconds(start) < INDEX_BENCHMARK_MIN_SECONDS);
+
+    vectorFree(&result);
+    return getSeconds(start) / (double)(roundCount * INDEX_BENCHMARK_QUERY_COUNT) * 1e6;
+}
+
+int main(void)
+{
+    uint32_t random = 4;
+    RectBounds queries[INDEX_BENCHMARK_QUERY_COUNT];
+
+    for (size_t i = 0; i < INDEX_BENCHMARK_QUERY_COUNT; i++)
+    {
+        queries[i] = getBlockRectBounds(&(Block){
+            .position = {
+                .x = testRandomFloat(&random, 0.0f, (float)COORDINATE_SPACE - INDEX_BENCHMARK_QUERY_SIZE),
+                .y = testRandomFloat(&random, INDEX_BENCHMARK_QUERY_SIZE, (float)COORDINATE_SPACE),
+            },
+            .width = INDEX_BENCHMARK_QUERY_SIZE,
+            .height = INDEX_BENCHMARK_QUERY_SIZE,
+        });
+    }
+
+    printf("grid       blocks  index              build us   query us    found\n");
+
+    for (size_t i = 0; i < arrLength(gridSizes); i++)
+    {
+        size_t blockCount;
+        Block* blocks = testCreateGridBlocks(gridSizes[i][0], gridSizes[i][1], 70, &random, &blockCount);
+
+        for (size_t j = 0; j < arrLength(indexTypes); j++)
+        {
+            SpatialIndexDesc desc = {
+                .type = indexTypes[j].type,
+                .bounds = boardBounds,
+                .gridColCount = gridSizes[i][0],
+                .gridRowCount = gridSizes[i][1],
+            };
+
+            SpatialIndex index = spatialIndexCreate(&desc, blocks, blockCount);
+            size_t foundCount;
+            double queryMicroseconds = measureQueries(&index, queries, &foundCount);
+            spatialIndexFree(&index);
+
+            printf("%4zux%-4zu %7zu  %-16s %10.1f %10.3f %8.1f\n", gridSizes[i][0], gridSizes[i][1], blockCount,
+                indexTypes[j].name, measureBuild(&desc, blocks, blockCount), queryMicroseconds,
+                (double)foundCount / INDEX_BENCHMARK_QUERY_COUNT);
+        }
+
+        free(blocks);
+    }
+
+    return EXIT_SUCCESS;
+}
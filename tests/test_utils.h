@@ -0,0 +1,103 @@
+/// @file test_utils.h
+/// @brief Helpers shared by the tests and the benchmarks of the simulation.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "entities.h"
+#include "memory.h"
+
+/// @brief Checks a condition and reports it along with its location if it doesn't hold. The test goes on, so
+/// that a single run shows every failed check.
+/// @param condition The checked condition.
+/// @param failures Pointer to the counter of failed checks.
+#define TEST_CHECK(condition, failures)                                                                          \
+    do                                                                                                           \
+    {                                                                                                            \
+        if (!(condition))                                                                                        \
+        {                                                                                                        \
+            (*(failures))++;                                                                                     \
+            fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);                        \
+        }                                                                                                        \
+    } while (0)
+
+/// @brief Returns the next number of a pseudo-random sequence. Every test owns its sequences, so its results
+/// don't depend on the platform or on the threads which run it.
+/// @param state Pointer to the state of the sequence, which can be seeded with any value.
+/// @return Pseudo-random number in the range [0, 2^24).
+static inline uint32_t testRandom(uint32_t* state)
+{
+    *state = *state * 1664525u + 1013904223u;
+    return *state >> 8;
+}
+
+/// @brief Returns a pseudo-random float.
+/// @param state Pointer to the state of the sequence.
+/// @param min Smallest value.
+/// @param max Largest value.
+/// @return Pseudo-random float in the range [min, max].
+static inline float testRandomFloat(uint32_t* state, float min, float max)
+{
+    return min + (max - min) * (float)testRandom(state) / (float)((1u << 24) - 1);
+}
+
+/// @brief Returns a block of a pseudo-random size placed at a pseudo-random position.
+/// @param state Pointer to the state of the sequence.
+/// @param bounds The area which the block lies in.
+/// @param minSize Smallest width and height of the block.
+/// @param maxSize Largest width and height of the block.
+/// @return Created block.
+static inline Block testRandomBlock(uint32_t* state, RectBounds bounds, float minSize, float maxSize)
+{
+    float width = testRandomFloat(state, minSize, maxSize);
+    float height = testRandomFloat(state, minSize, maxSize);
+
+    return (Block) {
+        .position = {
+            .x = testRandomFloat(state, bounds.topLeft.x, bounds.bottomRight.x - width),
+            .y = testRandomFloat(state, bounds.bottomRight.y + height, bounds.topLeft.y),
+        },
+        .width = width,
+        .height = height,
+    };
+}
+
+/// @brief Creates the blocks of a level grid of the given size, laid out like the levels loaded by the board,
+/// with every cell holding a block with the given chance.
+/// @param colCount Number of columns of the grid.
+/// @param rowCount Number of rows of the grid.
+/// @param fillPercent Chance of a cell holding a block, in percent.
+/// @param state Pointer to the state of the sequence.
+/// @param blockCount Pointer to the number of created blocks.
+/// @return Array of the created blocks, to be freed by the caller.
+static inline Block* testCreateGridBlocks(size_t colCount, size_t rowCount, uint32_t fillPercent, uint32_t* state,
+    size_t* blockCount)
+{
+    Block* blocks = checkedMalloc(sizeof(Block) * colCount * rowCount);
+    float cellWidth = (float)COORDINATE_SPACE / (float)colCount;
+    float cellHeight = (float)COORDINATE_SPACE / (float)rowCount;
+    float padding = min(BLOCK_HORIZONTAL_PADDING, cellWidth / 10.0f);
+    *blockCount = 0;
+
+    for (size_t row = 0; row < rowCount; row++)
+    {
+        for (size_t col = 0; col < colCount; col++)
+        {
+            if (testRandom(state) % 100 >= fillPercent)
+                continue;
+
+            blocks[(*blockCount)++] = (Block) {
+                .position = {
+                    .x = (float)col * cellWidth + padding,
+                    .y = (float)(rowCount - row) * cellHeight - padding,
+                },
+                .width = cellWidth - padding * 2.0f,
+                .height = cellHeight - padding * 2.0f,
+            };
+        }
+    }
+
+    return blocks;
+}
@@ -0,0 +1,168 @@
+# Tests and benchmarks of the simulation. They're built straight from the sources they cover, with the same
+# warnings and options as the game, and they don't open a window, so they link neither GLFW nor OpenGL. This file
+# is included from the top-level CMakeLists.txt rather than added as a subdirectory, so that the levels embedded
+# by board.c are found relative to the same build directory as for the game.
+
+set(ARKANOID_TEST_INCLUDE_DIRECTORIES
+    src
+    tests
+    dependencies/GLAD/include
+    dependencies/GLFW/include
+    dependencies/INCBIN/include
+)
+
+# the quad tree options are read from the variables in scope, so a caller can build a target with other values
+function(add_arkanoid_test_executable name)
+    add_executable(${name} ${ARGN})
+    target_include_directories(${name} PRIVATE ${ARKANOID_TEST_INCLUDE_DIRECTORIES})
+    target_compile_options(${name} PRIVATE $<TARGET_PROPERTY:arkanoid,COMPILE_OPTIONS>)
+    target_compile_definitions(
+        ${name} PRIVATE
+        MAX_QUAD_TREE_NODE_BLOCKS=${QUAD_TREE_NODE_CAPACITY}
+        QUAD_TREE_MAX_DEPTH=${QUAD_TREE_MAX_DEPTH}
+        SIMULATION_TICK_RATE=${SIMULATION_TICK_RATE}
+        NARROWPHASE_THREAD_COUNT=${NARROWPHASE_THREAD_COUNT}
+    )
+    target_link_libraries(${name} Threads::Threads)
+
+    if(UNIX)
+        target_link_libraries(${name} m)
+    endif()
+endfunction()
+
+function(add_arkanoid_test name)
+    add_arkanoid_test_executable(${name} ${ARGN})
+    add_test(NAME ${name} COMMAND ${name})
+endfunction()
+
+add_arkanoid_test(quad_tree_stress_test tests/quad_tree_stress_test.c src/quad_tree.c src/thread.c)
+add_arkanoid_test(quad_tree_query_test tests/quad_tree_query_test.c src/quad_tree.c src/thread.c)
+add_arkanoid_test(quad_tree_batch_test tests/quad_tree_batch_test.c src/quad_tree.c src/thread.c)
+add_arkanoid_test(quad_tree_cast_test tests/quad_tree_cast_test.c src/quad_tree.c src/thread.c)
+add_arkanoid_test(quad_tree_build_test tests/quad_tree_build_test.c src/quad_tree.c src/thread.c)
+add_arkanoid_test(quad_tree_clone_test tests/quad_tree_clone_test.c src/quad_tree.c src/thread.c)
+add_arkanoid_test_executable(
+    quad_tree_nearest_benchmark
+    tests/quad_tree_nearest_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    quad_tree_batch_benchmark
+    tests/quad_tree_batch_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    quad_tree_build_benchmark
+    tests/quad_tree_build_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    quad_tree_pool_benchmark
+    tests/quad_tree_pool_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    quad_tree_dedup_benchmark
+    tests/quad_tree_dedup_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    quad_tree_swept_benchmark
+    tests/quad_tree_swept_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    bounds_soa_benchmark
+    tests/bounds_soa_benchmark.c src/quad_tree.c src/thread.c
+)
+add_arkanoid_test_executable(
+    spatial_index_benchmark
+    tests/spatial_index_benchmark.c
+    src/quad_tree.c
+    src/linear_quad_tree.c
+    src/block_grid.c
+    src/block_bvh.c
+    src/loose_quad_tree.c
+    src/spatial_index.c
+    src/thread.c
+)
+
+# sources needed to simulate a board without a window
+set(ARKANOID_HEADLESS_BOARD_SOURCES
+    src/board.c
+    src/quad_tree.c
+    src/linear_quad_tree.c
+    src/block_grid.c
+    src/block_bvh.c
+    src/loose_quad_tree.c
+    src/spatial_index.c
+    src/thread.c
+    tests/headless_renderer.c
+)
+
+add_arkanoid_test(board_trajectory_test tests/board_trajectory_test.c ${ARKANOID_HEADLESS_BOARD_SOURCES})
+
+# the levels all have a grid, which the board picks unless the index is forced, so the trajectories are also
+# checked with every index forced, and the quad tree build keeps and reports its stats like LOG_QUAD_TREE_STATS and
+# QUAD_TREE_STATS_CSV do, so that removals collapse its nodes and the stats are written on the way
+set(ARKANOID_TEST_STATS_CSV ${CMAKE_CURRENT_BINARY_DIR}/board_trajectory_test_quad_tree_stats.csv)
+
+foreach(index QUAD_TREE LINEAR_QUAD_TREE GRID BVH LOOSE_QUAD_TREE)
+    string(TOLOWER ${index} suffix)
+    set(name board_trajectory_test_${suffix})
+    add_arkanoid_test(${name} tests/board_trajectory_test.c ${ARKANOID_HEADLESS_BOARD_SOURCES})
+    target_compile_definitions(${name} PRIVATE FORCED_SPATIAL_INDEX=SPATIAL_INDEX_${index})
+endforeach()
+
+target_compile_definitions(
+    board_trajectory_test_quad_tree PRIVATE
+    LOG_QUAD_TREE_STATS
+    QUAD_TREE_STATS_CSV="${ARKANOID_TEST_STATS_CSV}"
+    QUAD_TREE_QUERY_STATS
+)
+
+# the stats are appended to the file, so it's removed before every run and has a row for every level afterwards
+add_test(
+    NAME board_trajectory_test_quad_tree_stats_reset
+    COMMAND ${CMAKE_COMMAND} -E rm -f ${ARKANOID_TEST_STATS_CSV}
+)
+add_test(
+    NAME board_trajectory_test_quad_tree_stats_written
+    COMMAND ${CMAKE_COMMAND} -E cat ${ARKANOID_TEST_STATS_CSV}
+)
+set_tests_properties(board_trajectory_test_quad_tree_stats_reset PROPERTIES FIXTURES_SETUP quad_tree_stats_csv)
+set_tests_properties(board_trajectory_test_quad_tree PROPERTIES FIXTURES_REQUIRED quad_tree_stats_csv)
+set_tests_properties(
+    board_trajectory_test_quad_tree_stats_written PROPERTIES
+    FIXTURES_REQUIRED quad_tree_stats_csv
+    DEPENDS board_trajectory_test_quad_tree
+    PASS_REGULAR_EXPRESSION "level5"
+)
+
+# every cast at the cached blocks is checked against the spatial index and the disagreements are counted, the
+# broadphase stats are logged along the way
+add_arkanoid_test(board_cache_test tests/board_cache_test.c ${ARKANOID_HEADLESS_BOARD_SOURCES})
+target_compile_definitions(board_cache_test PRIVATE CHECK_BROADPHASE_CACHE LOG_BROADPHASE_STATS)
+
+add_arkanoid_test(board_prediction_test tests/board_prediction_test.c ${ARKANOID_HEADLESS_BOARD_SOURCES})
+add_arkanoid_test_executable(
+    board_prediction_benchmark
+    tests/board_prediction_benchmark.c ${ARKANOID_HEADLESS_BOARD_SOURCES}
+)
+
+# the capacity and the depth are compiled in, so the benchmark is built once for every pair of them, the builds
+# are only made and run by the quad_tree_sweep target
+set(QUAD_TREE_SWEEP_CAPACITIES 2 5 8 16)
+set(QUAD_TREE_SWEEP_DEPTHS 6 8 10)
+set(QUAD_TREE_SWEEP_COMMANDS "")
+
+function(add_quad_tree_sweep_benchmark capacity depth)
+    set(QUAD_TREE_NODE_CAPACITY ${capacity})
+    set(QUAD_TREE_MAX_DEPTH ${depth})
+    set(name quad_tree_sweep_benchmark_${capacity}_${depth})
+    add_arkanoid_test_executable(${name} tests/quad_tree_sweep_benchmark.c ${ARKANOID_HEADLESS_BOARD_SOURCES})
+    set_target_properties(${name} PROPERTIES EXCLUDE_FROM_ALL ON)
+    set(QUAD_TREE_SWEEP_COMMANDS ${QUAD_TREE_SWEEP_COMMANDS} COMMAND ${name} PARENT_SCOPE)
+endfunction()
+
+foreach(capacity ${QUAD_TREE_SWEEP_CAPACITIES})
+    foreach(depth ${QUAD_TREE_SWEEP_DEPTHS})
+        add_quad_tree_sweep_benchmark(${capacity} ${depth})
+    endforeach()
+endforeach()
+
+add_custom_target(quad_tree_sweep ${QUAD_TREE_SWEEP_COMMANDS} USES_TERMINAL)